@@ -0,0 +1,135 @@
+#include <random>
+#include <vector>
+
+#include "batch.h"
+#include "bench.h"
+#include "lod.h"
+
+// Large enough that the kernels are split across threads, like a scene-sized batch would be.
+constexpr size_t ITEMS = 1 << 18;
+
+void benchBatch(Bench& bench)
+{
+    std::mt19937 rng{7};
+    std::uniform_real_distribution<float> dist{-50.0f, 50.0f};
+
+    std::vector<float> xs(ITEMS), ys(ITEMS), zs(ITEMS);
+    std::vector<vec3> interleaved(ITEMS);
+    for (size_t i = 0; i < ITEMS; i++)
+    {
+        xs[i] = dist(rng);
+        ys[i] = dist(rng);
+        zs[i] = dist(rng);
+        interleaved[i] = vec3{xs[i], ys[i], zs[i]};
+    }
+    std::vector<float> outXs(ITEMS), outYs(ITEMS), outZs(ITEMS);
+    std::vector<vec3> outInterleaved(ITEMS);
+
+    auto model = translate(mat4{1.0f}, vec3{1, 2, 3});
+    model = rotate(model, 0.7f, vec3{1, 1, 0});
+    model = scale(model, vec3{1, 2, 3});
+    const auto normal = normalMatrix(model);
+
+    bench.Run("transformPoints", ITEMS, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            transformPoints(model, xs.data(), ys.data(), zs.data(), outXs.data(), outYs.data(), outZs.data(), ITEMS);
+            doNotOptimize(outXs[0]);
+        }
+    });
+
+    bench.Run("transformNormals", ITEMS, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            transformNormals(normal, xs.data(), ys.data(), zs.data(), outXs.data(), outYs.data(), outZs.data(), ITEMS);
+            doNotOptimize(outXs[0]);
+        }
+    });
+
+    bench.Run("transformPoints/interleaved", ITEMS, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            transformPoints(model, interleaved.data(), outInterleaved.data(), sizeof(vec3), ITEMS);
+            doNotOptimize(outInterleaved[0]);
+        }
+    });
+
+    std::vector<mat4> models(ITEMS / 16);
+    for (auto& m : models)
+    {
+        m = rotate(translate(mat4{1.0f}, vec3{dist(rng), dist(rng), dist(rng)}), dist(rng), vec3{0, 1, 0});
+    }
+    std::vector<mat3> normals(models.size());
+
+    bench.Run("normalMatrices", models.size(), [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            normalMatrices(models.data(), models.size(), normals.data());
+            doNotOptimize(normals[0]);
+        }
+    });
+
+    const auto frustum = Frustum::fromMatrix(perspective(radians(60.0f), 1.5f, 0.1f, 100.0f) *
+                                             lookAt(vec3{0, 0, 60}, vec3{0, 0, 0}, vec3{0, 1, 0}));
+
+    std::vector<AABB> boxes(ITEMS);
+    std::vector<Sphere> spheres(ITEMS);
+    for (size_t i = 0; i < ITEMS; i++)
+    {
+        boxes[i] = AABB{interleaved[i] - vec3{0.5f}, interleaved[i] + vec3{0.5f}};
+        spheres[i] = Sphere{interleaved[i], 0.87f};
+    }
+    std::vector<uint8_t> visible(ITEMS);
+
+    bench.Run("cull/AABB", ITEMS, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            cull(frustum, boxes.data(), ITEMS, visible.data());
+            doNotOptimize(visible[0]);
+        }
+    });
+
+    bench.Run("cull/Sphere", ITEMS, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            cull(frustum, spheres.data(), ITEMS, visible.data());
+            doNotOptimize(visible[0]);
+        }
+    });
+
+    // The SIMD paths must agree with Frustum::intersects(), the odd count leaves a remainder for the scalar loop.
+    bench.Check("cull matches Frustum::intersects", [&] {
+        const size_t count = ITEMS - 3;
+        std::vector<uint8_t> boxVisible(count), sphereVisible(count);
+        cull(frustum, boxes.data(), count, boxVisible.data());
+        cull(frustum, spheres.data(), count, sphereVisible.data());
+        for (size_t i = 0; i < count; i++)
+        {
+            if (boxVisible[i] != frustum.intersects(boxes[i]) || sphereVisible[i] != frustum.intersects(spheres[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    });
+
+    LODSelector lods;
+    lods.SetView(vec3{0, 0, 60}, perspective(radians(60.0f), 1.5f, 0.1f, 100.0f), 800.0f);
+    std::vector<uint8_t> levels(ITEMS);
+
+    bench.Run("LODSelector::Select", ITEMS, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            lods.Select(spheres.data(), ITEMS, 4, levels.data());
+            doNotOptimize(levels[0]);
+        }
+    });
+
+    bench.Run("LODSelector::Bucket", ITEMS, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            lods.Bucket(levels.data(), visible.data(), ITEMS, 4);
+            doNotOptimize(lods.GetCount(0));
+        }
+    });
+}
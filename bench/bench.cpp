@@ -0,0 +1,227 @@
+#include "bench.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+// Usage: geometry-shapes-bench [--filter <text>] [--min-time <ms>] [--out <file>] [--baseline <file>]
+//                              [--threshold <percent>]
+//
+// Results are written as JSON to --out, or to stdout when it is not given. With --baseline, every benchmark is
+// compared with the same name in a previous JSON file and the process exits with 1 if any of them got slower by
+// more than --threshold percent (10 by default). The exit code is also 1 when a check fails.
+
+static const char* simdBackend()
+{
+#if defined(MATH_SIMD_AVX2)
+    return "AVX2";
+#elif defined(MATH_SIMD_SSE41)
+    return "SSE4.1";
+#else
+    return "OFF";
+#endif
+}
+
+static bool optimized()
+{
+#if defined(__OPTIMIZE__) || defined(NDEBUG)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Bench::report(const BenchResult& result)
+{
+    std::fprintf(stderr, "%-40s %12.3f ns/op %16.0f ops/s\n", result.name.c_str(), result.nsPerOp, result.opsPerSec);
+}
+
+void Bench::reportCheck(const std::string& name, const bool passed)
+{
+    std::fprintf(stderr, "%-40s %s\n", name.c_str(), passed ? "ok" : "FAILED");
+}
+
+static void writeJson(std::ostream& os, const std::vector<BenchResult>& results)
+{
+    os << "{\n";
+    os << "  \"simd\": \"" << simdBackend() << "\",\n";
+#if defined(MATH_FAST_TRIG)
+    os << "  \"fast_trig\": true,\n";
+#else
+    os << "  \"fast_trig\": false,\n";
+#endif
+    os << "  \"optimized\": " << (optimized() ? "true" : "false") << ",\n";
+    os << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const auto& r = results[i];
+        os << "    {\"name\": \"" << r.name << "\", \"ns_per_op\": " << r.nsPerOp
+           << ", \"ops_per_sec\": " << r.opsPerSec << ", \"ops\": " << r.ops << "}"
+           << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n";
+    os << "}\n";
+}
+
+// Reads the name -> ns_per_op pairs back from a file written by writeJson(). Only that layout is understood.
+static bool readBaseline(const std::string& path, std::unordered_map<std::string, double>& baseline)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        return false;
+    }
+
+    std::stringstream ss;
+    ss << file.rdbuf();
+    const auto json = ss.str();
+
+    const std::string nameKey = "\"name\": \"";
+    const std::string nsKey = "\"ns_per_op\": ";
+
+    for (size_t pos = json.find(nameKey); pos != std::string::npos; pos = json.find(nameKey, pos))
+    {
+        pos += nameKey.size();
+        const auto nameEnd = json.find('"', pos);
+        const auto ns = json.find(nsKey, nameEnd);
+        if (nameEnd == std::string::npos || ns == std::string::npos)
+        {
+            return false;
+        }
+
+        baseline[json.substr(pos, nameEnd - pos)] = std::strtod(json.c_str() + ns + nsKey.size(), nullptr);
+        pos = ns;
+    }
+    return true;
+}
+
+// Returns the number of benchmarks slower than the baseline by more than threshold percent.
+static int compare(const std::vector<BenchResult>& results, const std::unordered_map<std::string, double>& baseline,
+                   const double threshold)
+{
+    int regressions = 0;
+
+    std::fprintf(stderr, "\n%-40s %12s %12s %9s\n", "benchmark", "baseline", "current", "change");
+    for (const auto& r : results)
+    {
+        const auto it = baseline.find(r.name);
+        if (it == baseline.end() || it->second <= 0.0)
+        {
+            std::fprintf(stderr, "%-40s %12s %12.3f %9s\n", r.name.c_str(), "-", r.nsPerOp, "new");
+            continue;
+        }
+
+        const auto change = (r.nsPerOp - it->second) / it->second * 100.0;
+        const bool regressed = change > threshold;
+        regressions += regressed;
+
+        std::fprintf(stderr, "%-40s %12.3f %12.3f %+8.1f%%%s\n", r.name.c_str(), it->second, r.nsPerOp, change,
+                     regressed ? "  REGRESSION" : "");
+    }
+    return regressions;
+}
+
+int main(int argc, char** argv)
+{
+    std::string filter;
+    std::string outPath;
+    std::string baselinePath;
+    double threshold = 10.0;
+    double minTime = 20.0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const auto value = [&]() -> const char* {
+            if (i + 1 >= argc)
+            {
+                std::fprintf(stderr, "Missing value for %s\n", argv[i]);
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (std::strcmp(argv[i], "--filter") == 0)
+        {
+            filter = value();
+        }
+        else if (std::strcmp(argv[i], "--min-time") == 0)
+        {
+            minTime = std::atof(value());
+        }
+        else if (std::strcmp(argv[i], "--out") == 0)
+        {
+            outPath = value();
+        }
+        else if (std::strcmp(argv[i], "--baseline") == 0)
+        {
+            baselinePath = value();
+        }
+        else if (std::strcmp(argv[i], "--threshold") == 0)
+        {
+            threshold = std::atof(value());
+        }
+        else
+        {
+            std::fprintf(stderr,
+                         "Usage: %s [--filter <text>] [--min-time <ms>] [--out <file>] [--baseline <file>] "
+                         "[--threshold <percent>]\n",
+                         argv[0]);
+            return 2;
+        }
+    }
+
+    if (!optimized())
+    {
+        std::fprintf(stderr, "Warning: built without optimizations, configure with CMAKE_BUILD_TYPE=Release\n");
+    }
+
+    Bench bench{filter, minTime / 1000.0};
+    benchMath(bench);
+    benchBatch(bench);
+    benchImport(bench);
+    benchOptimizer(bench);
+    benchVertexFormat(bench);
+    benchSimplifier(bench);
+    benchNormals(bench);
+    benchMeshlet(bench);
+    benchRangeAllocator(bench);
+
+    if (outPath.empty())
+    {
+        writeJson(std::cout, bench.GetResults());
+    }
+    else
+    {
+        std::ofstream out(outPath);
+        writeJson(out, bench.GetResults());
+    }
+
+    if (bench.GetFailures() > 0)
+    {
+        std::fprintf(stderr, "%d check(s) failed\n", bench.GetFailures());
+        return 1;
+    }
+
+    if (!baselinePath.empty())
+    {
+        std::unordered_map<std::string, double> baseline;
+        if (!readBaseline(baselinePath, baseline))
+        {
+            std::fprintf(stderr, "Failed to read baseline %s\n", baselinePath.c_str());
+            return 2;
+        }
+
+        const auto regressions = compare(bench.GetResults(), baseline, threshold);
+        if (regressions > 0)
+        {
+            std::fprintf(stderr, "%d benchmark(s) regressed by more than %.1f%%\n", regressions, threshold);
+            return 1;
+        }
+    }
+
+    return 0;
+}
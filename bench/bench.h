@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/////////////////////////// Bench ///////////////////////////////
+// Minimal microbenchmark harness. A benchmark body receives an iteration count and performs opsPerIteration
+// operations per iteration, the harness scales the count until one sample takes at least minSampleTime and
+// reports the median of several samples. Checks guard the properties the benchmarked code promises; a failed check
+// makes the run exit with 1.
+
+struct BenchResult
+{
+    std::string name;
+    double nsPerOp;
+    double opsPerSec;
+    size_t ops;
+};
+
+// Keeps the optimizer from dropping a computation whose result is otherwise unused.
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    const volatile char sink = *reinterpret_cast<const volatile char*>(&value);
+    (void)sink;
+#endif
+}
+
+class Bench
+{
+   public:
+    Bench(const std::string& filter, const double minSampleTime) : filter(filter), minSampleTime(minSampleTime) {}
+
+    template <typename Fn>
+    void Run(const std::string& name, const size_t opsPerIteration, Fn&& fn);
+
+    // fn returns true when the property holds. Filtered like Run().
+    template <typename Fn>
+    void Check(const std::string& name, Fn&& fn);
+
+    const std::vector<BenchResult>& GetResults() const { return results; }
+    int GetFailures() const { return failures; }
+
+   private:
+    static constexpr int SAMPLES = 7;
+
+    std::string filter;
+    double minSampleTime;
+    std::vector<BenchResult> results;
+    int failures = 0;
+
+    void report(const BenchResult& result);
+    void reportCheck(const std::string& name, const bool passed);
+};
+
+template <typename Fn>
+void Bench::Run(const std::string& name, const size_t opsPerIteration, Fn&& fn)
+{
+    if (!filter.empty() && name.find(filter) == std::string::npos)
+    {
+        return;
+    }
+
+    using clock = std::chrono::steady_clock;
+
+    const auto time = [&fn](const size_t iterations) {
+        const auto start = clock::now();
+        fn(iterations);
+        return std::chrono::duration<double>(clock::now() - start).count();
+    };
+
+    // Warm up caches and find an iteration count that makes a sample long enough for the clock resolution.
+    size_t iterations = 1;
+    for (double elapsed = time(iterations); elapsed < minSampleTime; elapsed = time(iterations))
+    {
+        const auto scaled = elapsed > 0.0 ? static_cast<size_t>(iterations * 1.2 * minSampleTime / elapsed) : 0;
+        iterations = std::max(iterations * 2, scaled);
+    }
+
+    double samples[SAMPLES];
+    for (auto& sample : samples)
+    {
+        sample = time(iterations) / static_cast<double>(iterations * opsPerIteration);
+    }
+    std::nth_element(samples, samples + SAMPLES / 2, samples + SAMPLES);
+
+    const auto secondsPerOp = samples[SAMPLES / 2];
+    results.push_back(BenchResult{name, secondsPerOp * 1e9, 1.0 / secondsPerOp, iterations * opsPerIteration});
+    report(results.back());
+}
+
+template <typename Fn>
+void Bench::Check(const std::string& name, Fn&& fn)
+{
+    if (!filter.empty() && name.find(filter) == std::string::npos)
+    {
+        return;
+    }
+
+    const bool passed = fn();
+    failures += !passed;
+    reportCheck(name, passed);
+}
+
+// Benchmark suites, one per source file.
+void benchMath(Bench& bench);
+void benchBatch(Bench& bench);
+void benchImport(Bench& bench);
+void benchOptimizer(Bench& bench);
+void benchVertexFormat(Bench& bench);
+void benchSimplifier(Bench& bench);
+void benchNormals(Bench& bench);
+void benchMeshlet(Bench& bench);
+void benchRangeAllocator(Bench& bench);
+////////////////////////////////////////////////////////////////
@@ -0,0 +1,114 @@
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "bench.h"
+#include "generators.h"
+#include "importer.h"
+
+// Ops are bytes, so ns/op is the inverse of the parse throughput (1 ns/op is 1000 MB/s).
+
+static std::string objText(const Mesh& mesh)
+{
+    std::string text;
+    char line[128];
+    for (const auto& v : mesh.Vertices)
+    {
+        std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", v.Position.x, v.Position.y, v.Position.z);
+        text += line;
+    }
+    for (const auto& v : mesh.Vertices)
+    {
+        std::snprintf(line, sizeof(line), "vn %.6f %.6f %.6f\n", v.Normal.x, v.Normal.y, v.Normal.z);
+        text += line;
+    }
+    for (size_t i = 0; i < mesh.Indices.size(); i += 3)
+    {
+        const auto a = mesh.Indices[i] + 1, b = mesh.Indices[i + 1] + 1, c = mesh.Indices[i + 2] + 1;
+        std::snprintf(line, sizeof(line), "f %u//%u %u//%u %u//%u\n", a, a, b, b, c, c);
+        text += line;
+    }
+    return text;
+}
+
+static std::string plyBinary(const Mesh& mesh)
+{
+    std::string data = "ply\nformat binary_little_endian 1.0\nelement vertex " + std::to_string(mesh.Vertices.size()) +
+                       "\nproperty float x\nproperty float y\nproperty float z\n"
+                       "property float nx\nproperty float ny\nproperty float nz\n"
+                       "element face " + std::to_string(mesh.Indices.size() / 3) +
+                       "\nproperty list uchar int vertex_indices\nend_header\n";
+    data.append(reinterpret_cast<const char*>(mesh.Vertices.data()), mesh.Vertices.size() * sizeof(Vertex));
+    for (size_t i = 0; i < mesh.Indices.size(); i += 3)
+    {
+        data.push_back(3);
+        data.append(reinterpret_cast<const char*>(&mesh.Indices[i]), 3 * sizeof(unsigned int));
+    }
+    return data;
+}
+
+static std::string stlBinary(const Mesh& mesh)
+{
+    std::string data(80, ' ');
+    const auto triangles = static_cast<uint32_t>(mesh.Indices.size() / 3);
+    data.append(reinterpret_cast<const char*>(&triangles), sizeof(triangles));
+    for (size_t i = 0; i < mesh.Indices.size(); i += 3)
+    {
+        const vec3 normal{0.0f};
+        data.append(reinterpret_cast<const char*>(&normal), sizeof(normal));
+        for (size_t k = 0; k < 3; k++)
+        {
+            data.append(reinterpret_cast<const char*>(&mesh.Vertices[mesh.Indices[i + k]].Position), sizeof(vec3));
+        }
+        data.append(2, '\0');
+    }
+    return data;
+}
+
+void benchImport(Bench& bench)
+{
+    // About 130k triangles, large enough to be split into chunks.
+    const auto source = generateMesh(ParametricShape{Primitive::TORUS, 0.4f}, 6);
+    const auto obj = objText(source);
+    const auto ply = plyBinary(source);
+
+    Mesh mesh;
+    std::string error;
+
+    bench.Run("importObj", obj.size(), [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            importObj(obj.data(), obj.size(), mesh, error);
+            doNotOptimize(mesh.Indices[0]);
+        }
+    });
+
+    bench.Run("importPly/binary", ply.size(), [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            importPly(ply.data(), ply.size(), mesh, error);
+            doNotOptimize(mesh.Indices[0]);
+        }
+    });
+
+    // Header counts far beyond what the body holds are errors, not allocations: ASCII vertices, and binary faces that
+    // don't take the triangle fast path because the first record is a quad.
+    bench.Check("importPly rejects oversized counts", [&] {
+        const std::string ascii =
+            "ply\nformat ascii 1.0\nelement vertex 100000000000\nproperty float x\nproperty float y\n"
+            "property float z\nend_header\n0 0 0\n";
+        auto binary = plyBinary(Mesh{{Vertex{}, Vertex{}, Vertex{}, Vertex{}}, {}});
+        binary.replace(binary.find("element face 0"), 14, "element face 4000000000000");
+        const unsigned int quad[] = {0, 1, 2, 3};
+        binary.push_back(4);
+        binary.append(reinterpret_cast<const char*>(quad), sizeof(quad));
+        return !importPly(ascii.data(), ascii.size(), mesh, error) &&
+               !importPly(binary.data(), binary.size(), mesh, error);
+    });
+
+    // A soup has three vertices per triangle; welded, a closed smooth surface has about half a vertex per triangle.
+    bench.Check("importStl welds facets", [&] {
+        const auto stl = stlBinary(generateMesh(ParametricShape{Primitive::SPHERE}, 3));
+        return importStl(stl.data(), stl.size(), mesh, error) && mesh.Vertices.size() < mesh.Indices.size() / 3;
+    });
+}
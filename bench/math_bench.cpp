@@ -0,0 +1,180 @@
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "math.h"
+
+// Inputs cycle through this many values, small enough to stay in L1 so the numbers measure the math, not memory.
+constexpr size_t COUNT = 256;
+
+static std::mt19937 rng{42};
+
+static float uniform(const float min, const float max) { return std::uniform_real_distribution<float>{min, max}(rng); }
+
+static vec3 randomVec3() { return vec3{uniform(-10, 10), uniform(-10, 10), uniform(-10, 10)}; }
+
+// Random rotation, scale and translation, so the matrices are invertible and look like real model matrices.
+static mat4 randomModel()
+{
+    auto m = translate(mat4{1.0f}, randomVec3());
+    m = rotate(m, uniform(-PI, PI), randomVec3());
+    return scale(m, vec3{uniform(0.5f, 2), uniform(0.5f, 2), uniform(0.5f, 2)});
+}
+
+template <typename T, typename Gen>
+static std::vector<T> generate(Gen&& gen)
+{
+    std::vector<T> v(COUNT);
+    for (auto& x : v)
+    {
+        x = gen();
+    }
+    return v;
+}
+
+void benchMath(Bench& bench)
+{
+    const auto mats = generate<mat4>(randomModel);
+    const auto vecs = generate<vec3>(randomVec3);
+    const auto angles = generate<float>([]() { return uniform(-PI, PI); });
+    const auto quats = generate<quat>([]() { return quat::fromAxisAngle(randomVec3().normalize(), uniform(-PI, PI)); });
+
+    std::vector<mat3> mat3s(COUNT);
+    for (size_t i = 0; i < COUNT; i++)
+    {
+        mat3s[i] = mat3{mats[i]};
+    }
+
+    bench.Run("mat4::operator*", 1, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            doNotOptimize(mats[i % COUNT] * mats[(i + 1) % COUNT]);
+        }
+    });
+
+    bench.Run("mat4::determinant", 1, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            doNotOptimize(mats[i % COUNT].determinant());
+        }
+    });
+
+    bench.Run("mat4::inverse", 1, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            doNotOptimize(mats[i % COUNT].inverse());
+        }
+    });
+
+    bench.Run("mat4::affineInverse", 1, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            doNotOptimize(mats[i % COUNT].affineInverse());
+        }
+    });
+
+    bench.Run("mat3::operator*", 1, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            doNotOptimize(mat3s[i % COUNT] * mat3s[(i + 1) % COUNT]);
+        }
+    });
+
+    bench.Run("mat3::inverse", 1, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            doNotOptimize(mat3s[i % COUNT].inverse());
+        }
+    });
+
+    bench.Run("normalMatrix", 1, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            doNotOptimize(normalMatrix(mats[i % COUNT]));
+        }
+    });
+
+    bench.Run("rotate", 1, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            doNotOptimize(rotate(mats[i % COUNT], angles[i % COUNT], vecs[i % COUNT]));
+        }
+    });
+
+    bench.Run("lookAt", 1, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            doNotOptimize(lookAt(vecs[i % COUNT], vecs[(i + 1) % COUNT], vec3{0, 1, 0}));
+        }
+    });
+
+    bench.Run("perspective", 1, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            doNotOptimize(perspective(angles[i % COUNT] * 0.25f + 1.0f, 1.5f, 0.1f, 100.0f));
+        }
+    });
+
+    bench.Run("sincos", 1, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            float s = 0, c = 0;
+            sincos(angles[i % COUNT], s, c);
+            doNotOptimize(s);
+            doNotOptimize(c);
+        }
+    });
+
+    // The component-wise operators sit on every mesh processing hot path.
+    bench.Run("vec3::operator+", 1, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            doNotOptimize(vecs[i % COUNT] + vecs[(i + 1) % COUNT]);
+        }
+    });
+
+    bench.Run("vec3::operator-", 1, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            doNotOptimize(vecs[i % COUNT] - vecs[(i + 1) % COUNT]);
+        }
+    });
+
+    bench.Run("vec3::operator+=", 1, [&](const size_t n) {
+        vec3 sum{};
+        for (size_t i = 0; i < n; i++)
+        {
+            sum += vecs[i % COUNT];
+        }
+        doNotOptimize(sum);
+    });
+
+    bench.Run("triangle normal", 1, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            const auto& a = vecs[i % COUNT];
+            doNotOptimize((vecs[(i + 1) % COUNT] - a).cross(vecs[(i + 2) % COUNT] - a));
+        }
+    });
+
+    bench.Run("vec3::normalize", 1, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            doNotOptimize(vecs[i % COUNT].normalize());
+        }
+    });
+
+    bench.Run("vec3::cross", 1, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            doNotOptimize(vecs[i % COUNT].cross(vecs[(i + 1) % COUNT]));
+        }
+    });
+
+    bench.Run("quat::toMat3", 1, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            doNotOptimize(quats[i % COUNT].toMat3());
+        }
+    });
+}
@@ -0,0 +1,39 @@
+#include <vector>
+
+#include "bench.h"
+#include "generators.h"
+#include "meshlet.h"
+#include "optimizer.h"
+
+void benchMeshlet(Bench& bench)
+{
+    auto mesh = generateMesh(ParametricShape{Primitive::TORUS, 0.4f}, 5);
+    optimizeMesh(mesh);
+    const size_t triangles = mesh.Indices.size() / 3;
+
+    bench.Run("buildMeshlets", triangles, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            doNotOptimize(
+                buildMeshlets(mesh.Vertices.data(), mesh.Vertices.size(), mesh.Indices.data(), mesh.Indices.size())
+                    .size());
+        }
+    });
+
+    // Per meshlet, the camera looking at the torus from the side as in the demo.
+    const auto meshlets =
+        buildMeshlets(mesh.Vertices.data(), mesh.Vertices.size(), mesh.Indices.data(), mesh.Indices.size());
+    const vec3 eye{0.0f, 1.0f, 5.0f};
+    const auto frustum = Frustum::fromMatrix(perspective(radians(45.0f), 1.5f, 0.1f, 100.0f) *
+                                             lookAt(eye, vec3{0.0f}, vec3{0.0f, 1.0f, 0.0f}));
+    const DrawRange range{0, static_cast<unsigned int>(mesh.Indices.size()), 0, PositionDecode{}};
+    std::vector<DrawRange> visible;
+
+    bench.Run("cullMeshlets", meshlets.size(), [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            visible.clear();
+            doNotOptimize(cullMeshlets(meshlets.data(), meshlets.size(), range, frustum, eye, visible));
+        }
+    });
+}
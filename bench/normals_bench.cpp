@@ -0,0 +1,64 @@
+#include <cmath>
+#include <string>
+#include <utility>
+
+#include "bench.h"
+#include "generators.h"
+#include "normals.h"
+
+void benchNormals(Bench& bench)
+{
+    auto mesh = generateMesh(ParametricShape{Primitive::TORUS, 0.4f}, 5);
+    const size_t triangles = mesh.Indices.size() / 3;
+
+    for (const auto& mode : {std::make_pair("AREA", NormalMode::AREA), std::make_pair("ANGLE", NormalMode::ANGLE)})
+    {
+        bench.Run(std::string{"computeNormals/"} + mode.first, triangles, [&](const size_t n) {
+            for (size_t i = 0; i < n; i++)
+            {
+                computeNormals(mesh.Vertices.data(), mesh.Vertices.size(), mesh.Indices.data(), mesh.Indices.size(),
+                               mode.second);
+                doNotOptimize(mesh.Vertices[0].Normal);
+            }
+        });
+    }
+
+    // Includes welding by position and splitting along creases.
+    bench.Run("generateNormals/ANGLE", triangles, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            doNotOptimize(generateNormals(mesh).Vertices.size());
+        }
+    });
+
+    // Every edge of a box is a 90 degree crease: one vertex per corner and face, or per corner when nothing splits.
+    const auto box = generateMesh(ParametricShape{Primitive::CUBOID}, 0);
+    bench.Check("generateNormals/crease", [&] { return generateNormals(box).Vertices.size() == 24; });
+    bench.Check("generateNormals/no crease", [&] {
+        return generateNormals(box, NormalMode::ANGLE, PI).Vertices.size() == 8;
+    });
+
+    // The shape's pyramid, indexed: the base faces down, away from the apex.
+    Mesh pyramid;
+    for (const auto& p : {vec3{-0.5f, -0.5f, 0.0f}, vec3{0.5f, -0.5f, 0.0f}, vec3{0.5f, 0.5f, 0.0f},
+                          vec3{-0.5f, 0.5f, 0.0f}, vec3{0.0f, 0.0f, 1.0f}})
+    {
+        pyramid.Vertices.push_back(Vertex{p, vec3{0.0f}});
+    }
+    pyramid.Indices = {0, 2, 1, 2, 0, 3, 0, 1, 4, 1, 2, 4, 2, 3, 4, 3, 0, 4};
+    bench.Check("generateNormals/FLAT", [&] {
+        const float side = 1.0f / std::sqrt(5.0f);
+        const vec3 faces[] = {vec3{0.0f, 0.0f, -1.0f}, vec3{0.0f, 0.0f, -1.0f}, vec3{0.0f, -2 * side, side},
+                              vec3{2 * side, 0.0f, side}, vec3{0.0f, 2 * side, side}, vec3{-2 * side, 0.0f, side}};
+        const auto flat = generateNormals(pyramid, NormalMode::FLAT);
+        for (size_t c = 0; c < flat.Indices.size(); c++)
+        {
+            const auto error = flat.Vertices[flat.Indices[c]].Normal - faces[c / 3];
+            if (error.dot(error) > 1e-12f)
+            {
+                return false;
+            }
+        }
+        return flat.Vertices.size() == 16;
+    });
+}
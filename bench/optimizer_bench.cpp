@@ -0,0 +1,57 @@
+#include <algorithm>
+#include <random>
+
+#include "bench.h"
+#include "generators.h"
+#include "optimizer.h"
+
+void benchOptimizer(Bench& bench)
+{
+    // Shuffled triangles, the worst case input for the cache pass.
+    auto mesh = generateMesh(ParametricShape{Primitive::TORUS, 0.4f}, 5);
+    const size_t triangles = mesh.Indices.size() / 3;
+
+    std::vector<size_t> order(triangles);
+    for (size_t t = 0; t < triangles; t++)
+    {
+        order[t] = t;
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937{3});
+
+    std::vector<unsigned int> shuffled;
+    shuffled.reserve(mesh.Indices.size());
+    for (const auto t : order)
+    {
+        shuffled.insert(shuffled.end(), mesh.Indices.begin() + t * 3, mesh.Indices.begin() + t * 3 + 3);
+    }
+
+    std::vector<unsigned int> indices;
+
+    bench.Run("optimizeVertexCache", triangles, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            indices = shuffled;
+            optimizeVertexCache(indices.data(), indices.size(), mesh.Vertices.size());
+            doNotOptimize(indices[0]);
+        }
+    });
+
+    auto cached = shuffled;
+    optimizeVertexCache(cached.data(), cached.size(), mesh.Vertices.size());
+
+    bench.Run("optimizeOverdraw", triangles, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            indices = cached;
+            optimizeOverdraw(indices.data(), indices.size(), mesh.Vertices.data(), mesh.Vertices.size());
+            doNotOptimize(indices[0]);
+        }
+    });
+
+    bench.Run("analyzeVertexCache", triangles, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            doNotOptimize(analyzeVertexCache(cached.data(), cached.size(), mesh.Vertices.size()));
+        }
+    });
+}
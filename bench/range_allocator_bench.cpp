@@ -0,0 +1,81 @@
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "range_allocator.h"
+
+void benchRangeAllocator(Bench& bench)
+{
+    // Mesh sized ranges, a few hundred to a few thousand vertices, with every fourth one much larger.
+    constexpr size_t LIVE = 4096;
+    std::mt19937 rng{42};
+    std::vector<uint32_t> sizes(1 << 16);
+    for (auto& size : sizes)
+    {
+        size = 256 + rng() % 4096 + (rng() % 4 == 0 ? rng() % 65536 : 0);
+    }
+
+    // One free and one allocation per operation at a steady LIVE allocations, as shapes come and go.
+    RangeAllocator allocator{1u << 30};
+    std::vector<ArenaHandle> live(LIVE);
+    for (size_t i = 0; i < LIVE; i++)
+    {
+        live[i] = allocator.Allocate(sizes[i]);
+    }
+    size_t next = 0;
+    bench.Run("RangeAllocator churn", 1, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            const size_t slot = sizes[next % sizes.size()] % LIVE;
+            allocator.Free(live[slot]);
+            live[slot] = allocator.Allocate(sizes[next++ % sizes.size()]);
+        }
+        doNotOptimize(live.data());
+    });
+
+    // Per allocation: half of them freed at random, then packed.
+    std::vector<ArenaMove> moves;
+    bench.Run("RangeAllocator::Defragment", LIVE, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            RangeAllocator fragmented{1u << 30};
+            for (size_t a = 0; a < LIVE; a++)
+            {
+                live[a] = fragmented.Allocate(sizes[a]);
+            }
+            for (size_t a = 0; a < LIVE; a += 1 + sizes[a] % 3)
+            {
+                fragmented.Free(live[a]);
+            }
+            moves.clear();
+            fragmented.Defragment(moves);
+            doNotOptimize(moves.size());
+        }
+    });
+
+    // Requests the first growth of an arena can't cover by doubling, which TLSF rounds up past the exact size.
+    const auto growAndAllocate = [](RangeAllocator& arena, const uint32_t size) {
+        ArenaHandle handle = arena.Allocate(size);
+        if (handle == ARENA_NONE)
+        {
+            arena.Grow(arenaGrowCapacity(arena.GetCapacity(), size, 1 << 12));
+            handle = arena.Allocate(size);
+        }
+        return handle != ARENA_NONE && arena.GetOffset(handle) + size <= arena.GetCapacity();
+    };
+    bench.Check("RangeAllocator grow fits 5000", [&] {
+        RangeAllocator arena;
+        return growAndAllocate(arena, 5000);
+    });
+    bench.Check("RangeAllocator grow fits 100000", [&] {
+        RangeAllocator arena;
+        return growAndAllocate(arena, 100000);
+    });
+    bench.Check("RangeAllocator grow full arena fits 5000", [&] {
+        RangeAllocator arena{1 << 12};
+        while (arena.Allocate(8) != ARENA_NONE)
+        {
+        }
+        return arena.GetStats().Used == arena.GetCapacity() && growAndAllocate(arena, 5000);
+    });
+}
@@ -0,0 +1,63 @@
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "generators.h"
+#include "optimizer.h"
+#include "simplifier.h"
+
+void benchSimplifier(Bench& bench)
+{
+    const auto mesh = generateMesh(ParametricShape{Primitive::TORUS, 0.4f}, 4);
+    const size_t triangles = mesh.Indices.size() / 3;
+    std::vector<unsigned int> indices(mesh.Indices.size());
+
+    // Per source triangle, down to a quarter like one LOD level.
+    bench.Run("simplifyMesh/quarter", triangles, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            doNotOptimize(simplifyMesh(mesh.Indices.data(), mesh.Indices.size(), mesh.Vertices.data(),
+                                       mesh.Vertices.size(), mesh.Indices.size() / 4, 1.0f, indices.data()));
+        }
+    });
+
+    // Flat faces where every collapse costs nothing.
+    const auto box = generateMesh(ParametricShape{Primitive::CUBOID}, 4);
+    bench.Run("simplifyMesh/flat", box.Indices.size() / 3, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            doNotOptimize(simplifyMesh(box.Indices.data(), box.Indices.size(), box.Vertices.data(),
+                                       box.Vertices.size(), 0, 1.0f, indices.data()));
+        }
+    });
+
+    bench.Run("LodChain/mesh", triangles, [&](const size_t n) {
+        for (size_t i = 0; i < n; i++)
+        {
+            const LodChain lods{mesh, 4};
+            doNotOptimize(lods.GetLevel(lods.GetLevelCount() - 1).IndexCount);
+        }
+    });
+
+    // Collapses along the flat faces must not leave collinear triangles behind.
+    for (const int tessellation : {4, 5})
+    {
+        bench.Check("simplifyMesh/no zero area " + std::to_string(tessellation), [&] {
+            auto cuboid = generateMesh(ParametricShape{Primitive::CUBOID}, tessellation);
+            optimizeMesh(cuboid);
+            const auto simplified = simplifyMesh(cuboid, cuboid.Indices.size() / 4, 1.0f);
+            for (size_t i = 0; i < simplified.Indices.size(); i += 3)
+            {
+                const auto& a = simplified.Vertices[simplified.Indices[i]].Position;
+                const auto& b = simplified.Vertices[simplified.Indices[i + 1]].Position;
+                const auto& c = simplified.Vertices[simplified.Indices[i + 2]].Position;
+                const auto normal = (b - a).cross(c - a);
+                if (normal.dot(normal) == 0.0f)
+                {
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
+}
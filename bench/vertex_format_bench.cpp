@@ -0,0 +1,40 @@
+#include <vector>
+
+#include "bench.h"
+#include "generators.h"
+#include "vertex_format.h"
+
+void benchVertexFormat(Bench& bench)
+{
+    const auto mesh = generateMesh(ParametricShape{Primitive::SPHERE}, 5);
+    const size_t n = mesh.Vertices.size();
+    const auto decode = positionDecode(computeBounds(mesh.Vertices.data(), n));
+
+    std::vector<QuantizedVertex> quantized(n);
+    bench.Run("encodeVertices QUANTIZED", n, [&](const size_t iterations) {
+        for (size_t i = 0; i < iterations; i++)
+        {
+            encodeVertices(VertexFormat::QUANTIZED, decode, mesh.Vertices.data(), n, quantized.data());
+            doNotOptimize(quantized[0]);
+        }
+    });
+
+    std::vector<CompactVertex> compact(n);
+    bench.Run("encodeVertices COMPACT", n, [&](const size_t iterations) {
+        for (size_t i = 0; i < iterations; i++)
+        {
+            encodeVertices(VertexFormat::COMPACT, decode, mesh.Vertices.data(), n, compact.data());
+            doNotOptimize(compact[0]);
+        }
+    });
+
+    bench.Run("encodeOctahedral", n, [&](const size_t iterations) {
+        for (size_t i = 0; i < iterations; i++)
+        {
+            for (const auto& v : mesh.Vertices)
+            {
+                doNotOptimize(encodeOctahedral(v.Normal));
+            }
+        }
+    });
+}
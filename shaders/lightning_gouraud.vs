@@ -33,13 +33,39 @@ uniform vec3 viewPos;
 uniform Material material;
 uniform Light light;
 
+// Vertex decoding, see VertexFormat in src/vertex_format.h
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+uniform bool octahedralNormals;
+
+vec3 decodePosition(vec3 p)
+{
+    return p * positionScale + positionOffset;
+}
+
+// Unfolds an octahedral normal, the result is not normalized.
+vec3 decodeNormal(vec3 n)
+{
+    if (!octahedralNormals)
+    {
+        return n;
+    }
+    n.z = 1.0 - abs(n.x) - abs(n.y);
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return n;
+}
+
 void main() 
 {
-   gl_Position = projection * view * model * vec4(aPos, 1.0f);
+   vec3 position = decodePosition(aPos);
+
+   gl_Position = projection * view * model * vec4(position, 1.0f);
    
-   vec3 Normal = normal * aNormal;
+   vec3 Normal = normal * decodeNormal(aNormal);
 
-   vec3 FragPos = vec3(model * vec4(aPos, 1.0));
+   vec3 FragPos = vec3(model * vec4(position, 1.0));
 
    // Ambient
    vec3 ambient = light.ambient * material.ambient;
@@ -0,0 +1,88 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+
+// Per instance
+layout (location = 2) in mat4 aModel;
+layout (location = 6) in mat3 aNormalMatrix;
+
+out vec3 PongColor;
+
+struct Material 
+{
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+    float shininess;
+};
+
+struct Light 
+{
+    vec3 position;
+    vec3 color;
+    
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+uniform mat4 view;
+uniform mat4 projection;
+
+uniform vec3 viewPos;
+uniform Material material;
+uniform Light light;
+
+// Vertex decoding, see VertexFormat in src/vertex_format.h
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+uniform bool octahedralNormals;
+
+vec3 decodePosition(vec3 p)
+{
+    return p * positionScale + positionOffset;
+}
+
+// Unfolds an octahedral normal, the result is not normalized.
+vec3 decodeNormal(vec3 n)
+{
+    if (!octahedralNormals)
+    {
+        return n;
+    }
+    n.z = 1.0 - abs(n.x) - abs(n.y);
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return n;
+}
+
+void main() 
+{
+   vec4 worldPos = aModel * vec4(decodePosition(aPos), 1.0f);
+
+   gl_Position = projection * view * worldPos;
+   
+   vec3 Normal = aNormalMatrix * decodeNormal(aNormal);
+
+   vec3 FragPos = vec3(worldPos);
+
+   // Ambient
+   vec3 ambient = light.ambient * material.ambient;
+
+   // Diffuse
+   vec3 norm = normalize(Normal);
+   vec3 lightDir = normalize(light.position - FragPos);
+   float diff = max(dot(norm, light.position), 0.0);
+   vec3 diffuse = light.diffuse * (diff * material.diffuse);
+
+   // Specular
+   vec3 viewDir = normalize(viewPos - FragPos);
+   vec3 reflectDir = reflect(-lightDir, norm);
+   float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+   vec3 specular = light.specular * (spec * material.specular);
+
+   // Phong lightning model
+   PongColor = ambient + diffuse + specular;
+}
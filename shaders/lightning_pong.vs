@@ -9,14 +9,40 @@ uniform mat4 projection;
 
 uniform mat3 normal;
 
+// Vertex decoding, see VertexFormat in src/vertex_format.h
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+uniform bool octahedralNormals;
+
+vec3 decodePosition(vec3 p)
+{
+    return p * positionScale + positionOffset;
+}
+
+// Unfolds an octahedral normal, the result is not normalized.
+vec3 decodeNormal(vec3 n)
+{
+    if (!octahedralNormals)
+    {
+        return n;
+    }
+    n.z = 1.0 - abs(n.x) - abs(n.y);
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return n;
+}
+
 out vec3 Normal;
 out vec3 FragPos;
 
 void main() 
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    vec3 position = decodePosition(aPos);
+
+    gl_Position = projection * view * model * vec4(position, 1.0);
 
-    Normal = normal * aNormal;
+    Normal = normal * decodeNormal(aNormal);
 
-    FragPos = vec3(model * vec4(aPos, 1.0));
+    FragPos = vec3(model * vec4(position, 1.0));
 }
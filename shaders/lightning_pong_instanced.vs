@@ -0,0 +1,49 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+
+// Per instance
+layout (location = 2) in mat4 aModel;
+layout (location = 6) in mat3 aNormalMatrix;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+// Vertex decoding, see VertexFormat in src/vertex_format.h
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+uniform bool octahedralNormals;
+
+vec3 decodePosition(vec3 p)
+{
+    return p * positionScale + positionOffset;
+}
+
+// Unfolds an octahedral normal, the result is not normalized.
+vec3 decodeNormal(vec3 n)
+{
+    if (!octahedralNormals)
+    {
+        return n;
+    }
+    n.z = 1.0 - abs(n.x) - abs(n.y);
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return n;
+}
+
+out vec3 Normal;
+out vec3 FragPos;
+
+void main() 
+{
+    vec4 worldPos = aModel * vec4(decodePosition(aPos), 1.0);
+
+    gl_Position = projection * view * worldPos;
+
+    Normal = aNormalMatrix * decodeNormal(aNormal);
+
+    FragPos = vec3(worldPos);
+}
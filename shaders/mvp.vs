@@ -6,7 +6,16 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// Vertex decoding, see VertexFormat in src/vertex_format.h
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+
+vec3 decodePosition(vec3 p)
+{
+    return p * positionScale + positionOffset;
+}
+
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0f);
+    gl_Position = projection * view * model * vec4(decodePosition(aPos), 1.0f);
 }
@@ -0,0 +1,431 @@
+#include "batch.h"
+
+#include <cstring>
+
+#include "parallel.h"
+
+// Items handed to each thread; below this the thread start-up cost outweighs the work.
+constexpr size_t kMinRange = 16384;
+
+// Interleaved data is transposed into stack SoA blocks of this many items.
+constexpr size_t kBlockSize = 64;
+
+static void transformPointsRange(const mat4 &m, const float *xs, const float *ys, const float *zs, float *outXs,
+                                 float *outYs, float *outZs, size_t i, const size_t end)
+{
+#if defined(MATH_SIMD_AVX2)
+    const __m256 m00 = _mm256_set1_ps(m[0][0]), m01 = _mm256_set1_ps(m[0][1]), m02 = _mm256_set1_ps(m[0][2]);
+    const __m256 m10 = _mm256_set1_ps(m[1][0]), m11 = _mm256_set1_ps(m[1][1]), m12 = _mm256_set1_ps(m[1][2]);
+    const __m256 m20 = _mm256_set1_ps(m[2][0]), m21 = _mm256_set1_ps(m[2][1]), m22 = _mm256_set1_ps(m[2][2]);
+    const __m256 m30 = _mm256_set1_ps(m[3][0]), m31 = _mm256_set1_ps(m[3][1]), m32 = _mm256_set1_ps(m[3][2]);
+
+    for (; i + 8 <= end; i += 8)
+    {
+        const __m256 x = _mm256_loadu_ps(xs + i);
+        const __m256 y = _mm256_loadu_ps(ys + i);
+        const __m256 z = _mm256_loadu_ps(zs + i);
+
+        const __m256 ox = _mm256_add_ps(
+            _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m00, x), _mm256_mul_ps(m10, y)), _mm256_mul_ps(m20, z)), m30);
+        const __m256 oy = _mm256_add_ps(
+            _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m01, x), _mm256_mul_ps(m11, y)), _mm256_mul_ps(m21, z)), m31);
+        const __m256 oz = _mm256_add_ps(
+            _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m02, x), _mm256_mul_ps(m12, y)), _mm256_mul_ps(m22, z)), m32);
+
+        _mm256_storeu_ps(outXs + i, ox);
+        _mm256_storeu_ps(outYs + i, oy);
+        _mm256_storeu_ps(outZs + i, oz);
+    }
+#endif
+
+    for (; i < end; i++)
+    {
+        const float x = xs[i];
+        const float y = ys[i];
+        const float z = zs[i];
+
+        outXs[i] = m[0][0] * x + m[1][0] * y + m[2][0] * z + m[3][0];
+        outYs[i] = m[0][1] * x + m[1][1] * y + m[2][1] * z + m[3][1];
+        outZs[i] = m[0][2] * x + m[1][2] * y + m[2][2] * z + m[3][2];
+    }
+}
+
+static void transformNormalsRange(const mat3 &m, const float *xs, const float *ys, const float *zs, float *outXs,
+                                  float *outYs, float *outZs, size_t i, const size_t end)
+{
+#if defined(MATH_SIMD_AVX2)
+    const __m256 m00 = _mm256_set1_ps(m[0][0]), m01 = _mm256_set1_ps(m[0][1]), m02 = _mm256_set1_ps(m[0][2]);
+    const __m256 m10 = _mm256_set1_ps(m[1][0]), m11 = _mm256_set1_ps(m[1][1]), m12 = _mm256_set1_ps(m[1][2]);
+    const __m256 m20 = _mm256_set1_ps(m[2][0]), m21 = _mm256_set1_ps(m[2][1]), m22 = _mm256_set1_ps(m[2][2]);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    for (; i + 8 <= end; i += 8)
+    {
+        const __m256 x = _mm256_loadu_ps(xs + i);
+        const __m256 y = _mm256_loadu_ps(ys + i);
+        const __m256 z = _mm256_loadu_ps(zs + i);
+
+        const __m256 nx =
+            _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m00, x), _mm256_mul_ps(m10, y)), _mm256_mul_ps(m20, z));
+        const __m256 ny =
+            _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m01, x), _mm256_mul_ps(m11, y)), _mm256_mul_ps(m21, z));
+        const __m256 nz =
+            _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m02, x), _mm256_mul_ps(m12, y)), _mm256_mul_ps(m22, z));
+
+        const __m256 len = _mm256_sqrt_ps(
+            _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, nx), _mm256_mul_ps(ny, ny)), _mm256_mul_ps(nz, nz)));
+        const __m256 invLen = _mm256_div_ps(one, len);
+
+        _mm256_storeu_ps(outXs + i, _mm256_mul_ps(nx, invLen));
+        _mm256_storeu_ps(outYs + i, _mm256_mul_ps(ny, invLen));
+        _mm256_storeu_ps(outZs + i, _mm256_mul_ps(nz, invLen));
+    }
+#endif
+
+    for (; i < end; i++)
+    {
+        const float x = xs[i];
+        const float y = ys[i];
+        const float z = zs[i];
+
+        const float nx = m[0][0] * x + m[1][0] * y + m[2][0] * z;
+        const float ny = m[0][1] * x + m[1][1] * y + m[2][1] * z;
+        const float nz = m[0][2] * x + m[1][2] * y + m[2][2] * z;
+
+        const float invLen = 1.0f / std::sqrt(nx * nx + ny * ny + nz * nz);
+
+        outXs[i] = nx * invLen;
+        outYs[i] = ny * invLen;
+        outZs[i] = nz * invLen;
+    }
+}
+
+static void normalMatricesRange(const mat4 *models, mat3 *out, size_t i, const size_t end)
+{
+#if defined(MATH_SIMD_AVX2)
+    const __m256i offsets = _mm256_setr_epi32(0, 16, 32, 48, 64, 80, 96, 112);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    const auto cross = [](const __m256 ax, const __m256 ay, const __m256 az, const __m256 bx, const __m256 by,
+                          const __m256 bz, __m256 &rx, __m256 &ry, __m256 &rz)
+    {
+        rx = _mm256_sub_ps(_mm256_mul_ps(ay, bz), _mm256_mul_ps(az, by));
+        ry = _mm256_sub_ps(_mm256_mul_ps(az, bx), _mm256_mul_ps(ax, bz));
+        rz = _mm256_sub_ps(_mm256_mul_ps(ax, by), _mm256_mul_ps(ay, bx));
+    };
+
+    for (; i + 8 <= end; i += 8)
+    {
+        const float *base = &models[i][0].x;
+
+        __m256 c[9];
+        for (int col = 0; col < 3; col++)
+        {
+            for (int row = 0; row < 3; row++)
+            {
+                c[col * 3 + row] = _mm256_i32gather_ps(base + col * 4 + row, offsets, 4);
+            }
+        }
+
+        __m256 r[9];
+        cross(c[3], c[4], c[5], c[6], c[7], c[8], r[0], r[1], r[2]);
+        cross(c[6], c[7], c[8], c[0], c[1], c[2], r[3], r[4], r[5]);
+        cross(c[0], c[1], c[2], c[3], c[4], c[5], r[6], r[7], r[8]);
+
+        const __m256 det = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c[0], r[0]), _mm256_mul_ps(c[1], r[1])),
+                                         _mm256_mul_ps(c[2], r[2]));
+        const __m256 invDet = _mm256_div_ps(one, det);
+
+        alignas(32) float soa[9][8];
+        for (int k = 0; k < 9; k++)
+        {
+            _mm256_store_ps(soa[k], _mm256_mul_ps(r[k], invDet));
+        }
+
+        for (int k = 0; k < 8; k++)
+        {
+            out[i + k] = mat3{soa[0][k], soa[1][k], soa[2][k], soa[3][k], soa[4][k],
+                              soa[5][k], soa[6][k], soa[7][k], soa[8][k]};
+        }
+    }
+#endif
+
+    for (; i < end; i++)
+    {
+        const vec3 c0{models[i][0].x, models[i][0].y, models[i][0].z};
+        const vec3 c1{models[i][1].x, models[i][1].y, models[i][1].z};
+        const vec3 c2{models[i][2].x, models[i][2].y, models[i][2].z};
+
+        const auto x0 = c1.cross(c2);
+        const auto invDet = 1.0f / c0.dot(x0);
+
+        out[i] = mat3{x0 * invDet, c2.cross(c0) * invDet, c0.cross(c1) * invDet};
+    }
+}
+
+static void cullRange(const Frustum &frustum, const AABB *boxes, uint8_t *visible, size_t i, const size_t end)
+{
+#if defined(MATH_SIMD_AVX2)
+    // Gathers 8 boxes into SoA registers, AABB is 6 floats: min.xyz, max.xyz.
+    const __m256i offsets = _mm256_setr_epi32(0, 6, 12, 18, 24, 30, 36, 42);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+    for (; i + 8 <= end; i += 8)
+    {
+        const float *base = &boxes[i].min.x;
+
+        const __m256 minX = _mm256_i32gather_ps(base + 0, offsets, 4);
+        const __m256 minY = _mm256_i32gather_ps(base + 1, offsets, 4);
+        const __m256 minZ = _mm256_i32gather_ps(base + 2, offsets, 4);
+        const __m256 maxX = _mm256_i32gather_ps(base + 3, offsets, 4);
+        const __m256 maxY = _mm256_i32gather_ps(base + 4, offsets, 4);
+        const __m256 maxZ = _mm256_i32gather_ps(base + 5, offsets, 4);
+
+        const __m256 cx = _mm256_mul_ps(_mm256_add_ps(minX, maxX), half);
+        const __m256 cy = _mm256_mul_ps(_mm256_add_ps(minY, maxY), half);
+        const __m256 cz = _mm256_mul_ps(_mm256_add_ps(minZ, maxZ), half);
+        const __m256 ex = _mm256_mul_ps(_mm256_sub_ps(maxX, minX), half);
+        const __m256 ey = _mm256_mul_ps(_mm256_sub_ps(maxY, minY), half);
+        const __m256 ez = _mm256_mul_ps(_mm256_sub_ps(maxZ, minZ), half);
+
+        __m256 outside = _mm256_setzero_ps();
+        for (const auto &plane : frustum.planes)
+        {
+            const __m256 nx = _mm256_set1_ps(plane.normal.x);
+            const __m256 ny = _mm256_set1_ps(plane.normal.y);
+            const __m256 nz = _mm256_set1_ps(plane.normal.z);
+
+            const __m256 dist = _mm256_add_ps(
+                _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, cx), _mm256_mul_ps(ny, cy)), _mm256_mul_ps(nz, cz)),
+                _mm256_set1_ps(plane.d));
+            const __m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_andnot_ps(signMask, nx), ex),
+                                                              _mm256_mul_ps(_mm256_andnot_ps(signMask, ny), ey)),
+                                                _mm256_mul_ps(_mm256_andnot_ps(signMask, nz), ez));
+
+            // dist < -radius
+            const __m256 test = _mm256_cmp_ps(_mm256_add_ps(dist, radius), _mm256_setzero_ps(), _CMP_LT_OQ);
+            outside = _mm256_or_ps(outside, test);
+        }
+
+        const int mask = _mm256_movemask_ps(outside);
+        for (int k = 0; k < 8; k++)
+        {
+            visible[i + k] = (mask >> k) & 1 ? 0 : 1;
+        }
+    }
+#endif
+
+#if defined(MATH_SIMD_SSE41)
+    // 4 boxes are 6 unaligned loads; shuffled into one min.xyz max.x row per box, transposed, plus max.yz pairs.
+    const __m128 halfSse = _mm_set1_ps(0.5f);
+    const __m128 signMaskSse = _mm_set1_ps(-0.0f);
+
+    for (; i + 4 <= end; i += 4)
+    {
+        const float *base = &boxes[i].min.x;
+        const __m128 m0 = _mm_loadu_ps(base + 0), m1 = _mm_loadu_ps(base + 4), m2 = _mm_loadu_ps(base + 8);
+        const __m128 m3 = _mm_loadu_ps(base + 12), m4 = _mm_loadu_ps(base + 16), m5 = _mm_loadu_ps(base + 20);
+
+        __m128 minX = m0, minY = _mm_shuffle_ps(m1, m2, _MM_SHUFFLE(1, 0, 3, 2));
+        __m128 minZ = m3, maxX = _mm_shuffle_ps(m4, m5, _MM_SHUFFLE(1, 0, 3, 2));
+        _MM_TRANSPOSE4_PS(minX, minY, minZ, maxX);
+        const __m128 ab = _mm_shuffle_ps(m1, m2, _MM_SHUFFLE(3, 2, 1, 0));
+        const __m128 cd = _mm_shuffle_ps(m4, m5, _MM_SHUFFLE(3, 2, 1, 0));
+        const __m128 maxY = _mm_shuffle_ps(ab, cd, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 maxZ = _mm_shuffle_ps(ab, cd, _MM_SHUFFLE(3, 1, 3, 1));
+
+        const __m128 cx = _mm_mul_ps(_mm_add_ps(minX, maxX), halfSse);
+        const __m128 cy = _mm_mul_ps(_mm_add_ps(minY, maxY), halfSse);
+        const __m128 cz = _mm_mul_ps(_mm_add_ps(minZ, maxZ), halfSse);
+        const __m128 ex = _mm_mul_ps(_mm_sub_ps(maxX, minX), halfSse);
+        const __m128 ey = _mm_mul_ps(_mm_sub_ps(maxY, minY), halfSse);
+        const __m128 ez = _mm_mul_ps(_mm_sub_ps(maxZ, minZ), halfSse);
+
+        __m128 outside = _mm_setzero_ps();
+        for (const auto &plane : frustum.planes)
+        {
+            const __m128 nx = _mm_set1_ps(plane.normal.x);
+            const __m128 ny = _mm_set1_ps(plane.normal.y);
+            const __m128 nz = _mm_set1_ps(plane.normal.z);
+
+            const __m128 dist = _mm_add_ps(
+                _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)), _mm_mul_ps(nz, cz)),
+                _mm_set1_ps(plane.d));
+            const __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMaskSse, nx), ex),
+                                                        _mm_mul_ps(_mm_andnot_ps(signMaskSse, ny), ey)),
+                                             _mm_mul_ps(_mm_andnot_ps(signMaskSse, nz), ez));
+
+            // dist < -radius
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(dist, radius), _mm_setzero_ps()));
+        }
+
+        const int mask = _mm_movemask_ps(outside);
+        for (int k = 0; k < 4; k++)
+        {
+            visible[i + k] = (mask >> k) & 1 ? 0 : 1;
+        }
+    }
+#endif
+
+    for (; i < end; i++)
+    {
+        visible[i] = frustum.intersects(boxes[i]) ? 1 : 0;
+    }
+}
+
+static void cullRange(const Frustum &frustum, const Sphere *spheres, uint8_t *visible, size_t i, const size_t end)
+{
+#if defined(MATH_SIMD_AVX2)
+    // Sphere is 4 floats: center.xyz, radius.
+    const __m256i offsets = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+
+    for (; i + 8 <= end; i += 8)
+    {
+        const float *base = &spheres[i].center.x;
+
+        const __m256 cx = _mm256_i32gather_ps(base + 0, offsets, 4);
+        const __m256 cy = _mm256_i32gather_ps(base + 1, offsets, 4);
+        const __m256 cz = _mm256_i32gather_ps(base + 2, offsets, 4);
+        const __m256 radius = _mm256_i32gather_ps(base + 3, offsets, 4);
+
+        __m256 outside = _mm256_setzero_ps();
+        for (const auto &plane : frustum.planes)
+        {
+            const __m256 nx = _mm256_set1_ps(plane.normal.x);
+            const __m256 ny = _mm256_set1_ps(plane.normal.y);
+            const __m256 nz = _mm256_set1_ps(plane.normal.z);
+
+            const __m256 dist = _mm256_add_ps(
+                _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, cx), _mm256_mul_ps(ny, cy)), _mm256_mul_ps(nz, cz)),
+                _mm256_set1_ps(plane.d));
+
+            // dist < -radius
+            const __m256 test = _mm256_cmp_ps(_mm256_add_ps(dist, radius), _mm256_setzero_ps(), _CMP_LT_OQ);
+            outside = _mm256_or_ps(outside, test);
+        }
+
+        const int mask = _mm256_movemask_ps(outside);
+        for (int k = 0; k < 8; k++)
+        {
+            visible[i + k] = (mask >> k) & 1 ? 0 : 1;
+        }
+    }
+#endif
+
+#if defined(MATH_SIMD_SSE41)
+    // 4 spheres are a 4x4 block to transpose.
+    for (; i + 4 <= end; i += 4)
+    {
+        const float *base = &spheres[i].center.x;
+        __m128 cx = _mm_loadu_ps(base + 0), cy = _mm_loadu_ps(base + 4);
+        __m128 cz = _mm_loadu_ps(base + 8), radius = _mm_loadu_ps(base + 12);
+        _MM_TRANSPOSE4_PS(cx, cy, cz, radius);
+
+        __m128 outside = _mm_setzero_ps();
+        for (const auto &plane : frustum.planes)
+        {
+            const __m128 nx = _mm_set1_ps(plane.normal.x);
+            const __m128 ny = _mm_set1_ps(plane.normal.y);
+            const __m128 nz = _mm_set1_ps(plane.normal.z);
+
+            const __m128 dist = _mm_add_ps(
+                _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)), _mm_mul_ps(nz, cz)),
+                _mm_set1_ps(plane.d));
+
+            // dist < -radius
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(dist, radius), _mm_setzero_ps()));
+        }
+
+        const int mask = _mm_movemask_ps(outside);
+        for (int k = 0; k < 4; k++)
+        {
+            visible[i + k] = (mask >> k) & 1 ? 0 : 1;
+        }
+    }
+#endif
+
+    for (; i < end; i++)
+    {
+        visible[i] = frustum.intersects(spheres[i]) ? 1 : 0;
+    }
+}
+
+// Runs a SoA range kernel over interleaved xyz triplets by transposing kBlockSize items at a time.
+template <typename Matrix, typename Kernel>
+static void transformInterleaved(const Matrix &m, const void *in, void *out, const size_t stride, const size_t n,
+                                 Kernel kernel)
+{
+    const auto *src = static_cast<const unsigned char *>(in);
+    auto *dst = static_cast<unsigned char *>(out);
+
+    parallelFor(n, kMinRange,
+                [&](size_t begin, const size_t end)
+                {
+                    float xs[kBlockSize], ys[kBlockSize], zs[kBlockSize];
+
+                    for (; begin < end; begin += kBlockSize)
+                    {
+                        const size_t count = std::min(kBlockSize, end - begin);
+
+                        for (size_t i = 0; i < count; i++)
+                        {
+                            float v[3];
+                            std::memcpy(v, src + (begin + i) * stride, sizeof(v));
+                            xs[i] = v[0];
+                            ys[i] = v[1];
+                            zs[i] = v[2];
+                        }
+
+                        kernel(m, xs, ys, zs, xs, ys, zs, 0, count);
+
+                        for (size_t i = 0; i < count; i++)
+                        {
+                            const float v[3] = {xs[i], ys[i], zs[i]};
+                            std::memcpy(dst + (begin + i) * stride, v, sizeof(v));
+                        }
+                    }
+                });
+}
+
+void transformPoints(const mat4 &m, const float *xs, const float *ys, const float *zs, float *outXs, float *outYs,
+                     float *outZs, const size_t n)
+{
+    parallelFor(n, kMinRange, [&](const size_t begin, const size_t end)
+                { transformPointsRange(m, xs, ys, zs, outXs, outYs, outZs, begin, end); });
+}
+
+void transformNormals(const mat3 &m, const float *xs, const float *ys, const float *zs, float *outXs, float *outYs,
+                      float *outZs, const size_t n)
+{
+    parallelFor(n, kMinRange, [&](const size_t begin, const size_t end)
+                { transformNormalsRange(m, xs, ys, zs, outXs, outYs, outZs, begin, end); });
+}
+
+void transformPoints(const mat4 &m, const void *in, void *out, const size_t stride, const size_t n)
+{
+    transformInterleaved(m, in, out, stride, n, transformPointsRange);
+}
+
+void transformNormals(const mat3 &m, const void *in, void *out, const size_t stride, const size_t n)
+{
+    transformInterleaved(m, in, out, stride, n, transformNormalsRange);
+}
+
+void normalMatrices(const mat4 *models, const size_t n, mat3 *out)
+{
+    parallelFor(n, kMinRange, [&](const size_t begin, const size_t end)
+                { normalMatricesRange(models, out, begin, end); });
+}
+
+void cull(const Frustum &frustum, const AABB *boxes, const size_t n, uint8_t *visible)
+{
+    parallelFor(n, kMinRange, [&](const size_t begin, const size_t end)
+                { cullRange(frustum, boxes, visible, begin, end); });
+}
+
+void cull(const Frustum &frustum, const Sphere *spheres, const size_t n, uint8_t *visible)
+{
+    parallelFor(n, kMinRange, [&](const size_t begin, const size_t end)
+                { cullRange(frustum, spheres, visible, begin, end); });
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "math.h"
+
+/////////////////////////// Batched kernels /////////////////////
+// Structure-of-arrays kernels that apply one transform to many values. Under MATH_SIMD_AVX2 they process 8 values
+// per iteration, otherwise the scalar loop is left to the compiler's auto-vectorizer. Large inputs are split across
+// threads with parallelFor(). Input and output arrays may alias (in-place transforms are allowed).
+
+// Transforms points as (x, y, z, 1). The last row of the matrix is ignored, so it must be affine.
+void transformPoints(const mat4 &m, const float *xs, const float *ys, const float *zs, float *outXs, float *outYs,
+                     float *outZs, const size_t n);
+
+// Transforms directions by a normal matrix and renormalizes them.
+void transformNormals(const mat3 &m, const float *xs, const float *ys, const float *zs, float *outXs, float *outYs,
+                      float *outZs, const size_t n);
+
+// Interleaved variants: reads and writes an xyz float triplet every stride bytes, e.g. Vertex::Position.
+void transformPoints(const mat4 &m, const void *in, void *out, const size_t stride, const size_t n);
+void transformNormals(const mat3 &m, const void *in, void *out, const size_t stride, const size_t n);
+
+// normalMatrix() of every model matrix, written straight into out (e.g. a mapped instance buffer). The batch always
+// takes the cofactor path, so every instance costs the same and the AVX2 path stays branch free.
+void normalMatrices(const mat4 *models, const size_t n, mat3 *out);
+
+// Frustum culling, writes 1 to visible[i] when the i-th volume intersects the frustum and 0 otherwise. Unlike the
+// transforms, culling also has a 4-wide SSE4.1 path (which finishes the AVX2 loop's remainder): the compiler doesn't
+// vectorize the early-out plane loop of Frustum::intersects().
+void cull(const Frustum &frustum, const AABB *boxes, const size_t n, uint8_t *visible);
+void cull(const Frustum &frustum, const Sphere *spheres, const size_t n, uint8_t *visible);
+////////////////////////////////////////////////////////////////
@@ -11,11 +11,11 @@ enum Camera_Movement
 };
 
 // Default camera values
-const float YAW = -90.0f;
-const float PITCH = 0.0f;
-const float SPEED = 5.5f;
-const float SENSITIVITY = 1.0f;
-const float ZOOM = 90.0f;
+constexpr float YAW = -90.0f;
+constexpr float PITCH = 0.0f;
+constexpr float SPEED = 5.5f;
+constexpr float SENSITIVITY = 1.0f;
+constexpr float ZOOM = 90.0f;
 
 class Camera
 {
@@ -97,10 +97,14 @@ class Camera
     // calculates the front vector from the Camera's (updated) Euler Angles
     void Update()
     {
+        float sinYaw, cosYaw, sinPitch, cosPitch;
+        sincos(radians(Yaw), sinYaw, cosYaw);
+        sincos(radians(Pitch), sinPitch, cosPitch);
+
         vec3 front{
-            cos(radians(Yaw)) * cos(radians(Pitch)),
-            sin(radians(Pitch)),
-            sin(radians(Yaw)) * cos(radians(Pitch)),
+            cosYaw * cosPitch,
+            sinPitch,
+            sinYaw * cosPitch,
         };
 
         Front = front.normalize();
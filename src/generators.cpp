@@ -0,0 +1,330 @@
+#include "generators.h"
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <vector>
+
+#include "optimizer.h"
+#include "parallel.h"
+#include "simplifier.h"
+
+// Point of the 2D profile that is swept around the Y axis. Positions are (radius, y), the normal is given in the
+// same plane. joinNext is false where the surface has a hard edge and the next point starts a new strip.
+struct ProfilePoint
+{
+    float r, y;
+    float nr, ny;
+    bool joinNext;
+};
+
+static int slices(const int tessellation) { return 8 << tessellation; }
+
+static std::vector<ProfilePoint> profile(const ParametricShape& shape, const int tessellation)
+{
+    std::vector<ProfilePoint> p;
+
+    const auto halfHeight = shape.Height * 0.5f;
+
+    // Quarter circle arc of the given radius from angle a0 to a1, around center (0, y).
+    const auto arc = [&p](const float radius, const float y, const float a0, const float a1, const int steps) {
+        for (int k = 0; k <= steps; k++)
+        {
+            float s = 0, c = 0;
+            sincos(a0 + (a1 - a0) * static_cast<float>(k) / static_cast<float>(steps), s, c);
+
+            // Points on the axis are exactly 0, so their degenerate triangles can be dropped.
+            const bool pole = (k == 0 && a0 == -PI / 2) || (k == steps && a1 == PI / 2);
+            p.push_back(ProfilePoint{pole ? 0.0f : radius * c, y + radius * s, pole ? 0.0f : c, s, true});
+        }
+    };
+
+    switch (shape.Type)
+    {
+    case Primitive::SPHERE:
+        arc(shape.Radius, 0.0f, -PI / 2, PI / 2, 4 << tessellation);
+        break;
+
+    case Primitive::CAPSULE:
+        // Two hemispheres, the strip between their equators is the cylinder.
+        arc(shape.Radius, -halfHeight, -PI / 2, 0.0f, 2 << tessellation);
+        arc(shape.Radius, halfHeight, 0.0f, PI / 2, 2 << tessellation);
+        break;
+
+    case Primitive::CYLINDER:
+        p.push_back(ProfilePoint{0.0f, -halfHeight, 0.0f, -1.0f, true});
+        p.push_back(ProfilePoint{shape.Radius, -halfHeight, 0.0f, -1.0f, false});
+        p.push_back(ProfilePoint{shape.Radius, -halfHeight, 1.0f, 0.0f, true});
+        p.push_back(ProfilePoint{shape.Radius, halfHeight, 1.0f, 0.0f, false});
+        p.push_back(ProfilePoint{shape.Radius, halfHeight, 0.0f, 1.0f, true});
+        p.push_back(ProfilePoint{0.0f, halfHeight, 0.0f, 1.0f, false});
+        break;
+
+    case Primitive::CONE:
+    {
+        // The side normal is perpendicular to the slant (-radius, height).
+        const auto n = vec2{shape.Height, shape.Radius} / constexprSqrt(shape.Height * shape.Height +
+                                                                         shape.Radius * shape.Radius);
+        p.push_back(ProfilePoint{0.0f, -halfHeight, 0.0f, -1.0f, true});
+        p.push_back(ProfilePoint{shape.Radius, -halfHeight, 0.0f, -1.0f, false});
+        p.push_back(ProfilePoint{shape.Radius, -halfHeight, n.x, n.y, true});
+        p.push_back(ProfilePoint{0.0f, halfHeight, n.x, n.y, false});
+        break;
+    }
+
+    case Primitive::TORUS:
+    {
+        const int steps = 8 << tessellation;
+        for (int k = 0; k <= steps; k++)
+        {
+            float s = 0, c = 0;
+            sincos(k == steps ? 0.0f : 2 * PI * static_cast<float>(k) / static_cast<float>(steps), s, c);
+            p.push_back(ProfilePoint{shape.Radius + shape.TubeRadius * c, shape.TubeRadius * s, c, s, true});
+        }
+        break;
+    }
+
+    case Primitive::CUBOID:
+        break;
+    }
+
+    if (!p.empty())
+    {
+        p.back().joinNext = false;
+    }
+    return p;
+}
+
+static MeshSize latheSize(const std::vector<ProfilePoint>& p, const int slices)
+{
+    MeshSize size{p.size() * (slices + 1), 0};
+    for (size_t k = 0; k + 1 < p.size(); k++)
+    {
+        if (p[k].joinNext)
+        {
+            // A strip touching the axis has one triangle per slice instead of a quad.
+            size.IndexCount += (p[k].r == 0.0f || p[k + 1].r == 0.0f ? 3 : 6) * slices;
+        }
+    }
+    return size;
+}
+
+// Sweeps the profile around the Y axis. Column i is at angle 2 * PI * i / slices, the last column duplicates the
+// first so the seam can carry its own texture coordinates later.
+static void lathe(const std::vector<ProfilePoint>& p, const int slices, Vertex* vertices, unsigned int* indices)
+{
+    std::vector<vec2> angles(slices + 1);
+    for (int i = 0; i <= slices; i++)
+    {
+        float s = 0, c = 0;
+        sincos(i == slices ? 0.0f : 2 * PI * static_cast<float>(i) / static_cast<float>(slices), s, c);
+        angles[i] = vec2{c, s};
+    }
+
+    for (const auto& point : p)
+    {
+        for (const auto& a : angles)
+        {
+            *vertices++ = Vertex{vec3{point.r * a.x, point.y, -point.r * a.y},
+                                 vec3{point.nr * a.x, point.ny, -point.nr * a.y}};
+        }
+    }
+
+    const unsigned int stride = slices + 1;
+    for (size_t k = 0; k + 1 < p.size(); k++)
+    {
+        if (!p[k].joinNext)
+        {
+            continue;
+        }
+
+        for (unsigned int i = 0; i < static_cast<unsigned int>(slices); i++)
+        {
+            const unsigned int a = static_cast<unsigned int>(k) * stride + i;
+            const unsigned int b = a + 1;
+            const unsigned int c = a + stride + 1;
+            const unsigned int d = a + stride;
+
+            if (p[k].r != 0.0f)
+            {
+                *indices++ = a;
+                *indices++ = b;
+                *indices++ = c;
+            }
+            if (p[k + 1].r != 0.0f)
+            {
+                *indices++ = a;
+                *indices++ = c;
+                *indices++ = d;
+            }
+        }
+    }
+}
+
+// Six faces, each a grid of (n + 1)^2 vertices, so the cuboid can be tessellated like the other primitives.
+static void cuboid(const vec3& dimensions, const int n, Vertex* vertices, unsigned int* indices)
+{
+    // Normal, then the u and v axes of the face with u x v = normal.
+    constexpr vec3 faces[6][3] = {
+        {vec3{1, 0, 0}, vec3{0, 0, -1}, vec3{0, 1, 0}},  {vec3{-1, 0, 0}, vec3{0, 0, 1}, vec3{0, 1, 0}},
+        {vec3{0, 1, 0}, vec3{1, 0, 0}, vec3{0, 0, -1}},  {vec3{0, -1, 0}, vec3{1, 0, 0}, vec3{0, 0, 1}},
+        {vec3{0, 0, 1}, vec3{1, 0, 0}, vec3{0, 1, 0}},   {vec3{0, 0, -1}, vec3{-1, 0, 0}, vec3{0, 1, 0}},
+    };
+
+    unsigned int base = 0;
+    for (const auto& [normal, u, v] : faces)
+    {
+        const auto center = normal * dimensions * 0.5f;
+        const auto uAxis = u * dimensions;
+        const auto vAxis = v * dimensions;
+
+        for (int j = 0; j <= n; j++)
+        {
+            for (int i = 0; i <= n; i++)
+            {
+                const auto s = static_cast<float>(i) / static_cast<float>(n) - 0.5f;
+                const auto t = static_cast<float>(j) / static_cast<float>(n) - 0.5f;
+                *vertices++ = Vertex{center + uAxis * s + vAxis * t, normal};
+            }
+        }
+
+        for (unsigned int j = 0; j < static_cast<unsigned int>(n); j++)
+        {
+            for (unsigned int i = 0; i < static_cast<unsigned int>(n); i++)
+            {
+                const unsigned int a = base + j * (n + 1) + i;
+                const unsigned int b = a + 1;
+                const unsigned int c = a + n + 2;
+                const unsigned int d = a + n + 1;
+
+                *indices++ = a;
+                *indices++ = b;
+                *indices++ = c;
+                *indices++ = a;
+                *indices++ = c;
+                *indices++ = d;
+            }
+        }
+
+        base += (n + 1) * (n + 1);
+    }
+}
+
+MeshSize meshSize(const ParametricShape& shape, const int tessellation)
+{
+    if (shape.Type == Primitive::CUBOID)
+    {
+        const size_t n = size_t{1} << tessellation;
+        return MeshSize{6 * (n + 1) * (n + 1), 6 * n * n * 6};
+    }
+    return latheSize(profile(shape, tessellation), slices(tessellation));
+}
+
+void generateMesh(const ParametricShape& shape, const int tessellation, Vertex* vertices, unsigned int* indices)
+{
+    if (shape.Type == Primitive::CUBOID)
+    {
+        cuboid(shape.Dimensions, 1 << tessellation, vertices, indices);
+        return;
+    }
+    lathe(profile(shape, tessellation), slices(tessellation), vertices, indices);
+}
+
+Mesh generateMesh(const ParametricShape& shape, const int tessellation)
+{
+    const auto size = meshSize(shape, tessellation);
+
+    Mesh mesh;
+    mesh.Vertices.resize(size.VertexCount);
+    mesh.Indices.resize(size.IndexCount);
+    generateMesh(shape, tessellation, mesh.Vertices.data(), mesh.Indices.data());
+    return mesh;
+}
+
+LodChain::LodChain(const ParametricShape& shape, const int count)
+{
+    assert(count > 0 && count <= MAX_LOD_LEVELS && "Invalid LOD level count");
+
+    levelCount = count;
+
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    for (int level = 0; level < levelCount; level++)
+    {
+        const auto size = meshSize(shape, levelCount - 1 - level);
+        levels[level] = LodLevel{vertexCount, size.VertexCount, indexCount, size.IndexCount};
+        vertexCount += size.VertexCount;
+        indexCount += size.IndexCount;
+    }
+
+    storage.reset(new unsigned char[vertexCount * sizeof(Vertex) + indexCount * sizeof(unsigned int)]);
+    vertices = reinterpret_cast<Vertex*>(storage.get());
+    indices = reinterpret_cast<unsigned int*>(storage.get() + vertexCount * sizeof(Vertex));
+    std::uninitialized_default_construct_n(vertices, vertexCount);
+
+    // Every level writes to its own part of the allocation.
+    parallelFor(levelCount, 1, [&](const size_t begin, const size_t end) {
+        for (size_t level = begin; level < end; level++)
+        {
+            auto& l = levels[level];
+            generateMesh(shape, levelCount - 1 - static_cast<int>(level), vertices + l.FirstVertex,
+                         indices + l.FirstIndex);
+            l.VertexCount = optimizeMesh(vertices + l.FirstVertex, l.VertexCount, indices + l.FirstIndex,
+                                         l.IndexCount);
+        }
+    });
+}
+
+LodChain::LodChain(const Mesh& mesh, const int count, const float maxError)
+{
+    assert(count > 0 && count <= MAX_LOD_LEVELS && "Invalid LOD level count");
+
+    // Every level is simplified from the original, which keeps the errors from adding up and the levels independent.
+    std::vector<Mesh> meshes(count);
+    parallelFor(count, 1, [&](const size_t begin, const size_t end) {
+        for (size_t level = begin; level < end; level++)
+        {
+            meshes[level] = level == 0 ? mesh : simplifyMesh(mesh, mesh.Indices.size() >> (2 * level), maxError);
+            optimizeMesh(meshes[level]);
+        }
+    });
+
+    // A level that isn't clearly smaller than the one before means the error bound was hit, it and all coarser ones
+    // would only cost memory.
+    levelCount = 1;
+    while (levelCount < count && meshes[levelCount].Indices.size() > 0 &&
+           meshes[levelCount].Indices.size() * 4 < meshes[levelCount - 1].Indices.size() * 3)
+    {
+        levelCount++;
+    }
+
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    for (int level = 0; level < levelCount; level++)
+    {
+        const auto& m = meshes[level];
+        levels[level] = LodLevel{vertexCount, m.Vertices.size(), indexCount, m.Indices.size()};
+        vertexCount += m.Vertices.size();
+        indexCount += m.Indices.size();
+    }
+
+    storage.reset(new unsigned char[vertexCount * sizeof(Vertex) + indexCount * sizeof(unsigned int)]);
+    vertices = reinterpret_cast<Vertex*>(storage.get());
+    indices = reinterpret_cast<unsigned int*>(storage.get() + vertexCount * sizeof(Vertex));
+    for (int level = 0; level < levelCount; level++)
+    {
+        const auto& m = meshes[level];
+        std::uninitialized_copy(m.Vertices.begin(), m.Vertices.end(), vertices + levels[level].FirstVertex);
+        std::copy(m.Indices.begin(), m.Indices.end(), indices + levels[level].FirstIndex);
+    }
+}
+
+Mesh LodChain::GetMesh(const int level) const
+{
+    const auto& l = levels[level];
+
+    Mesh mesh;
+    mesh.Vertices.assign(vertices + l.FirstVertex, vertices + l.FirstVertex + l.VertexCount);
+    mesh.Indices.assign(indices + l.FirstIndex, indices + l.FirstIndex + l.IndexCount);
+    return mesh;
+}
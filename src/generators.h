@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "math.h"
+#include "mesh.h"
+
+/////////////////////////// Parametric shapes ///////////////////
+enum class Primitive
+{
+    SPHERE,
+    CYLINDER,
+    CONE,
+    TORUS,
+    CAPSULE,
+    CUBOID
+};
+
+// Shapes are centered on the origin with Y as their axis. Fields that don't apply to the primitive are ignored.
+struct ParametricShape
+{
+    Primitive Type;
+    float Radius = 0.5f;      // sphere, cylinder, cone, capsule; distance from the center to the tube of a torus
+    float Height = 1.0f;      // cylinder, cone; the straight part of a capsule
+    float TubeRadius = 0.2f;  // torus
+    vec3 Dimensions{1.0f};    // cuboid
+};
+
+// Bump whenever generateMesh() output changes, it is part of the cache key of generated meshes.
+constexpr uint32_t GENERATOR_VERSION = 2;
+
+struct MeshSize
+{
+    size_t VertexCount;
+    size_t IndexCount;
+};
+
+// Tessellation levels start at 0, the coarsest mesh that still reads as the primitive, and every level doubles the
+// segment counts (8 << level around the axis).
+MeshSize meshSize(const ParametricShape& shape, const int tessellation);
+
+// Writes exactly meshSize() vertices and indices. Triangles are counter-clockwise seen from the outside.
+void generateMesh(const ParametricShape& shape, const int tessellation, Vertex* vertices, unsigned int* indices);
+
+Mesh generateMesh(const ParametricShape& shape, const int tessellation);
+////////////////////////////////////////////////////////////////
+
+/////////////////////////// LOD chain ///////////////////////////
+constexpr int MAX_LOD_LEVELS = 8;
+
+// Largest error of simplified levels, relative to the size of the mesh, see simplifyMesh().
+constexpr float LOD_MAX_ERROR = 0.02f;
+
+struct LodLevel
+{
+    size_t FirstVertex;
+    size_t VertexCount;
+    size_t FirstIndex;
+    size_t IndexCount;
+};
+
+// Every detail level of a shape in one allocation: the vertices of all levels followed by all their indices. Level
+// 0 is the finest (tessellation levels - 1) and each following level halves the segment counts. The levels are
+// generated and run through optimizeMesh() in parallel; vertices a level doesn't reference are left unused between
+// levels.
+//
+// Chains of arbitrary meshes keep the mesh as level 0 and simplify it to a quarter of the triangles per level, one
+// level per thread. The chain ends early at the first level maxError doesn't let shrink by at least a quarter.
+class LodChain
+{
+   public:
+    LodChain() = default;
+    LodChain(const ParametricShape& shape, const int count);
+    LodChain(const Mesh& mesh, const int count, const float maxError = LOD_MAX_ERROR);
+
+    int GetLevelCount() const { return levelCount; }
+    const LodLevel& GetLevel(const int level) const { return levels[level]; }
+
+    const Vertex* GetVertices(const int level) const { return vertices + levels[level].FirstVertex; }
+    const unsigned int* GetIndices(const int level) const { return indices + levels[level].FirstIndex; }
+
+    // Copy of one level, e.g. for GeometryBuffer::Add().
+    Mesh GetMesh(const int level) const;
+
+   private:
+    std::unique_ptr<unsigned char[]> storage;
+    Vertex* vertices = nullptr;
+    unsigned int* indices = nullptr;
+
+    LodLevel levels[MAX_LOD_LEVELS] = {};
+    int levelCount = 0;
+};
+////////////////////////////////////////////////////////////////
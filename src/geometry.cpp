@@ -0,0 +1,244 @@
+#include "geometry.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstdint>
+
+#include "batch.h"
+#include "streaming_buffer.h"
+
+// First attribute location of the per-instance model matrix (4 slots) and normal matrix (3 slots).
+constexpr GLuint MODEL_LOCATION = 2;
+constexpr GLuint NORMAL_LOCATION = 6;
+
+GeometryBuffer::GeometryBuffer(GpuResourcePool& pool, StreamingBuffer& stream, const VertexFormat format)
+    : format(format),
+      VAO(pool),
+      vertices(pool, vertexSize(format)),
+      indices(pool, sizeof(unsigned int)),
+      stream(&stream)
+{
+    bindArenas();
+
+    glBindVertexArray(VAO.Get());
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+
+    // Matrices take one attribute slot per column. DrawInstanced() points them into the stream and enables them,
+    // before that they have no buffer to read from.
+    for (GLuint c = 0; c < 4; c++)
+    {
+        glVertexAttribDivisor(MODEL_LOCATION + c, 1);
+    }
+    for (GLuint c = 0; c < 3; c++)
+    {
+        glVertexAttribDivisor(NORMAL_LOCATION + c, 1);
+    }
+    glBindVertexArray(0);
+}
+
+MeshId GeometryBuffer::Add(const Mesh& mesh)
+{
+    return Add(mesh.Vertices.data(), mesh.Vertices.size(), mesh.Indices.data(), mesh.Indices.size());
+}
+
+MeshId GeometryBuffer::Add(const Vertex* vertices, const size_t vertexCount, const unsigned int* indices,
+                           const size_t indexCount)
+{
+    // Moving a Mesh keeps its storage, so the segment pointers survive the copies vector growing.
+    copies.push_back(Mesh{{vertices, vertices + vertexCount}, {indices, indices + indexCount}});
+    const auto& copy = copies.back();
+    return AddExternal(copy.Vertices.data(), vertexCount, copy.Indices.data(), indexCount);
+}
+
+MeshId GeometryBuffer::AddExternal(const Vertex* vertices, const size_t vertexCount, const unsigned int* indices,
+                                   const size_t indexCount)
+{
+    PositionDecode decode;
+    if (format != VertexFormat::FLOAT && vertexCount > 0)
+    {
+        decode = positionDecode(computeBounds(vertices, vertexCount));
+    }
+
+    const Entry entry{
+        this->vertices.Allocate(vertexCount),
+        this->indices.Allocate(indexCount),
+        static_cast<unsigned int>(indexCount),
+        decode,
+    };
+
+    MeshId mesh;
+    if (freeIds.empty())
+    {
+        mesh = static_cast<MeshId>(meshes.size());
+        meshes.push_back(entry);
+    }
+    else
+    {
+        mesh = freeIds.back();
+        freeIds.pop_back();
+        meshes[mesh] = entry;
+    }
+
+    pending.push_back(Segment{mesh, vertices, vertexCount, indices, indexCount});
+    return mesh;
+}
+
+void GeometryBuffer::Remove(const MeshId mesh)
+{
+    pending.erase(std::remove_if(pending.begin(), pending.end(),
+                                 [mesh](const Segment& segment) { return segment.Mesh == mesh; }),
+                  pending.end());
+
+    vertices.Free(meshes[mesh].Vertices);
+    indices.Free(meshes[mesh].Indices);
+    freeIds.push_back(mesh);
+}
+
+void GeometryBuffer::Upload()
+{
+    // Grown arenas come back in new buffers; only the VAO refers to them.
+    const bool verticesMoved = vertices.Commit();
+    const bool indicesMoved = indices.Commit();
+    if (verticesMoved || indicesMoved)
+    {
+        bindArenas();
+    }
+
+    // Every segment goes to the driver from where it lives, without gathering everything in one staging copy.
+    // Quantized formats encode one segment at a time.
+    std::vector<uint8_t> encoded;
+    for (const auto& segment : pending)
+    {
+        const auto& entry = meshes[segment.Mesh];
+        const void* data = segment.Vertices;
+        if (format != VertexFormat::FLOAT)
+        {
+            encoded.resize(segment.VertexCount * vertexSize(format));
+            encodeVertices(format, entry.Decode, segment.Vertices, segment.VertexCount, encoded.data());
+            data = encoded.data();
+        }
+
+        vertices.Write(entry.Vertices, data, segment.VertexCount);
+        indices.Write(entry.Indices, segment.Indices, segment.IndexCount);
+    }
+
+    // The driver has its own copy now.
+    pending.clear();
+    copies.clear();
+}
+
+void GeometryBuffer::Defragment()
+{
+    const bool verticesMoved = vertices.Defragment();
+    const bool indicesMoved = indices.Defragment();
+    if (verticesMoved || indicesMoved)
+    {
+        bindArenas();
+    }
+}
+
+DrawRange GeometryBuffer::GetDrawRange(const MeshId mesh) const
+{
+    const auto& entry = meshes[mesh];
+    return DrawRange{
+        static_cast<unsigned int>(indices.GetOffset(entry.Indices)),
+        entry.IndexCount,
+        static_cast<int>(vertices.GetOffset(entry.Vertices)),
+        entry.Decode,
+    };
+}
+
+void GeometryBuffer::Draw(const DrawRange& range) const
+{
+    glBindVertexArray(VAO.Get());
+    glDrawElementsBaseVertex(GL_TRIANGLES, range.IndexCount, GL_UNSIGNED_INT,
+                             (void*)(range.FirstIndex * sizeof(unsigned int)), range.BaseVertex);
+}
+
+void GeometryBuffer::DrawMulti(const DrawRange* ranges, const size_t n) const
+{
+    std::vector<GLsizei> counts(n);
+    std::vector<const void*> offsets(n);
+    std::vector<GLint> baseVertices(n);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        counts[i] = ranges[i].IndexCount;
+        offsets[i] = (void*)(ranges[i].FirstIndex * sizeof(unsigned int));
+        baseVertices[i] = ranges[i].BaseVertex;
+    }
+
+    glBindVertexArray(VAO.Get());
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts.data(), GL_UNSIGNED_INT, offsets.data(),
+                                  static_cast<GLsizei>(n), baseVertices.data());
+}
+
+void GeometryBuffer::DrawInstanced(const DrawRange& range, const mat4* models, const mat3* normals, const size_t n)
+{
+    if (n == 0)
+    {
+        return;
+    }
+
+    if (normals == nullptr)
+    {
+        normalScratch.resize(n);
+        normalMatrices(models, n, normalScratch.data());
+        normals = normalScratch.data();
+    }
+
+    // Both blocks go through the ring; the attributes are pointed at wherever they landed this time.
+    stream->Reserve(n * (sizeof(mat4) + sizeof(mat3)) + 32);
+    const size_t modelsOffset = stream->Write(models, n * sizeof(mat4));
+    const size_t normalsOffset = stream->Write(normals, n * sizeof(mat3));
+
+    glBindVertexArray(VAO.Get());
+    glBindBuffer(GL_ARRAY_BUFFER, stream->Get());
+    for (GLuint c = 0; c < 4; c++)
+    {
+        glVertexAttribPointer(MODEL_LOCATION + c, 4, GL_FLOAT, GL_FALSE, sizeof(mat4),
+                              (void*)(modelsOffset + c * sizeof(vec4)));
+        glEnableVertexAttribArray(MODEL_LOCATION + c);
+    }
+    for (GLuint c = 0; c < 3; c++)
+    {
+        glVertexAttribPointer(NORMAL_LOCATION + c, 3, GL_FLOAT, GL_FALSE, sizeof(mat3),
+                              (void*)(normalsOffset + c * sizeof(vec3)));
+        glEnableVertexAttribArray(NORMAL_LOCATION + c);
+    }
+
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, range.IndexCount, GL_UNSIGNED_INT,
+                                      (void*)(range.FirstIndex * sizeof(unsigned int)), static_cast<GLsizei>(n),
+                                      range.BaseVertex);
+}
+
+void GeometryBuffer::bindArenas()
+{
+    glBindVertexArray(VAO.Get());
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertices.Get());
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices.Get());
+
+    // Quantized positions stay integers (not normalized), positionScale in the shader covers the range. Octahedral
+    // normals are normalized to [-1, 1].
+    switch (format)
+    {
+    case VertexFormat::FLOAT:
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+        break;
+    case VertexFormat::QUANTIZED:
+        glVertexAttribPointer(0, 3, GL_SHORT, GL_FALSE, sizeof(QuantizedVertex), (void*)0);
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(QuantizedVertex),
+                              (void*)offsetof(QuantizedVertex, Normal));
+        break;
+    case VertexFormat::COMPACT:
+        glVertexAttribPointer(0, 3, GL_SHORT, GL_FALSE, sizeof(CompactVertex), (void*)0);
+        glVertexAttribPointer(1, 2, GL_BYTE, GL_TRUE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, Normal));
+        break;
+    }
+
+    glBindVertexArray(0);
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "gpu_arena.h"
+#include "gpu_pool.h"
+#include "mesh.h"
+#include "vertex_format.h"
+
+// Where one mesh lives inside a GeometryBuffer.
+struct DrawRange
+{
+    unsigned int FirstIndex;
+    unsigned int IndexCount;
+    int BaseVertex;
+    PositionDecode Decode;  // set as the positionScale and positionOffset uniforms when drawing
+};
+
+class StreamingBuffer;
+
+// A mesh in a GeometryBuffer. Its DrawRange changes when the buffer is defragmented, so shapes keep the id.
+using MeshId = unsigned int;
+
+// Packs the meshes of every shape into one vertex and one index GpuArena behind a single VAO. Meshes are added on
+// the CPU with Add() or AddExternal() and sent to the GPU together by Upload(), which can be called again after
+// adding more; Remove() gives a mesh's ranges back for reuse. Each mesh keeps its own 0-based indices and is drawn
+// with a base vertex, so switching shapes only changes the draw range. Vertices are stored in the buffer's
+// VertexFormat; quantized formats get their own position decode per mesh.
+//
+// The GL names come from pool, which must outlive the buffer, and go back to it with the buffer. Shapes point at
+// the buffer holding their meshes, so it is move-only and should stay where it is once shapes are added.
+class GeometryBuffer
+{
+   public:
+    // Instance data is written to stream, which must outlive the buffer.
+    GeometryBuffer(GpuResourcePool& pool, StreamingBuffer& stream, const VertexFormat format = VertexFormat::FLOAT);
+
+    GeometryBuffer(GeometryBuffer&& other) noexcept = default;
+    GeometryBuffer& operator=(GeometryBuffer&& other) noexcept = default;
+    GeometryBuffer(const GeometryBuffer&) = delete;
+    GeometryBuffer& operator=(const GeometryBuffer&) = delete;
+
+    MeshId Add(const Mesh& mesh);
+    MeshId Add(const Vertex* vertices, const size_t vertexCount, const unsigned int* indices, const size_t indexCount);
+
+    // Like Add() without the copy: Upload() reads the data where it is, e.g. straight from a mapped MeshFile, so
+    // it must stay valid until then.
+    MeshId AddExternal(const Vertex* vertices, const size_t vertexCount, const unsigned int* indices,
+                       const size_t indexCount);
+
+    // The id may be reused by the next Add(). Draws already submitted are unaffected.
+    void Remove(const MeshId mesh);
+
+    // Writes the meshes added since the last call, growing the arenas first if they need it.
+    void Upload();
+
+    // Packs the meshes to the front of the arenas so the free space is one block again. Must follow Upload().
+    void Defragment();
+
+    DrawRange GetDrawRange(const MeshId mesh) const;
+
+    VertexFormat GetFormat() const { return format; }
+    // Bytes of vertex data on the GPU after Upload().
+    size_t GetVertexBytes() const { return vertices.GetStats().Used; }
+    ArenaStats GetVertexStats() const { return vertices.GetStats(); }
+    ArenaStats GetIndexStats() const { return indices.GetStats(); }
+
+    void Draw(const DrawRange& range) const;
+
+    // All ranges in one glMultiDrawElementsBaseVertex call. The ranges share one set of uniforms, so in a quantized
+    // buffer they must have the same Decode.
+    void DrawMulti(const DrawRange* ranges, const size_t n) const;
+
+    // Draws n instances of range with one call. The matrices are written to the StreamingBuffer and read by the
+    // *_instanced.vs shaders: model at locations 2-5, normal matrix at 6-8. When normals is null they are computed
+    // from the models with normalMatrices().
+    void DrawInstanced(const DrawRange& range, const mat4* models, const mat3* normals, const size_t n);
+
+   private:
+    VertexFormat format;
+    PooledVertexArray VAO;
+    GpuArena vertices, indices;
+
+    StreamingBuffer* stream;
+    std::vector<mat3> normalScratch;
+
+    // Points the VAO at the arenas' current buffers.
+    void bindArenas();
+
+    struct Entry
+    {
+        ArenaHandle Vertices;
+        ArenaHandle Indices;
+        unsigned int IndexCount;
+        PositionDecode Decode;
+    };
+    std::vector<Entry> meshes;
+    std::vector<MeshId> freeIds;
+
+    // Meshes waiting for Upload(). Added meshes point into copies, external ones into the caller's memory.
+    struct Segment
+    {
+        MeshId Mesh;
+        const Vertex* Vertices;
+        size_t VertexCount;
+        const unsigned int* Indices;
+        size_t IndexCount;
+    };
+    std::vector<Segment> pending;
+    std::vector<Mesh> copies;
+};
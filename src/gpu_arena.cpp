@@ -0,0 +1,107 @@
+#include "gpu_arena.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cassert>
+
+GpuArena::GpuArena(GpuResourcePool& pool, const size_t unitSize) : pool(&pool), unitSize(unitSize), buffer(pool) {}
+
+ArenaHandle GpuArena::Allocate(const size_t units)
+{
+    ArenaHandle handle = allocator.Allocate(static_cast<uint32_t>(units));
+    if (handle == ARENA_NONE)
+    {
+        // Doubling keeps the number of reallocations logarithmic in the final size.
+        allocator.Grow(arenaGrowCapacity(allocator.GetCapacity(), static_cast<uint32_t>(units), ARENA_MIN_UNITS));
+        handle = allocator.Allocate(static_cast<uint32_t>(units));
+    }
+    assert(handle != ARENA_NONE && "Arena allocation failed after growing");
+    return handle;
+}
+
+void GpuArena::Free(const ArenaHandle handle) { allocator.Free(handle); }
+
+bool GpuArena::Commit()
+{
+    if (allocator.GetCapacity() == bufferUnits)
+    {
+        return false;
+    }
+    moves.clear();
+    replaceBuffer();
+    return true;
+}
+
+bool GpuArena::Defragment()
+{
+    moves.clear();
+    allocator.Defragment(moves);
+    if (moves.empty() && allocator.GetCapacity() == bufferUnits)
+    {
+        return false;
+    }
+
+    // Ranges that stay put are copied along with the moved ones.
+    std::vector<ArenaMove> moved;
+    moved.swap(moves);
+    uint32_t offset = 0;
+    for (const auto& move : moved)
+    {
+        if (move.To > offset)
+        {
+            moves.push_back(ArenaMove{offset, offset, move.To - offset});
+        }
+        moves.push_back(move);
+        offset = move.To + move.Size;
+    }
+    const auto used = static_cast<uint32_t>(allocator.GetStats().Used);
+    if (used > offset)
+    {
+        moves.push_back(ArenaMove{offset, offset, used - offset});
+    }
+
+    replaceBuffer();
+    return true;
+}
+
+void GpuArena::Write(const ArenaHandle handle, const void* data, const size_t units)
+{
+    // The copy targets leave the vertex array state alone, unlike binding an element buffer.
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.Get());
+    glBufferSubData(GL_COPY_WRITE_BUFFER, allocator.GetOffset(handle) * unitSize, units * unitSize, data);
+}
+
+ArenaStats GpuArena::GetStats() const
+{
+    auto stats = allocator.GetStats();
+    stats.Capacity *= unitSize;
+    stats.Used *= unitSize;
+    stats.LargestFree *= unitSize;
+    return stats;
+}
+
+void GpuArena::replaceBuffer()
+{
+    PooledBuffer replacement{*pool, allocator.GetCapacity() * unitSize};
+    replacement.Reserve(GL_COPY_WRITE_BUFFER, allocator.GetCapacity() * unitSize, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer.Get());
+
+    if (moves.empty() && bufferUnits > 0)
+    {
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, bufferUnits * unitSize);
+    }
+    for (const auto& move : moves)
+    {
+        // Ranges allocated since the last Commit() have nothing on the GPU yet, past the end of the old buffer.
+        if (move.From < bufferUnits)
+        {
+            const size_t units = std::min<size_t>(move.Size, bufferUnits - move.From);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, move.From * unitSize, move.To * unitSize,
+                                units * unitSize);
+        }
+    }
+
+    buffer = std::move(replacement);
+    bufferUnits = allocator.GetCapacity();
+}
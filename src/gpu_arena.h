@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "gpu_pool.h"
+#include "range_allocator.h"
+
+/////////////////////////// GPU arena ///////////////////////////
+// One large GL buffer sub-allocated with a RangeAllocator, in units of unitSize bytes (a vertex, an index), so a
+// range's offset in units is directly a base vertex or first index. Allocate() only does the bookkeeping and grows
+// the capacity as needed; Commit() brings the buffer to that capacity in one reallocation, copying what it held on
+// the GPU. Defragment() packs the ranges the same way, into a fresh buffer with glCopyBufferSubData().
+//
+// Growing and defragmenting replace the buffer, so whoever binds it (a vertex array) must bind Get() again when they
+// return true. Both briefly hold the old and the new storage.
+constexpr size_t ARENA_MIN_UNITS = 1 << 12;
+
+class GpuArena
+{
+   public:
+    GpuArena(GpuResourcePool& pool, const size_t unitSize);
+
+    ArenaHandle Allocate(const size_t units);
+    void Free(const ArenaHandle handle);
+    size_t GetOffset(const ArenaHandle handle) const { return allocator.GetOffset(handle); }
+
+    // True when the buffer was replaced.
+    bool Commit();
+    bool Defragment();
+
+    // Writes units starting at the range's first unit; the buffer must be committed.
+    void Write(const ArenaHandle handle, const void* data, const size_t units);
+
+    unsigned int Get() const { return buffer.Get(); }
+    size_t GetUnitSize() const { return unitSize; }
+    // In bytes.
+    ArenaStats GetStats() const;
+
+   private:
+    GpuResourcePool* pool;
+    size_t unitSize;
+    RangeAllocator allocator;
+    PooledBuffer buffer;
+    size_t bufferUnits = 0;
+    std::vector<ArenaMove> moves;
+
+    // Copies the ranges in moves, or everything up to bufferUnits when moves is empty, into a new buffer of the
+    // allocator's capacity.
+    void replaceBuffer();
+};
+////////////////////////////////////////////////////////////////
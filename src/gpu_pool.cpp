@@ -0,0 +1,204 @@
+#include "gpu_pool.h"
+
+#include <glad/glad.h>
+
+#include <cassert>
+#include <utility>
+
+GpuResourcePool::~GpuResourcePool()
+{
+    for (const auto& [buffer, capacity] : capacities)
+    {
+        glDeleteBuffers(1, &buffer);
+    }
+    glDeleteVertexArrays(static_cast<GLsizei>(vertexArrays.size()), vertexArrays.data());
+}
+
+unsigned int GpuResourcePool::AcquireBuffer(const size_t bytes)
+{
+    buffersInUse++;
+    if (freeBuffers.empty())
+    {
+        GLuint buffer;
+        glGenBuffers(1, &buffer);
+        capacities.emplace(buffer, 0);
+        return buffer;
+    }
+
+    // Smallest storage that fits, or the largest one when none does: it grows from the closest size.
+    size_t best = 0;
+    for (size_t i = 1; i < freeBuffers.size(); i++)
+    {
+        const size_t capacity = capacities[freeBuffers[i]];
+        const size_t bestCapacity = capacities[freeBuffers[best]];
+        const bool fits = capacity >= bytes;
+        const bool bestFits = bestCapacity >= bytes;
+        if (fits != bestFits ? fits : (fits ? capacity < bestCapacity : capacity > bestCapacity))
+        {
+            best = i;
+        }
+    }
+
+    const unsigned int buffer = freeBuffers[best];
+    freeBuffers[best] = freeBuffers.back();
+    freeBuffers.pop_back();
+
+    const size_t capacity = capacities[buffer];
+    bytesCached -= capacity;
+    bytesInUse += capacity;
+    return buffer;
+}
+
+void GpuResourcePool::ReleaseBuffer(const unsigned int buffer)
+{
+    assert(buffersInUse > 0 && "Buffer released twice");
+    buffersInUse--;
+
+    auto& capacity = capacities.at(buffer);
+    bytesInUse -= capacity;
+    if (bytesCached + capacity > POOL_MAX_CACHED_BYTES)
+    {
+        // GL_COPY_WRITE_BUFFER has no meaning for drawing, binding to it leaves the vertex array state alone.
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, 0, nullptr, GL_STATIC_DRAW);
+        capacity = 0;
+    }
+    bytesCached += capacity;
+    freeBuffers.push_back(buffer);
+}
+
+bool GpuResourcePool::Reserve(const unsigned int buffer, const unsigned int target, const size_t bytes,
+                              const unsigned int usage)
+{
+    glBindBuffer(target, buffer);
+
+    auto& capacity = capacities.at(buffer);
+    if (capacity >= bytes && capacity / 2 <= bytes)
+    {
+        return false;
+    }
+
+    glBufferData(target, bytes, nullptr, usage);
+    bytesInUse = bytesInUse - capacity + bytes;
+    capacity = bytes;
+    return true;
+}
+
+size_t GpuResourcePool::GetCapacity(const unsigned int buffer) const { return capacities.at(buffer); }
+
+unsigned int GpuResourcePool::AcquireVertexArray()
+{
+    vertexArraysInUse++;
+    if (freeVertexArrays.empty())
+    {
+        GLuint vertexArray;
+        glGenVertexArrays(1, &vertexArray);
+        vertexArrays.push_back(vertexArray);
+        return vertexArray;
+    }
+
+    const unsigned int vertexArray = freeVertexArrays.back();
+    freeVertexArrays.pop_back();
+    return vertexArray;
+}
+
+void GpuResourcePool::ReleaseVertexArray(const unsigned int vertexArray)
+{
+    assert(vertexArraysInUse > 0 && "Vertex array released twice");
+    vertexArraysInUse--;
+
+    if (maxAttributes == 0)
+    {
+        glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &maxAttributes);
+    }
+
+    // Back to the state of a new name, so the next owner only sets up what it uses.
+    glBindVertexArray(vertexArray);
+    for (GLint a = 0; a < maxAttributes; a++)
+    {
+        glDisableVertexAttribArray(a);
+        glVertexAttribDivisor(a, 0);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    freeVertexArrays.push_back(vertexArray);
+}
+
+GpuPoolStats GpuResourcePool::GetStats() const
+{
+    return GpuPoolStats{
+        buffersInUse, vertexArraysInUse, freeBuffers.size(), freeVertexArrays.size(), bytesInUse, bytesCached,
+    };
+}
+
+/////////////////////////// Handles ////////////////////////////
+PooledBuffer::PooledBuffer(GpuResourcePool& pool, const size_t bytes) : pool(&pool), name(pool.AcquireBuffer(bytes))
+{
+}
+
+PooledBuffer::~PooledBuffer() { release(); }
+
+PooledBuffer::PooledBuffer(PooledBuffer&& other) noexcept
+    : pool(std::exchange(other.pool, nullptr)), name(std::exchange(other.name, 0))
+{
+}
+
+PooledBuffer& PooledBuffer::operator=(PooledBuffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        pool = std::exchange(other.pool, nullptr);
+        name = std::exchange(other.name, 0);
+    }
+    return *this;
+}
+
+bool PooledBuffer::Reserve(const unsigned int target, const size_t bytes, const unsigned int usage)
+{
+    return pool->Reserve(name, target, bytes, usage);
+}
+
+size_t PooledBuffer::GetCapacity() const { return pool != nullptr ? pool->GetCapacity(name) : 0; }
+
+void PooledBuffer::release()
+{
+    if (pool != nullptr)
+    {
+        pool->ReleaseBuffer(name);
+        pool = nullptr;
+        name = 0;
+    }
+}
+
+PooledVertexArray::PooledVertexArray(GpuResourcePool& pool) : pool(&pool), name(pool.AcquireVertexArray()) {}
+
+PooledVertexArray::~PooledVertexArray() { release(); }
+
+PooledVertexArray::PooledVertexArray(PooledVertexArray&& other) noexcept
+    : pool(std::exchange(other.pool, nullptr)), name(std::exchange(other.name, 0))
+{
+}
+
+PooledVertexArray& PooledVertexArray::operator=(PooledVertexArray&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        pool = std::exchange(other.pool, nullptr);
+        name = std::exchange(other.name, 0);
+    }
+    return *this;
+}
+
+void PooledVertexArray::release()
+{
+    if (pool != nullptr)
+    {
+        pool->ReleaseVertexArray(name);
+        pool = nullptr;
+        name = 0;
+    }
+}
+////////////////////////////////////////////////////////////////
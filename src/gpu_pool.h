@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+/////////////////////////// GPU resource pool ///////////////////
+// Hands out GL buffer and vertex array names and takes them back for reuse, so objects that come and go every frame
+// don't turn into glGen*/glDelete* calls. Released buffers keep their storage, up to POOL_MAX_CACHED_BYTES in total,
+// and AcquireBuffer() prefers one whose storage already fits, so a recycled buffer usually needs no reallocation
+// either. The pool deletes every name it created when it goes, so it must outlive the handles below and the GL
+// context must outlive the pool.
+constexpr size_t POOL_MAX_CACHED_BYTES = 64 << 20;
+
+struct GpuPoolStats
+{
+    size_t Buffers;       // in use
+    size_t VertexArrays;  // in use
+    size_t FreeBuffers;
+    size_t FreeVertexArrays;
+    size_t BytesInUse;   // storage of the buffers in use
+    size_t BytesCached;  // storage kept by free buffers
+};
+
+class GpuResourcePool
+{
+   public:
+    GpuResourcePool() = default;
+    ~GpuResourcePool();
+
+    // Handles point at their pool.
+    GpuResourcePool(const GpuResourcePool&) = delete;
+    GpuResourcePool& operator=(const GpuResourcePool&) = delete;
+
+    // A free buffer with storage for at least bytes if there is one, the smallest such; otherwise the one with the
+    // most storage, or a new name.
+    unsigned int AcquireBuffer(const size_t bytes = 0);
+    void ReleaseBuffer(const unsigned int buffer);
+
+    // Gives buffer, bound to target, storage for bytes with glBufferData() unless it already has between bytes and
+    // twice as many. Returns true when the storage was reallocated and its contents are undefined.
+    bool Reserve(const unsigned int buffer, const unsigned int target, const size_t bytes, const unsigned int usage);
+    size_t GetCapacity(const unsigned int buffer) const;
+
+    // Vertex arrays come back with every attribute disabled and no element buffer bound.
+    unsigned int AcquireVertexArray();
+    void ReleaseVertexArray(const unsigned int vertexArray);
+
+    GpuPoolStats GetStats() const;
+
+   private:
+    std::unordered_map<unsigned int, size_t> capacities;  // every buffer name the pool created
+    std::vector<unsigned int> freeBuffers;
+    std::vector<unsigned int> vertexArrays;  // every vertex array name the pool created
+    std::vector<unsigned int> freeVertexArrays;
+    size_t buffersInUse = 0;
+    size_t vertexArraysInUse = 0;
+    size_t bytesInUse = 0;
+    size_t bytesCached = 0;
+    int maxAttributes = 0;
+};
+
+// Move-only owners of one pooled name, given back to the pool on destruction. Default constructed handles own
+// nothing.
+class PooledBuffer
+{
+   public:
+    PooledBuffer() = default;
+    explicit PooledBuffer(GpuResourcePool& pool, const size_t bytes = 0);
+    ~PooledBuffer();
+
+    PooledBuffer(PooledBuffer&& other) noexcept;
+    PooledBuffer& operator=(PooledBuffer&& other) noexcept;
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+    unsigned int Get() const { return name; }
+
+    // See GpuResourcePool::Reserve().
+    bool Reserve(const unsigned int target, const size_t bytes, const unsigned int usage);
+    size_t GetCapacity() const;
+
+   private:
+    GpuResourcePool* pool = nullptr;
+    unsigned int name = 0;
+
+    void release();
+};
+
+class PooledVertexArray
+{
+   public:
+    PooledVertexArray() = default;
+    explicit PooledVertexArray(GpuResourcePool& pool);
+    ~PooledVertexArray();
+
+    PooledVertexArray(PooledVertexArray&& other) noexcept;
+    PooledVertexArray& operator=(PooledVertexArray&& other) noexcept;
+    PooledVertexArray(const PooledVertexArray&) = delete;
+    PooledVertexArray& operator=(const PooledVertexArray&) = delete;
+
+    unsigned int Get() const { return name; }
+
+   private:
+    GpuResourcePool* pool = nullptr;
+    unsigned int name = 0;
+
+    void release();
+};
+////////////////////////////////////////////////////////////////
@@ -0,0 +1,1607 @@
+#include "importer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <utility>
+
+#include "mapped_file.h"
+#include "normals.h"
+#include "parallel.h"
+
+static_assert(sizeof(Vertex) == 6 * sizeof(float), "binary fast paths copy whole Vertex records");
+
+// Text is parsed in chunks of at least this many bytes, a few per hardware thread so uneven chunks even out.
+constexpr size_t MIN_CHUNK = 1 << 20;
+constexpr size_t CHUNKS_PER_THREAD = 4;
+// Items per thread for the per-vertex and per-triangle passes.
+constexpr size_t MIN_RANGE = 1 << 16;
+
+constexpr uint32_t NONE = ~0u;
+
+/////////////////////////// Text parsing ////////////////////////
+static bool isDigit(const char c) { return static_cast<unsigned char>(c - '0') < 10; }
+static bool isBlank(const char c) { return c == ' ' || c == '\t'; }
+static bool isSpace(const char c) { return isBlank(c) || c == '\n' || c == '\r' || c == '\v' || c == '\f'; }
+
+static const char* skipBlanks(const char* p, const char* end)
+{
+    while (p < end && isBlank(*p))
+    {
+        p++;
+    }
+    return p;
+}
+
+static const char* skipSpaces(const char* p, const char* end)
+{
+    while (p < end && isSpace(*p))
+    {
+        p++;
+    }
+    return p;
+}
+
+static const char* nextLine(const char* p, const char* end)
+{
+    const auto* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    return newline != nullptr ? newline + 1 : end;
+}
+
+static bool atLineEnd(const char* p, const char* end) { return p == end || *p == '\n' || *p == '\r' || *p == '#'; }
+
+// Returns whether [p, end) starts with the word, followed by whitespace or the end.
+static bool startsWithWord(const char* p, const char* end, const char* word)
+{
+    const size_t length = std::strlen(word);
+    return static_cast<size_t>(end - p) >= length && std::memcmp(p, word, length) == 0 &&
+           (p + length == end || isSpace(p[length]));
+}
+
+// strtod() on a copy of the token, for what the fast path can't round exactly (very long mantissas, large exponents,
+// nan and inf).
+static const char* parseFloatSlow(const char* p, const char* end, float& out)
+{
+    const char* tokenEnd = p;
+    while (tokenEnd < end && !isSpace(*tokenEnd))
+    {
+        tokenEnd++;
+    }
+
+    const std::string token{p, tokenEnd};
+    char* stop = nullptr;
+    const double value = std::strtod(token.c_str(), &stop);
+    if (stop == token.c_str())
+    {
+        return nullptr;
+    }
+    out = static_cast<float>(value);
+    return p + (stop - token.c_str());
+}
+
+// Decimal to float without locales or allocation. Mantissas up to 2^53 scaled by exact powers of ten up to 1e22 give
+// the correctly rounded double, which is then rounded to float; everything else goes through strtod(). Returns the
+// position after the number or null when there is none.
+static const char* parseFloat(const char* p, const char* end, float& out)
+{
+    static constexpr double POW10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                       1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+    const char* start = p;
+    const bool negative = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        p++;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;  // significant digits in the mantissa, leading zeros don't count
+    int exponent = 0;
+    bool any = false;
+
+    for (; p < end && isDigit(*p); p++)
+    {
+        any = true;
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+            digits += mantissa != 0;
+        }
+        else
+        {
+            exponent++;
+        }
+    }
+    if (p < end && *p == '.')
+    {
+        for (p++; p < end && isDigit(*p); p++)
+        {
+            any = true;
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += mantissa != 0;
+                exponent--;
+            }
+        }
+    }
+    if (!any)
+    {
+        return parseFloatSlow(start, end, out);
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char* q = p + 1;
+        const bool negativeExponent = q < end && *q == '-';
+        if (q < end && (*q == '-' || *q == '+'))
+        {
+            q++;
+        }
+        if (q < end && isDigit(*q))
+        {
+            int e = 0;
+            for (; q < end && isDigit(*q); q++)
+            {
+                e = std::min(e * 10 + (*q - '0'), 100000);
+            }
+            exponent += negativeExponent ? -e : e;
+            p = q;
+        }
+    }
+
+    if (mantissa > (uint64_t{1} << 53) || exponent < -22 || exponent > 22)
+    {
+        return parseFloatSlow(start, end, out);
+    }
+
+    const double value = exponent < 0 ? static_cast<double>(mantissa) / POW10[-exponent]
+                                       : static_cast<double>(mantissa) * POW10[exponent];
+    out = static_cast<float>(negative ? -value : value);
+    return p;
+}
+
+static const char* parseInt(const char* p, const char* end, int64_t& out)
+{
+    const bool negative = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        p++;
+    }
+    if (p == end || !isDigit(*p))
+    {
+        return nullptr;
+    }
+
+    int64_t value = 0;
+    for (; p < end && isDigit(*p); p++)
+    {
+        // Saturates instead of overflowing, anything this large is out of range for an index anyway.
+        value = value < (int64_t{1} << 40) ? value * 10 + (*p - '0') : value;
+    }
+    out = negative ? -value : value;
+    return p;
+}
+
+static const char* parseVec3(const char* p, const char* end, vec3& out)
+{
+    for (int i = 0; i < 3 && p != nullptr; i++)
+    {
+        p = parseFloat(skipBlanks(p, end), end, out[i]);
+    }
+    return p;
+}
+
+// Chunk boundaries in [begin, end): every chunk but the last ends right after a '\n'.
+static std::vector<const char*> splitLines(const char* begin, const char* end)
+{
+    const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t size = end - begin;
+    const size_t chunkSize = std::max(MIN_CHUNK, size / (threads * CHUNKS_PER_THREAD) + 1);
+
+    std::vector<const char*> bounds{begin};
+    while (static_cast<size_t>(end - bounds.back()) > chunkSize)
+    {
+        bounds.push_back(nextLine(bounds.back() + chunkSize, end));
+    }
+    if (bounds.back() != end)
+    {
+        bounds.push_back(end);
+    }
+    return bounds;
+}
+
+static std::string errorAt(const char* message, const char* data, const char* p)
+{
+    return std::string{message} + " at byte " + std::to_string(p - data);
+}
+////////////////////////////////////////////////////////////////
+
+/////////////////////////// OBJ /////////////////////////////////
+struct ObjCorner
+{
+    uint32_t Position;
+    uint32_t Normal;  // NONE when the corner has no normal
+};
+
+struct ObjChunk
+{
+    std::vector<vec3> Positions;
+    std::vector<vec3> Normals;
+    std::vector<ObjCorner> Corners;  // three per triangle
+
+    // Corners written with negative indices hold chunk-local indices until the chunk's offset is known.
+    std::vector<size_t> RelativePositions;
+    std::vector<size_t> RelativeNormals;
+
+    const char* Error = nullptr;
+    const char* ErrorPosition = nullptr;
+};
+
+struct ObjFaceCorner
+{
+    ObjCorner Corner;
+    bool RelativePosition;
+    bool RelativeNormal;
+};
+
+// OBJ indices start at 1, negative ones count back from the last element defined before the face.
+static bool objIndex(const int64_t value, const size_t defined, uint32_t& out, bool& relative)
+{
+    relative = value < 0;
+    if (value > 0 && value <= int64_t{NONE})
+    {
+        out = static_cast<uint32_t>(value - 1);
+        return true;
+    }
+    if (value < 0)
+    {
+        // May wrap below zero when the element is in an earlier chunk, adding the chunk's offset wraps it back.
+        out = static_cast<uint32_t>(static_cast<int64_t>(defined) + value);
+        return true;
+    }
+    return false;
+}
+
+static void pushObjCorner(ObjChunk& chunk, const ObjFaceCorner& c)
+{
+    if (c.RelativePosition)
+    {
+        chunk.RelativePositions.push_back(chunk.Corners.size());
+    }
+    if (c.RelativeNormal)
+    {
+        chunk.RelativeNormals.push_back(chunk.Corners.size());
+    }
+    chunk.Corners.push_back(c.Corner);
+}
+
+// Parses the corners after "f" as v, v/vt, v//vn or v/vt/vn and triangulates the polygon as a fan.
+static const char* parseObjFace(const char* p, const char* end, ObjChunk& chunk)
+{
+    ObjFaceCorner first{}, previous{};
+    int count = 0;
+
+    for (p = skipBlanks(p, end); !atLineEnd(p, end); p = skipBlanks(p, end))
+    {
+        ObjFaceCorner c{{NONE, NONE}, false, false};
+        int64_t value;
+
+        p = parseInt(p, end, value);
+        if (p == nullptr || !objIndex(value, chunk.Positions.size(), c.Corner.Position, c.RelativePosition))
+        {
+            return nullptr;
+        }
+        if (p < end && *p == '/')
+        {
+            // Texture coordinate, ignored.
+            if (++p < end && *p != '/' && (p = parseInt(p, end, value)) == nullptr)
+            {
+                return nullptr;
+            }
+            if (p < end && *p == '/')
+            {
+                p = parseInt(p + 1, end, value);
+                if (p == nullptr || !objIndex(value, chunk.Normals.size(), c.Corner.Normal, c.RelativeNormal))
+                {
+                    return nullptr;
+                }
+            }
+        }
+        if (p < end && !isSpace(*p))
+        {
+            return nullptr;
+        }
+
+        if (count == 0)
+        {
+            first = c;
+        }
+        else if (count >= 2)
+        {
+            pushObjCorner(chunk, first);
+            pushObjCorner(chunk, previous);
+            pushObjCorner(chunk, c);
+        }
+        previous = c;
+        count++;
+    }
+
+    return count >= 3 ? p : nullptr;
+}
+
+static void parseObjChunk(const char* p, const char* end, ObjChunk& chunk)
+{
+    for (; p < end; p = nextLine(p, end))
+    {
+        p = skipBlanks(p, end);
+        const char* line = p;
+
+        if (end - p >= 2 && p[0] == 'v' && isBlank(p[1]))
+        {
+            chunk.Positions.emplace_back();
+            p = parseVec3(p + 2, end, chunk.Positions.back());
+        }
+        else if (end - p >= 3 && p[0] == 'v' && p[1] == 'n' && isBlank(p[2]))
+        {
+            chunk.Normals.emplace_back();
+            p = parseVec3(p + 3, end, chunk.Normals.back());
+        }
+        else if (end - p >= 2 && p[0] == 'f' && isBlank(p[1]))
+        {
+            p = parseObjFace(p + 2, end, chunk);
+        }
+
+        if (p == nullptr)
+        {
+            chunk.Error = line[0] == 'f' ? "Malformed face" : "Malformed vertex";
+            chunk.ErrorPosition = line;
+            return;
+        }
+    }
+}
+
+// Maps (position, normal) index pairs to vertices, for files where the same position appears with several normals.
+class ObjVertexMap
+{
+   public:
+    explicit ObjVertexMap(const size_t expected)
+    {
+        size_t capacity = 16;
+        while (capacity < expected * 2)
+        {
+            capacity *= 2;
+        }
+        keys.assign(capacity, EMPTY);
+        values.resize(capacity);
+    }
+
+    // Returns the vertex of the pair, adding it to mesh when it's new.
+    unsigned int Find(const ObjCorner& c, const std::vector<vec3>& positions, const std::vector<vec3>& normals,
+                      Mesh& mesh)
+    {
+        const uint64_t key = uint64_t{c.Position} << 32 | c.Normal;
+        const size_t mask = keys.size() - 1;
+
+        size_t slot = hash(key) & mask;
+        while (keys[slot] != EMPTY && keys[slot] != key)
+        {
+            slot = (slot + 1) & mask;
+        }
+        if (keys[slot] == key)
+        {
+            return values[slot];
+        }
+
+        keys[slot] = key;
+        values[slot] = static_cast<unsigned int>(mesh.Vertices.size());
+        mesh.Vertices.push_back(Vertex{positions[c.Position], c.Normal != NONE ? normals[c.Normal] : vec3{0.0f}});
+
+        if (mesh.Vertices.size() * 2 > keys.size())
+        {
+            grow();
+        }
+        return static_cast<unsigned int>(mesh.Vertices.size() - 1);
+    }
+
+   private:
+    static constexpr uint64_t EMPTY = ~uint64_t{0};
+
+    std::vector<uint64_t> keys;
+    std::vector<unsigned int> values;
+
+    static size_t hash(uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        return static_cast<size_t>(h);
+    }
+
+    void grow()
+    {
+        std::vector<uint64_t> oldKeys(keys.size() * 2, EMPTY);
+        std::vector<unsigned int> oldValues(values.size() * 2);
+        oldKeys.swap(keys);
+        oldValues.swap(values);
+
+        const size_t mask = keys.size() - 1;
+        for (size_t i = 0; i < oldKeys.size(); i++)
+        {
+            if (oldKeys[i] != EMPTY)
+            {
+                size_t slot = hash(oldKeys[i]) & mask;
+                while (keys[slot] != EMPTY)
+                {
+                    slot = (slot + 1) & mask;
+                }
+                keys[slot] = oldKeys[i];
+                values[slot] = oldValues[i];
+            }
+        }
+    }
+};
+
+bool importObj(const char* data, const size_t size, Mesh& mesh, std::string& error)
+{
+    const auto bounds = splitLines(data, data + size);
+    const size_t chunkCount = bounds.size() - 1;
+
+    std::vector<ObjChunk> chunks(chunkCount);
+    parallelFor(chunkCount, 1, [&](const size_t begin, const size_t end) {
+        for (size_t c = begin; c < end; c++)
+        {
+            parseObjChunk(bounds[c], bounds[c + 1], chunks[c]);
+        }
+    });
+
+    // Offsets of every chunk's elements in the whole file.
+    std::vector<size_t> positionBase(chunkCount + 1), normalBase(chunkCount + 1), cornerBase(chunkCount + 1);
+    for (size_t c = 0; c < chunkCount; c++)
+    {
+        if (chunks[c].Error != nullptr)
+        {
+            error = errorAt(chunks[c].Error, data, chunks[c].ErrorPosition);
+            return false;
+        }
+        positionBase[c + 1] = positionBase[c] + chunks[c].Positions.size();
+        normalBase[c + 1] = normalBase[c] + chunks[c].Normals.size();
+        cornerBase[c + 1] = cornerBase[c] + chunks[c].Corners.size();
+    }
+
+    const size_t positionCount = positionBase[chunkCount];
+    const size_t normalCount = normalBase[chunkCount];
+    const size_t cornerCount = cornerBase[chunkCount];
+    if (cornerCount == 0)
+    {
+        error = "No faces";
+        return false;
+    }
+    if (positionCount >= NONE || normalCount >= NONE)
+    {
+        error = "Too many vertices";
+        return false;
+    }
+
+    std::vector<vec3> positions(positionCount), normals(normalCount);
+    std::atomic<bool> outOfRange{false};
+    std::atomic<bool> anyNormals{false};
+    std::atomic<bool> sharedIndices{positionCount == normalCount};
+
+    // Gathers the elements, resolves relative indices and checks what the fast paths need.
+    parallelFor(chunkCount, 1, [&](const size_t begin, const size_t end) {
+        for (size_t c = begin; c < end; c++)
+        {
+            auto& chunk = chunks[c];
+            std::copy(chunk.Positions.begin(), chunk.Positions.end(), positions.begin() + positionBase[c]);
+            std::copy(chunk.Normals.begin(), chunk.Normals.end(), normals.begin() + normalBase[c]);
+
+            for (const auto i : chunk.RelativePositions)
+            {
+                chunk.Corners[i].Position += static_cast<uint32_t>(positionBase[c]);
+            }
+            for (const auto i : chunk.RelativeNormals)
+            {
+                chunk.Corners[i].Normal += static_cast<uint32_t>(normalBase[c]);
+            }
+
+            bool any = false, shared = true, bad = false;
+            for (const auto& corner : chunk.Corners)
+            {
+                bad |= corner.Position >= positionCount || (corner.Normal != NONE && corner.Normal >= normalCount);
+                any |= corner.Normal != NONE;
+                shared &= corner.Position == corner.Normal;
+            }
+            if (bad)
+            {
+                outOfRange = true;
+            }
+            if (any)
+            {
+                anyNormals = true;
+            }
+            if (!shared)
+            {
+                sharedIndices = false;
+            }
+
+            chunk.Positions = {};
+            chunk.Normals = {};
+        }
+    });
+
+    if (outOfRange)
+    {
+        error = "Face index out of range";
+        return false;
+    }
+
+    mesh.Vertices.clear();
+    mesh.Indices.resize(cornerCount);
+
+    const bool noNormals = !anyNormals;
+    if (noNormals || sharedIndices)
+    {
+        // Every position is a vertex, either without normals or with the normal of the same index.
+        mesh.Vertices.resize(positionCount);
+        parallelFor(positionCount, MIN_RANGE, [&](const size_t begin, const size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                mesh.Vertices[i] = Vertex{positions[i], noNormals ? vec3{0.0f} : normals[i]};
+            }
+        });
+        parallelFor(chunkCount, 1, [&](const size_t begin, const size_t end) {
+            for (size_t c = begin; c < end; c++)
+            {
+                auto* out = mesh.Indices.data() + cornerBase[c];
+                for (const auto& corner : chunks[c].Corners)
+                {
+                    *out++ = corner.Position;
+                }
+            }
+        });
+    }
+    else
+    {
+        // Corners without a normal become vertices with a zero normal.
+        mesh.Vertices.reserve(positionCount);
+        ObjVertexMap map{positionCount};
+        auto* out = mesh.Indices.data();
+        for (const auto& chunk : chunks)
+        {
+            for (const auto& corner : chunk.Corners)
+            {
+                *out++ = map.Find(corner, positions, normals, mesh);
+            }
+        }
+    }
+
+    if (noNormals)
+    {
+        computeNormals(mesh.Vertices.data(), mesh.Vertices.size(), mesh.Indices.data(), mesh.Indices.size());
+    }
+    return true;
+}
+////////////////////////////////////////////////////////////////
+
+/////////////////////////// PLY /////////////////////////////////
+enum class PlyType : uint8_t
+{
+    NONE,
+    INT8,
+    UINT8,
+    INT16,
+    UINT16,
+    INT32,
+    UINT32,
+    FLOAT32,
+    FLOAT64
+};
+
+struct PlyProperty
+{
+    std::string Name;
+    PlyType Type;
+    PlyType CountType;  // type of the length prefix for list properties, NONE for scalars
+};
+
+struct PlyElement
+{
+    std::string Name;
+    size_t Count;
+    std::vector<PlyProperty> Properties;
+};
+
+enum class PlyFormat
+{
+    ASCII,
+    BINARY_LITTLE_ENDIAN,
+    BINARY_BIG_ENDIAN
+};
+
+struct PlyHeader
+{
+    PlyFormat Format;
+    std::vector<PlyElement> Elements;
+    const char* Body;
+};
+
+// Vertex fields read from PLY, in the order of the floats in Vertex.
+static const char* const PLY_VERTEX_FIELDS[] = {"x", "y", "z", "nx", "ny", "nz"};
+
+static PlyType plyType(const std::string& name)
+{
+    static const std::pair<const char*, PlyType> types[] = {
+        {"char", PlyType::INT8},     {"int8", PlyType::INT8},       {"uchar", PlyType::UINT8},
+        {"uint8", PlyType::UINT8},   {"short", PlyType::INT16},     {"int16", PlyType::INT16},
+        {"ushort", PlyType::UINT16}, {"uint16", PlyType::UINT16},   {"int", PlyType::INT32},
+        {"int32", PlyType::INT32},   {"uint", PlyType::UINT32},     {"uint32", PlyType::UINT32},
+        {"float", PlyType::FLOAT32}, {"float32", PlyType::FLOAT32}, {"double", PlyType::FLOAT64},
+        {"float64", PlyType::FLOAT64},
+    };
+    for (const auto& [typeName, type] : types)
+    {
+        if (name == typeName)
+        {
+            return type;
+        }
+    }
+    return PlyType::NONE;
+}
+
+static size_t plySize(const PlyType type)
+{
+    switch (type)
+    {
+    case PlyType::INT8:
+    case PlyType::UINT8:
+        return 1;
+    case PlyType::INT16:
+    case PlyType::UINT16:
+        return 2;
+    case PlyType::INT32:
+    case PlyType::UINT32:
+    case PlyType::FLOAT32:
+        return 4;
+    case PlyType::FLOAT64:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+static bool isLittleEndianHost()
+{
+    const uint16_t one = 1;
+    unsigned char first;
+    std::memcpy(&first, &one, 1);
+    return first == 1;
+}
+
+template <typename T>
+static T loadValue(const char* p, const bool swap)
+{
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, p, sizeof(T));
+    if (swap)
+    {
+        std::reverse(bytes, bytes + sizeof(T));
+    }
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+static double plyValue(const char* p, const PlyType type, const bool swap)
+{
+    switch (type)
+    {
+    case PlyType::INT8:
+        return static_cast<int8_t>(*p);
+    case PlyType::UINT8:
+        return static_cast<uint8_t>(*p);
+    case PlyType::INT16:
+        return loadValue<int16_t>(p, swap);
+    case PlyType::UINT16:
+        return loadValue<uint16_t>(p, swap);
+    case PlyType::INT32:
+        return loadValue<int32_t>(p, swap);
+    case PlyType::UINT32:
+        return loadValue<uint32_t>(p, swap);
+    case PlyType::FLOAT32:
+        return loadValue<float>(p, swap);
+    case PlyType::FLOAT64:
+        return loadValue<double>(p, swap);
+    default:
+        return 0.0;
+    }
+}
+
+// Integers are read exactly, negative and fractional indices end up out of range.
+static int64_t plyIndex(const char* p, const PlyType type, const bool swap)
+{
+    switch (type)
+    {
+    case PlyType::INT32:
+        return loadValue<int32_t>(p, swap);
+    case PlyType::UINT32:
+        return loadValue<uint32_t>(p, swap);
+    case PlyType::FLOAT32:
+    case PlyType::FLOAT64:
+        return -1;
+    default:
+        return static_cast<int64_t>(plyValue(p, type, swap));
+    }
+}
+
+// Splits the header line into whitespace separated words.
+static std::vector<std::string> words(const char* p, const char* end)
+{
+    std::vector<std::string> result;
+    for (p = skipBlanks(p, end); p < end && *p != '\n' && *p != '\r'; p = skipBlanks(p, end))
+    {
+        const char* word = p;
+        while (p < end && !isSpace(*p))
+        {
+            p++;
+        }
+        result.emplace_back(word, p);
+    }
+    return result;
+}
+
+static bool parsePlyHeader(const char* data, const size_t size, PlyHeader& header, std::string& error)
+{
+    const char* end = data + size;
+    const char* p = data;
+
+    if (!startsWithWord(p, end, "ply"))
+    {
+        error = "Missing ply magic";
+        return false;
+    }
+
+    bool hasFormat = false;
+    for (p = nextLine(p, end); p < end; p = nextLine(p, end))
+    {
+        const auto w = words(p, end);
+        if (w.empty() || w[0] == "comment" || w[0] == "obj_info")
+        {
+            continue;
+        }
+
+        if (w[0] == "end_header")
+        {
+            if (!hasFormat)
+            {
+                error = "Missing PLY format";
+                return false;
+            }
+            header.Body = nextLine(p, end);
+            return true;
+        }
+
+        if (w[0] == "format" && w.size() >= 2)
+        {
+            hasFormat = true;
+            if (w[1] == "ascii")
+            {
+                header.Format = PlyFormat::ASCII;
+            }
+            else if (w[1] == "binary_little_endian")
+            {
+                header.Format = PlyFormat::BINARY_LITTLE_ENDIAN;
+            }
+            else if (w[1] == "binary_big_endian")
+            {
+                header.Format = PlyFormat::BINARY_BIG_ENDIAN;
+            }
+            else
+            {
+                error = "Unknown PLY format " + w[1];
+                return false;
+            }
+        }
+        else if (w[0] == "element" && w.size() == 3)
+        {
+            header.Elements.push_back(PlyElement{w[1], std::strtoull(w[2].c_str(), nullptr, 10), {}});
+        }
+        else if (w[0] == "property" && !header.Elements.empty())
+        {
+            PlyProperty property{};
+            if (w.size() == 5 && w[1] == "list")
+            {
+                property = PlyProperty{w[4], plyType(w[3]), plyType(w[2])};
+                if (property.CountType == PlyType::NONE || property.CountType == PlyType::FLOAT32 ||
+                    property.CountType == PlyType::FLOAT64)
+                {
+                    property.Type = PlyType::NONE;
+                }
+            }
+            else if (w.size() == 3)
+            {
+                property = PlyProperty{w[2], plyType(w[1]), PlyType::NONE};
+            }
+            if (property.Type == PlyType::NONE)
+            {
+                error = "Malformed PLY property";
+                return false;
+            }
+            header.Elements.back().Properties.push_back(property);
+        }
+        else
+        {
+            error = "Malformed PLY header";
+            return false;
+        }
+    }
+
+    error = "Missing end_header";
+    return false;
+}
+
+// Index of the property holding the face's vertex indices, -1 when there is none.
+static int plyFaceIndices(const PlyElement& element)
+{
+    for (size_t i = 0; i < element.Properties.size(); i++)
+    {
+        const auto& property = element.Properties[i];
+        if (property.CountType != PlyType::NONE &&
+            (property.Name == "vertex_indices" || property.Name == "vertex_index"))
+        {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+// Property index of each PLY_VERTEX_FIELDS entry, -1 when missing. Returns whether the normals are present.
+static bool plyVertexFields(const PlyElement& element, int (&fields)[6])
+{
+    for (int f = 0; f < 6; f++)
+    {
+        fields[f] = -1;
+        for (size_t i = 0; i < element.Properties.size(); i++)
+        {
+            if (element.Properties[i].CountType == PlyType::NONE && element.Properties[i].Name == PLY_VERTEX_FIELDS[f])
+            {
+                fields[f] = static_cast<int>(i);
+            }
+        }
+    }
+    return fields[3] >= 0 && fields[4] >= 0 && fields[5] >= 0;
+}
+
+// Appends the fan triangulation of a polygon, returns false for indices out of range.
+class FanBuilder
+{
+   public:
+    FanBuilder(std::vector<unsigned int>& indices, const size_t vertexCount)
+        : indices(indices), vertexCount(vertexCount)
+    {
+    }
+
+    void Begin() { count = 0; }
+
+    bool Add(const int64_t index)
+    {
+        if (index < 0 || static_cast<uint64_t>(index) >= vertexCount)
+        {
+            return false;
+        }
+        const auto i = static_cast<unsigned int>(index);
+        if (count == 0)
+        {
+            first = i;
+        }
+        else if (count >= 2)
+        {
+            indices.insert(indices.end(), {first, previous, i});
+        }
+        previous = i;
+        count++;
+        return true;
+    }
+
+   private:
+    std::vector<unsigned int>& indices;
+    size_t vertexCount;
+    unsigned int first = 0;
+    unsigned int previous = 0;
+    size_t count = 0;
+};
+
+static bool readBinaryPlyVertices(const char*& p, const char* end, const PlyElement& element, const bool swap,
+                                  Mesh& mesh, bool& hasNormals, std::string& error)
+{
+    size_t stride = 0;
+    size_t offsets[16] = {};
+    if (element.Properties.size() > 16)
+    {
+        error = "Too many PLY vertex properties";
+        return false;
+    }
+    for (size_t i = 0; i < element.Properties.size(); i++)
+    {
+        if (element.Properties[i].CountType != PlyType::NONE)
+        {
+            error = "PLY vertex lists are not supported";
+            return false;
+        }
+        offsets[i] = stride;
+        stride += plySize(element.Properties[i].Type);
+    }
+
+    int fields[6];
+    hasNormals = plyVertexFields(element, fields);
+    if (fields[0] < 0 || fields[1] < 0 || fields[2] < 0)
+    {
+        error = "PLY vertices without x, y and z";
+        return false;
+    }
+    if (static_cast<size_t>(end - p) / stride < element.Count)
+    {
+        error = "Truncated PLY vertices";
+        return false;
+    }
+
+    const size_t count = element.Count;
+    const char* base = p;
+    mesh.Vertices.resize(count);
+
+    // Records that already are a Vertex are copied as they are.
+    bool verbatim = !swap && stride == sizeof(Vertex) && hasNormals;
+    for (int f = 0; f < 6 && verbatim; f++)
+    {
+        verbatim = fields[f] == f && element.Properties[f].Type == PlyType::FLOAT32;
+    }
+
+    if (verbatim)
+    {
+        parallelFor(count, MIN_RANGE, [&](const size_t begin, const size_t end) {
+            std::memcpy(mesh.Vertices.data() + begin, base + begin * stride, (end - begin) * stride);
+        });
+    }
+    else
+    {
+        parallelFor(count, MIN_RANGE, [&](const size_t begin, const size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                const char* record = base + i * stride;
+                Vertex v{vec3{0.0f}, vec3{0.0f}};
+                for (int f = 0; f < 6; f++)
+                {
+                    if (fields[f] >= 0)
+                    {
+                        auto& target = f < 3 ? v.Position[f] : v.Normal[f - 3];
+                        target = static_cast<float>(
+                            plyValue(record + offsets[fields[f]], element.Properties[fields[f]].Type, swap));
+                    }
+                }
+                mesh.Vertices[i] = v;
+            }
+        });
+    }
+
+    p += count * stride;
+    return true;
+}
+
+// Walks the element record by record. Collects the faces' triangles when indices is given, otherwise only skips.
+static bool walkBinaryPlyElement(const char*& p, const char* end, const PlyElement& element, const bool swap,
+                                 std::vector<unsigned int>* indices, const size_t vertexCount, std::string& error)
+{
+    const int faceIndices = indices != nullptr ? plyFaceIndices(element) : -1;
+    std::vector<unsigned int> unused;
+    FanBuilder fan{indices != nullptr ? *indices : unused, vertexCount};
+
+    for (size_t item = 0; item < element.Count; item++)
+    {
+        fan.Begin();
+        for (size_t i = 0; i < element.Properties.size(); i++)
+        {
+            const auto& property = element.Properties[i];
+            size_t count = 1;
+            if (property.CountType != PlyType::NONE)
+            {
+                const size_t countSize = plySize(property.CountType);
+                if (static_cast<size_t>(end - p) < countSize)
+                {
+                    error = "Truncated PLY " + element.Name;
+                    return false;
+                }
+                const auto value = plyValue(p, property.CountType, swap);
+                count = value > 0 ? static_cast<size_t>(value) : 0;
+                p += countSize;
+            }
+
+            const size_t size = plySize(property.Type);
+            if (static_cast<size_t>(end - p) / size < count)
+            {
+                error = "Truncated PLY " + element.Name;
+                return false;
+            }
+            if (static_cast<int>(i) == faceIndices)
+            {
+                for (size_t k = 0; k < count; k++)
+                {
+                    if (!fan.Add(plyIndex(p + k * size, property.Type, swap)))
+                    {
+                        error = "PLY face index out of range";
+                        return false;
+                    }
+                }
+            }
+            p += count * size;
+        }
+    }
+    return true;
+}
+
+static bool readBinaryPlyFaces(const char*& p, const char* end, const PlyElement& element, const bool swap,
+                               Mesh& mesh, std::string& error)
+{
+    const int faceIndices = plyFaceIndices(element);
+    if (faceIndices < 0)
+    {
+        error = "PLY faces without vertex_indices";
+        return false;
+    }
+
+    mesh.Indices.clear();
+
+    // Triangle-only files with nothing but the index list have fixed size records, which are read in parallel.
+    const auto& property = element.Properties[faceIndices];
+    const size_t countSize = plySize(property.CountType);
+    const size_t indexSize = plySize(property.Type);
+    const size_t stride = countSize + 3 * indexSize;
+    const size_t count = element.Count;
+    const size_t vertexCount = mesh.Vertices.size();
+
+    if (element.Properties.size() == 1 && static_cast<size_t>(end - p) / stride >= count &&
+        property.Type != PlyType::FLOAT32 && property.Type != PlyType::FLOAT64)
+    {
+        const char* base = p;
+        std::atomic<bool> triangles{true};
+        parallelFor(count, MIN_RANGE, [&](const size_t begin, const size_t end) {
+            for (size_t i = begin; i < end && triangles.load(std::memory_order_relaxed); i++)
+            {
+                if (plyValue(base + i * stride, property.CountType, swap) != 3.0)
+                {
+                    triangles = false;
+                }
+            }
+        });
+
+        if (triangles)
+        {
+            mesh.Indices.resize(count * 3);
+            std::atomic<bool> outOfRange{false};
+            parallelFor(count, MIN_RANGE, [&](const size_t begin, const size_t end) {
+                bool bad = false;
+                for (size_t i = begin; i < end; i++)
+                {
+                    const char* record = base + i * stride + countSize;
+                    for (size_t k = 0; k < 3; k++)
+                    {
+                        const auto index = plyIndex(record + k * indexSize, property.Type, swap);
+                        bad |= index < 0 || static_cast<uint64_t>(index) >= vertexCount;
+                        mesh.Indices[i * 3 + k] = static_cast<unsigned int>(index);
+                    }
+                }
+                if (bad)
+                {
+                    outOfRange = true;
+                }
+            });
+            if (outOfRange)
+            {
+                error = "PLY face index out of range";
+                return false;
+            }
+            p += count * stride;
+            return true;
+        }
+    }
+
+    // The count comes from the header; records of at least one triangle bound what the body can hold.
+    size_t recordSize = 0;
+    for (const auto& field : element.Properties)
+    {
+        recordSize += plySize(field.CountType != PlyType::NONE ? field.CountType : field.Type);
+    }
+    if (static_cast<size_t>(end - p) / std::max<size_t>(recordSize, 1) < count)
+    {
+        error = "Truncated PLY face";
+        return false;
+    }
+    mesh.Indices.reserve(std::min(count, static_cast<size_t>(end - p) / (recordSize + 3 * indexSize)) * 3);
+    return walkBinaryPlyElement(p, end, element, swap, &mesh.Indices, vertexCount, error);
+}
+
+static bool importBinaryPly(const PlyHeader& header, const char* end, Mesh& mesh, bool& hasNormals,
+                            std::string& error)
+{
+    const bool swap = (header.Format == PlyFormat::BINARY_LITTLE_ENDIAN) != isLittleEndianHost();
+    const char* p = header.Body;
+
+    for (const auto& element : header.Elements)
+    {
+        bool ok;
+        if (element.Name == "vertex")
+        {
+            ok = readBinaryPlyVertices(p, end, element, swap, mesh, hasNormals, error);
+        }
+        else if (element.Name == "face")
+        {
+            ok = readBinaryPlyFaces(p, end, element, swap, mesh, error);
+        }
+        else
+        {
+            ok = walkBinaryPlyElement(p, end, element, swap, nullptr, 0, error);
+        }
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct PlyTextChunk
+{
+    size_t FirstLine;
+    std::vector<unsigned int> Indices;
+    const char* Error = nullptr;
+    const char* ErrorPosition = nullptr;
+};
+
+static size_t countLines(const char* p, const char* end)
+{
+    size_t lines = 0;
+    for (; p < end; p = nextLine(p, end))
+    {
+        lines++;
+    }
+    return lines;
+}
+
+// Every ASCII element record is one line, so once the lines of each chunk are counted every chunk knows which
+// records it holds. Vertices are written in place, triangles are collected per chunk and concatenated.
+static bool importAsciiPly(const PlyHeader& header, const char* data, const char* end, Mesh& mesh, bool& hasNormals,
+                           std::string& error)
+{
+    const PlyElement* vertexElement = nullptr;
+    const PlyElement* faceElement = nullptr;
+    std::vector<size_t> firstLine{0};
+    for (const auto& element : header.Elements)
+    {
+        if (element.Name == "vertex")
+        {
+            vertexElement = &element;
+        }
+        else if (element.Name == "face")
+        {
+            faceElement = &element;
+        }
+        // Every record takes at least a byte of its line; larger counts are rejected before anything is allocated.
+        if (element.Count > static_cast<size_t>(end - header.Body))
+        {
+            error = "Truncated PLY body";
+            return false;
+        }
+        firstLine.push_back(firstLine.back() + element.Count);
+    }
+
+    int fields[6];
+    hasNormals = plyVertexFields(*vertexElement, fields);
+    const int faceIndices = faceElement != nullptr ? plyFaceIndices(*faceElement) : -1;
+    if (faceElement != nullptr && faceIndices < 0)
+    {
+        error = "PLY faces without vertex_indices";
+        return false;
+    }
+
+    const size_t vertexCount = vertexElement->Count;
+
+    const auto bounds = splitLines(header.Body, end);
+    const size_t chunkCount = bounds.size() - 1;
+    std::vector<PlyTextChunk> chunks(chunkCount);
+
+    parallelFor(chunkCount, 1, [&](const size_t begin, const size_t end) {
+        for (size_t c = begin; c < end; c++)
+        {
+            chunks[c].FirstLine = countLines(bounds[c], bounds[c + 1]);
+        }
+    });
+    size_t lineCount = 0;
+    for (auto& chunk : chunks)
+    {
+        lineCount += std::exchange(chunk.FirstLine, lineCount);
+    }
+    if (lineCount < firstLine.back())
+    {
+        error = "Truncated PLY body";
+        return false;
+    }
+    mesh.Vertices.assign(vertexCount, Vertex{vec3{0.0f}, vec3{0.0f}});
+
+    parallelFor(chunkCount, 1, [&](const size_t begin, const size_t end) {
+        for (size_t c = begin; c < end; c++)
+        {
+            auto& chunk = chunks[c];
+            FanBuilder fan{chunk.Indices, vertexCount};
+            size_t line = chunk.FirstLine;
+            const char* chunkEnd = bounds[c + 1];
+
+            for (const char* p = bounds[c]; p < chunkEnd; p = nextLine(p, chunkEnd), line++)
+            {
+                const size_t e = std::upper_bound(firstLine.begin(), firstLine.end(), line) - firstLine.begin() - 1;
+                if (e >= header.Elements.size())
+                {
+                    break;
+                }
+                const auto& element = header.Elements[e];
+                if (&element != vertexElement && &element != faceElement)
+                {
+                    continue;
+                }
+
+                const char* lineStart = p;
+                Vertex v{vec3{0.0f}, vec3{0.0f}};
+                fan.Begin();
+
+                for (size_t i = 0; i < element.Properties.size() && p != nullptr; i++)
+                {
+                    const auto& property = element.Properties[i];
+                    float value = 0.0f;
+                    if (property.CountType == PlyType::NONE)
+                    {
+                        p = parseFloat(skipBlanks(p, chunkEnd), chunkEnd, value);
+                        for (int f = 0; f < 6 && p != nullptr && &element == vertexElement; f++)
+                        {
+                            if (fields[f] == static_cast<int>(i))
+                            {
+                                (f < 3 ? v.Position[f] : v.Normal[f - 3]) = value;
+                            }
+                        }
+                        continue;
+                    }
+
+                    int64_t count;
+                    p = parseInt(skipBlanks(p, chunkEnd), chunkEnd, count);
+                    for (int64_t k = 0; k < count && p != nullptr; k++)
+                    {
+                        int64_t index;
+                        p = parseInt(skipBlanks(p, chunkEnd), chunkEnd, index);
+                        if (p != nullptr && static_cast<int>(i) == faceIndices && &element == faceElement &&
+                            !fan.Add(index))
+                        {
+                            p = nullptr;
+                        }
+                    }
+                }
+
+                if (p == nullptr)
+                {
+                    chunk.Error = &element == vertexElement ? "Malformed PLY vertex" : "Malformed PLY face";
+                    chunk.ErrorPosition = lineStart;
+                    break;
+                }
+                if (&element == vertexElement)
+                {
+                    mesh.Vertices[line - firstLine[e]] = v;
+                }
+            }
+        }
+    });
+
+    size_t indexCount = 0;
+    for (const auto& chunk : chunks)
+    {
+        if (chunk.Error != nullptr)
+        {
+            error = errorAt(chunk.Error, data, chunk.ErrorPosition);
+            return false;
+        }
+        indexCount += chunk.Indices.size();
+    }
+
+    mesh.Indices.resize(indexCount);
+    auto* out = mesh.Indices.data();
+    for (const auto& chunk : chunks)
+    {
+        out = std::copy(chunk.Indices.begin(), chunk.Indices.end(), out);
+    }
+    return true;
+}
+
+bool importPly(const char* data, const size_t size, Mesh& mesh, std::string& error)
+{
+    PlyHeader header{};
+    if (!parsePlyHeader(data, size, header, error))
+    {
+        return false;
+    }
+
+    const auto vertices = std::find_if(header.Elements.begin(), header.Elements.end(),
+                                       [](const PlyElement& element) { return element.Name == "vertex"; });
+    if (vertices == header.Elements.end())
+    {
+        error = "PLY without vertices";
+        return false;
+    }
+
+    mesh.Vertices.clear();
+    mesh.Indices.clear();
+
+    bool hasNormals = false;
+    const bool ok = header.Format == PlyFormat::ASCII
+                        ? importAsciiPly(header, data, data + size, mesh, hasNormals, error)
+                        : importBinaryPly(header, data + size, mesh, hasNormals, error);
+    if (!ok)
+    {
+        return false;
+    }
+    if (mesh.Indices.empty())
+    {
+        error = "No faces";
+        return false;
+    }
+
+    if (!hasNormals)
+    {
+        computeNormals(mesh.Vertices.data(), mesh.Vertices.size(), mesh.Indices.data(), mesh.Indices.size());
+    }
+    return true;
+}
+////////////////////////////////////////////////////////////////
+
+/////////////////////////// STL /////////////////////////////////
+constexpr size_t STL_HEADER = 84;
+constexpr size_t STL_TRIANGLE = 50;
+
+struct StlChunk
+{
+    std::vector<Vertex> Vertices;
+    const char* Error = nullptr;
+    const char* ErrorPosition = nullptr;
+};
+
+static void importBinaryStl(const char* data, const size_t triangles, Mesh& mesh)
+{
+    const bool swap = !isLittleEndianHost();
+    const char* base = data + STL_HEADER;
+
+    mesh.Vertices.resize(triangles * 3);
+    parallelFor(triangles, MIN_RANGE, [&](const size_t begin, const size_t end) {
+        for (size_t t = begin; t < end; t++)
+        {
+            // normal, three corners, 16 bit attribute count
+            const char* record = base + t * STL_TRIANGLE;
+            float values[12];
+            for (int i = 0; i < 12; i++)
+            {
+                values[i] = loadValue<float>(record + i * sizeof(float), swap);
+            }
+
+            const vec3 normal{values[0], values[1], values[2]};
+            for (int k = 0; k < 3; k++)
+            {
+                const float* corner = values + 3 + k * 3;
+                mesh.Vertices[t * 3 + k] = Vertex{vec3{corner[0], corner[1], corner[2]}, normal};
+            }
+        }
+    });
+}
+
+static void parseStlChunk(const char* p, const char* end, StlChunk& chunk)
+{
+    vec3 normal{0.0f};
+    int corners = 0;
+
+    for (p = skipSpaces(p, end); p < end; p = skipSpaces(p, end))
+    {
+        const char* line = p;
+
+        if (startsWithWord(p, end, "facet"))
+        {
+            p = skipBlanks(p + 5, end);
+            p = startsWithWord(p, end, "normal") ? parseVec3(p + 6, end, normal) : nullptr;
+            corners = 0;
+        }
+        else if (startsWithWord(p, end, "vertex"))
+        {
+            vec3 position;
+            p = corners < 3 ? parseVec3(p + 6, end, position) : nullptr;
+            if (p != nullptr)
+            {
+                chunk.Vertices.push_back(Vertex{position, normal});
+                corners++;
+            }
+        }
+        else if (startsWithWord(p, end, "endfacet"))
+        {
+            p = corners == 3 ? p + 8 : nullptr;
+        }
+        else
+        {
+            // solid, endsolid, outer loop, endloop
+            p = nextLine(p, end);
+        }
+
+        if (p == nullptr)
+        {
+            chunk.Error = "Malformed facet";
+            chunk.ErrorPosition = line;
+            return;
+        }
+    }
+}
+
+// Chunks of ASCII STL start right after an "endfacet" line, so no facet is split.
+static std::vector<const char*> splitFacets(const char* begin, const char* end)
+{
+    const auto lines = splitLines(begin, end);
+    const char* keyword = "endfacet";
+
+    std::vector<const char*> bounds{begin};
+    for (size_t i = 1; i + 1 < lines.size(); i++)
+    {
+        if (lines[i] <= bounds.back())
+        {
+            continue;
+        }
+        const char* found = std::search(lines[i], end, keyword, keyword + 8);
+        if (found == end)
+        {
+            break;
+        }
+        bounds.push_back(nextLine(found, end));
+    }
+    if (bounds.back() != end)
+    {
+        bounds.push_back(end);
+    }
+    return bounds;
+}
+
+static bool importAsciiStl(const char* data, const size_t size, Mesh& mesh, std::string& error)
+{
+    const auto bounds = splitFacets(data, data + size);
+    const size_t chunkCount = bounds.size() - 1;
+
+    std::vector<StlChunk> chunks(chunkCount);
+    parallelFor(chunkCount, 1, [&](const size_t begin, const size_t end) {
+        for (size_t c = begin; c < end; c++)
+        {
+            parseStlChunk(bounds[c], bounds[c + 1], chunks[c]);
+        }
+    });
+
+    size_t vertexCount = 0;
+    for (const auto& chunk : chunks)
+    {
+        if (chunk.Error != nullptr || chunk.Vertices.size() % 3 != 0)
+        {
+            error = errorAt("Malformed facet", data, chunk.Error != nullptr ? chunk.ErrorPosition : data);
+            return false;
+        }
+        vertexCount += chunk.Vertices.size();
+    }
+
+    mesh.Vertices.resize(vertexCount);
+    auto* out = mesh.Vertices.data();
+    for (const auto& chunk : chunks)
+    {
+        out = std::copy(chunk.Vertices.begin(), chunk.Vertices.end(), out);
+    }
+    return true;
+}
+
+// STL is a triangle soup with one normal per facet, read as three vertices per facet and then welded by position with
+// generateNormals(): as a soup every position would be a seam with one vertex per facet around it, which the
+// simplifier has to keep and the vertex cache can't reuse. The facet normals in the file are replaced by ones from the
+// winding, split along creases like the other formats. Binary files are recognized by their size, since many of them
+// also start with "solid".
+bool importStl(const char* data, const size_t size, Mesh& mesh, std::string& error)
+{
+    mesh.Vertices.clear();
+    mesh.Indices.clear();
+
+    uint32_t triangles = 0;
+    if (size >= STL_HEADER)
+    {
+        triangles = loadValue<uint32_t>(data + 80, !isLittleEndianHost());
+    }
+
+    const bool ascii = startsWithWord(data, data + size, "solid");
+    const bool binary = size >= STL_HEADER && (size - STL_HEADER) / STL_TRIANGLE >= triangles;
+    if (binary && (!ascii || size == STL_HEADER + triangles * STL_TRIANGLE))
+    {
+        importBinaryStl(data, triangles, mesh);
+    }
+    else if (ascii)
+    {
+        if (!importAsciiStl(data, size, mesh, error))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        error = "Truncated STL";
+        return false;
+    }
+
+    if (mesh.Vertices.empty())
+    {
+        error = "No faces";
+        return false;
+    }
+    if (mesh.Vertices.size() >= NONE)
+    {
+        error = "Too many vertices";
+        return false;
+    }
+
+    mesh.Indices.resize(mesh.Vertices.size());
+    parallelFor(mesh.Indices.size(), MIN_RANGE, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            mesh.Indices[i] = static_cast<unsigned int>(i);
+        }
+    });
+
+    mesh = generateNormals(mesh, NormalMode::ANGLE, CREASE_ANGLE);
+    return true;
+}
+////////////////////////////////////////////////////////////////
+
+bool importMesh(const std::string& path, Mesh& mesh, ImportStats& stats)
+{
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+
+    stats = ImportStats{};
+
+    std::string extension = path.substr(path.find_last_of('.') + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    bool (*import)(const char*, size_t, Mesh&, std::string&) = nullptr;
+    if (extension == "obj")
+    {
+        import = importObj;
+    }
+    else if (extension == "ply")
+    {
+        import = importPly;
+    }
+    else if (extension == "stl")
+    {
+        import = importStl;
+    }
+    else
+    {
+        stats.Error = "Unknown mesh format " + path;
+        return false;
+    }
+
+    const MappedFile file{path};
+    if (!file.IsOpen())
+    {
+        stats.Error = "Can't open " + path;
+        return false;
+    }
+
+    stats.Bytes = file.GetSize();
+    const bool ok = import(file.GetData(), file.GetSize(), mesh, stats.Error);
+    stats.Seconds = std::chrono::duration<double>(clock::now() - start).count();
+    return ok;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "mesh.h"
+
+/////////////////////////// Mesh import /////////////////////////
+// Loaders for OBJ, PLY (ASCII and binary) and STL (ASCII and binary) that write straight into the Vertex layout.
+// Files are memory mapped; text is split into chunks at line boundaries and the chunks are parsed in parallel.
+// Binary PLY whose vertices are exactly float x, y, z, nx, ny, nz and binary STL are copied without per-value
+// parsing. Polygons are triangulated as fans, texture coordinates and other attributes are ignored and meshes
+// without normals get area weighted vertex normals. STL soups are welded into indexed meshes, see importStl().
+
+struct ImportStats
+{
+    size_t Bytes = 0;
+    double Seconds = 0.0;
+    std::string Error;  // empty on success
+
+    double MegabytesPerSecond() const { return Seconds > 0.0 ? Bytes / Seconds * 1e-6 : 0.0; }
+};
+
+// Loads a mesh picked by the file extension (.obj, .ply or .stl, any case). Returns false and sets stats.Error on
+// failure, mesh is left in an unspecified state then.
+bool importMesh(const std::string& path, Mesh& mesh, ImportStats& stats);
+
+// In-memory variants used by importMesh(). data does not need to be null terminated.
+bool importObj(const char* data, const size_t size, Mesh& mesh, std::string& error);
+bool importPly(const char* data, const size_t size, Mesh& mesh, std::string& error);
+bool importStl(const char* data, const size_t size, Mesh& mesh, std::string& error);
+////////////////////////////////////////////////////////////////
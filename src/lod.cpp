@@ -0,0 +1,115 @@
+#include "lod.h"
+
+#include <algorithm>
+
+#include "parallel.h"
+
+// Instances handed to each thread.
+constexpr size_t MIN_RANGE = 16384;
+
+void LODSelector::SetView(const vec3& cameraPosition, const mat4& projection, const float viewportHeight)
+{
+    this->cameraPosition = cameraPosition;
+    projectionScale = projection[1][1] * viewportHeight * 0.5f;
+}
+
+static void selectRange(const Sphere* spheres, const vec3& eye, const float scale, const float detail,
+                        const float hysteresis, const int levelCount, uint8_t* levels, size_t i, const size_t end)
+{
+#if defined(MATH_SIMD_AVX2)
+    // Sphere is 4 floats: center.xyz, radius.
+    const __m256i offsets = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+
+    const __m256 ex = _mm256_set1_ps(eye.x), ey = _mm256_set1_ps(eye.y), ez = _mm256_set1_ps(eye.z);
+    const __m256 up = _mm256_set1_ps(1.0f + hysteresis);
+    const __m256 down = _mm256_set1_ps(1.0f - hysteresis);
+
+    for (; i + 8 <= end; i += 8)
+    {
+        const float* base = &spheres[i].center.x;
+
+        const __m256 dx = _mm256_sub_ps(_mm256_i32gather_ps(base + 0, offsets, 4), ex);
+        const __m256 dy = _mm256_sub_ps(_mm256_i32gather_ps(base + 1, offsets, 4), ey);
+        const __m256 dz = _mm256_sub_ps(_mm256_i32gather_ps(base + 2, offsets, 4), ez);
+        const __m256 radius = _mm256_i32gather_ps(base + 3, offsets, 4);
+
+        const __m256 dist = _mm256_sqrt_ps(
+            _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz)));
+        const __m256 pixels =
+            _mm256_div_ps(_mm256_mul_ps(radius, _mm256_set1_ps(scale)), _mm256_max_ps(dist, radius));
+
+        const __m256i previous = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(levels + i)));
+
+        __m256i level = _mm256_setzero_si256();
+        float threshold = detail;
+        for (int l = 1; l < levelCount; l++, threshold *= 0.5f)
+        {
+            // Instances already at level l or coarser need to grow past the upper margin to become finer.
+            const __m256 coarse = _mm256_castsi256_ps(_mm256_cmpgt_epi32(previous, _mm256_set1_epi32(l - 1)));
+            const __m256 t = _mm256_mul_ps(_mm256_set1_ps(threshold), _mm256_blendv_ps(down, up, coarse));
+
+            level = _mm256_sub_epi32(level, _mm256_castps_si256(_mm256_cmp_ps(pixels, t, _CMP_LT_OQ)));
+        }
+
+        alignas(32) int32_t result[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(result), level);
+        for (int k = 0; k < 8; k++)
+        {
+            levels[i + k] = static_cast<uint8_t>(result[k]);
+        }
+    }
+#endif
+
+    for (; i < end; i++)
+    {
+        const auto d = spheres[i].center - eye;
+        const auto dist = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+        const auto radius = spheres[i].radius;
+        const auto pixels = radius * scale / std::max(dist, radius);
+
+        int level = 0;
+        float threshold = detail;
+        for (int l = 1; l < levelCount; l++, threshold *= 0.5f)
+        {
+            const auto margin = levels[i] >= l ? 1.0f + hysteresis : 1.0f - hysteresis;
+            level += pixels < threshold * margin;
+        }
+        levels[i] = static_cast<uint8_t>(level);
+    }
+}
+
+void LODSelector::Select(const Sphere* spheres, const size_t n, const int levelCount, uint8_t* levels) const
+{
+    parallelFor(n, MIN_RANGE, [&](const size_t begin, const size_t end) {
+        selectRange(spheres, cameraPosition, projectionScale, DetailPixels, Hysteresis, levelCount, levels, begin,
+                    end);
+    });
+}
+
+void LODSelector::Bucket(const uint8_t* levels, const uint8_t* visible, const size_t n, const int levelCount)
+{
+    // Counting sort on the level.
+    size_t counts[MAX_LOD_LEVELS] = {};
+    for (size_t i = 0; i < n; i++)
+    {
+        counts[levels[i]] += visible == nullptr || visible[i];
+    }
+
+    offsets[0] = 0;
+    for (int l = 0; l < MAX_LOD_LEVELS; l++)
+    {
+        offsets[l + 1] = offsets[l] + (l < levelCount ? counts[l] : 0);
+    }
+
+    order.resize(offsets[levelCount]);
+
+    size_t next[MAX_LOD_LEVELS];
+    std::copy(offsets, offsets + MAX_LOD_LEVELS, next);
+    for (size_t i = 0; i < n; i++)
+    {
+        if (visible == nullptr || visible[i])
+        {
+            order[next[levels[i]]++] = static_cast<unsigned int>(i);
+        }
+    }
+}
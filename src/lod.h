@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "generators.h"
+#include "math.h"
+
+// Picks a detail level per instance from the projected size of its bounding sphere, and buckets the instances per
+// level for instanced submission. Level l + 1 is used once the projected radius drops below DetailPixels / 2^l:
+// every level halves the tessellation, so on-screen edge lengths stay about the same across a switch.
+class LODSelector
+{
+   public:
+    // Projected radius in pixels below which the first coarser level is used.
+    float DetailPixels = 150.0f;
+
+    // Relative margin around every threshold. An instance only changes level once it is this far past the
+    // threshold, so instances sitting at a boundary don't flip between levels every frame.
+    float Hysteresis = 0.15f;
+
+    // projection is the matrix built by perspective(); its [1][1] term is 1 / tan(fov / 2).
+    void SetView(const vec3& cameraPosition, const mat4& projection, const float viewportHeight);
+
+    // Selects a level in [0, levelCount) for every world space bounding sphere. levels must hold the previous
+    // selection for the same instances (0 for new ones), it is updated in place.
+    void Select(const Sphere* spheres, const size_t n, const int levelCount, uint8_t* levels) const;
+
+    // Groups the indices of the instances by level, keeping their order. Instances with visible[i] == 0 are left
+    // out; visible may be null.
+    void Bucket(const uint8_t* levels, const uint8_t* visible, const size_t n, const int levelCount);
+
+    size_t GetCount(const int level) const { return offsets[level + 1] - offsets[level]; }
+    const unsigned int* GetInstances(const int level) const { return order.data() + offsets[level]; }
+
+   private:
+    vec3 cameraPosition;
+
+    // Pixels per world unit at distance 1.
+    float projectionScale = 1.0f;
+
+    std::vector<unsigned int> order;
+    size_t offsets[MAX_LOD_LEVELS + 1] = {};
+};
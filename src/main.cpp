@@ -4,6 +4,7 @@
 #include <imgui/imgui_impl_glfw.h>
 #include <imgui/imgui_impl_opengl3.h>
 
+#include <algorithm>
 #include <cassert>
 #include <unordered_map>
 
@@ -12,10 +13,19 @@
 #include "camera.h"
 #include "math.h"
 #include "shape.h"
+#include "batch.h"
+#include "lod.h"
+#include "importer.h"
+#include "mesh_file.h"
+#include "optimizer.h"
+#include "parallel.h"
+#include "gpu_pool.h"
+#include "streaming_buffer.h"
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
 void scrollCallback(GLFWwindow* window, double xoffset, double yoffset);
+bool importAsset(const std::string& path, const int levels, LodChain& lods);
 
 int screenWidth = 1200;
 int screenHeight = 800;
@@ -39,10 +49,10 @@ vec3 lightAmbient{0.2f};
 vec3 lightDiffuse{0.5f};
 vec3 lightSpecular{1.0f};
 
-mat4 shapeModel{1.0f};
+Transform shapeTransform{};
 /////////////////////////////////////////////////////////////////////
 
-int main()
+int main(int argc, char** argv)
 {
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -62,6 +72,7 @@ int main()
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_HIDDEN);
 
     assert(gladLoadGLLoader((GLADloadproc)glfwGetProcAddress) && "Failed to initialize GLAD");
+    const bool persistentStreaming = loadStreamingFunctions((GLADloadproc)glfwGetProcAddress);
     glEnable(GL_DEPTH_TEST);
 
     // Setup Dear ImGui context
@@ -72,9 +83,34 @@ int main()
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init();
 
+    // Destroyed last, after everything below has given its GL names back while the context still exists.
+    struct Shutdown
+    {
+        GLFWwindow* Window;
+        ~Shutdown()
+        {
+            ImGui_ImplOpenGL3_Shutdown();
+            ImGui_ImplGlfw_Shutdown();
+            ImGui::DestroyContext();
+
+            glfwDestroyWindow(Window);
+            glfwTerminate();
+        }
+    } shutdown{window};
+
+    // Buffer and vertex array names of every GPU object, recycled when one goes away.
+    GpuResourcePool gpuPool;
+
+    // Everything rewritten every frame: instance matrices and the light direction line. A megabyte per frame holds
+    // about 10000 instances before the ring grows.
+    StreamingBuffer stream{1 << 20};
+
     Shader pongShader{"shaders/lightning_pong.vs", "shaders/lightning_pong.fs"};
     Shader gouraudShader{"shaders/lightning_gouraud.vs", "shaders/lightning_gouraud.fs"};
 
+    Shader pongInstancedShader{"shaders/lightning_pong_instanced.vs", "shaders/lightning_pong.fs"};
+    Shader gouraudInstancedShader{"shaders/lightning_gouraud_instanced.vs", "shaders/lightning_gouraud.fs"};
+
     Shader lightShader{"shaders/mvp.vs", "shaders/color.fs"};
     Shader lightDirShader{"shaders/mvp.vs", "shaders/color.fs"};
 
@@ -84,16 +120,8 @@ int main()
         lightPos.x, lightPos.y, lightPos.z, shapePos.x, shapePos.y, shapePos.z,
     };
 
-    GLuint lightDirVAO, lightDirVBO;
-    glGenVertexArrays(1, &lightDirVAO);
-    glGenBuffers(1, &lightDirVBO);
-    glBindVertexArray(lightDirVAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, lightDirVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(lineVertices), lineVertices, GL_DYNAMIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    // The line is written to the stream when drawn, the attribute pointer follows it.
+    PooledVertexArray lightDirVAO{gpuPool};
 
     ////////// ImGui options //////////
     std::string lightningModel = "Pong";
@@ -108,24 +136,132 @@ int main()
 
     std::string shape = "Cube";
     std::string lightShape = "Cube";
-    std::unordered_map<std::string, Shape> shapeMap{
-        {"Cube", Shape{ShapeType::CUBE}},
-        {"Pyramid", {ShapeType::PYRAMID}},
-        {"Cuboid", {ShapeType::CUBOID}},
+    const auto geometryStart = glfwGetTime();
+    // Every shape lives in one vertex/index buffer pair, with 12-byte quantized vertices instead of 24-byte floats.
+    GeometryBuffer geometry{gpuPool, stream, VertexFormat::QUANTIZED};
+    // Shapes are move-only and built in place.
+    std::unordered_map<std::string, Shape> shapeMap;
+    shapeMap.try_emplace("Cube", geometry, ShapeType::CUBE);
+    shapeMap.try_emplace("Pyramid", geometry, ShapeType::PYRAMID);
+    shapeMap.try_emplace("Cuboid", geometry, ShapeType::CUBOID);
+
+    // Generated and imported meshes are converted to mesh files once; later starts only map the files and upload
+    // straight from the mappings.
+    MeshCache meshCache{".mesh-cache"};
+    std::vector<MeshFile> meshFiles;
+
+    // Parametric shapes, every detail level is generated up front and in parallel.
+    constexpr int LOD_LEVELS = 4;
+    const std::pair<std::string, ParametricShape> parametricShapes[] = {
+        {"Sphere", {Primitive::SPHERE}},
+        {"Cylinder", {Primitive::CYLINDER}},
+        {"Cone", {Primitive::CONE}},
+        {"Torus", {Primitive::TORUS, 0.4f}},
+        {"Capsule", {Primitive::CAPSULE, 0.35f, 0.8f}},
+        {"Box", {Primitive::CUBOID, 0.0f, 0.0f, 0.0f, vec3{1.5f, 0.5f, 1.0f}}},
     };
+    constexpr size_t parametricCount = sizeof(parametricShapes) / sizeof(parametricShapes[0]);
+
+    std::vector<MeshFile> parametricFiles(parametricCount);
+    std::vector<LodChain> lodChains(parametricCount);
+    parallelFor(parametricCount, 1, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            const auto& shape = parametricShapes[i].second;
+            const auto key = meshKey(shape, LOD_LEVELS);
+            parametricFiles[i] = meshCache.Load(key, [&](const std::string& path) {
+                return writeMeshFile(path, LodChain{shape, LOD_LEVELS}, key);
+            });
+
+            // Without a usable cache directory the chain is generated on every start.
+            if (!parametricFiles[i].IsOpen())
+            {
+                lodChains[i] = LodChain{shape, LOD_LEVELS};
+            }
+        }
+    });
+    for (size_t i = 0; i < parametricCount; i++)
+    {
+        const auto& name = parametricShapes[i].first;
+        if (parametricFiles[i].IsOpen())
+        {
+            shapeMap.try_emplace(name, geometry, parametricFiles[i]);
+            meshFiles.push_back(std::move(parametricFiles[i]));
+        }
+        else
+        {
+            shapeMap.try_emplace(name, geometry, lodChains[i]);
+        }
+    }
+
+    // Meshes given on the command line (OBJ, PLY or STL), only parsed when they are new or changed.
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string path = argv[i];
+        const auto key = fileKey(path, LOD_LEVELS);
+
+        LodChain lods;
+        bool imported = false;
+        auto file = meshCache.Load(key, [&](const std::string& cachePath) {
+            imported = importAsset(path, LOD_LEVELS, lods);
+            return imported && writeMeshFile(cachePath, lods, key);
+        });
+
+        const auto name = path.substr(path.find_last_of("/\\") + 1);
+        if (file.IsOpen())
+        {
+            shapeMap.try_emplace(name, geometry, file);
+            meshFiles.push_back(std::move(file));
+        }
+        else if (imported)
+        {
+            shapeMap.try_emplace(name, geometry, lods);
+        }
+    }
+
+    geometry.Upload();
+
+    // The driver has its own copy now.
+    size_t geometryBytes = 0;
+    for (const auto& file : meshFiles)
+    {
+        geometryBytes += file.GetSize();
+    }
+    meshFiles.clear();
+    lodChains.clear();
+    std::cout << "Geometry: " << geometryBytes * 1e-6 << " MB of mesh files ready in "
+              << (glfwGetTime() - geometryStart) * 1e3 << " ms, " << geometry.GetVertexBytes() * 1e-6
+              << " MB of vertices" << std::endl;
 
     bool rotateLight = false;
     bool showLightDirection = true;
+
+    // Copies of the shape laid out on a grid, drawn with one instanced call per detail level.
+    int instanceCount = 1;
+
+    // A single shape skips its back-facing and off-screen meshlets.
+    bool meshletCulling = true;
+    size_t submittedTriangles = 0, shapeTriangles = 0;
     //////////////////////////////////
 
+    std::vector<vec3> instanceOffsets;
+    std::vector<AABB> instanceBounds;
+    std::vector<uint8_t> instanceVisible;
+    std::vector<mat4> instanceModels;
+    std::vector<mat3> instanceNormals;
+    std::vector<Sphere> instanceSpheres;
+    std::vector<uint8_t> instanceLevels;
+
+    LODSelector lodSelector;
+    uint8_t shapeLevel = 0;
+    size_t lodCounts[MAX_LOD_LEVELS] = {};
+
     auto updateLightPos = [&](const vec3& v = lightPos)
     {
         lightPos = v;
         lineVertices[0] = lightPos.x;
         lineVertices[1] = lightPos.y;
         lineVertices[2] = lightPos.z;
-        glBindBuffer(GL_ARRAY_BUFFER, lightDirVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(lineVertices), lineVertices, GL_DYNAMIC_DRAW);
     };
 
     while (!glfwWindowShouldClose(window))
@@ -185,6 +321,51 @@ int main()
                     }
                     ImGui::TreePop();
                 }
+
+                ImGui::SliderInt("Instances", &instanceCount, 1, 100000, "%d", ImGuiSliderFlags_Logarithmic);
+
+                ImGui::Checkbox("Meshlet culling", &meshletCulling);
+                if (instanceCount == 1)
+                {
+                    ImGui::Text("Triangles: %zu of %zu", submittedTriangles, shapeTriangles);
+                }
+
+                if (ImGui::TreeNode("Level of detail"))
+                {
+                    ImGui::SliderFloat("Detail (px)", &lodSelector.DetailPixels, 10.0f, 1000.0f, "%.0f",
+                                       ImGuiSliderFlags_Logarithmic);
+                    ImGui::SliderFloat("Hysteresis", &lodSelector.Hysteresis, 0.0f, 0.5f, "%.2f", 0);
+
+                    for (int l = 0; l < shapeMap.at(shape).GetLevelCount(); l++)
+                    {
+                        ImGui::Text("LOD %d: %zu", l, lodCounts[l]);
+                    }
+                    ImGui::TreePop();
+                }
+
+                if (ImGui::TreeNode("GPU memory"))
+                {
+                    const auto stats = gpuPool.GetStats();
+                    ImGui::Text("Buffers: %zu, %zu free", stats.Buffers, stats.FreeBuffers);
+                    ImGui::Text("Vertex arrays: %zu, %zu free", stats.VertexArrays, stats.FreeVertexArrays);
+                    ImGui::Text("In use: %.2f MB, cached: %.2f MB", stats.BytesInUse * 1e-6, stats.BytesCached * 1e-6);
+
+                    // Every shape's meshes are ranges in these two arenas.
+                    for (const auto& [label, arena] :
+                         {std::pair{"Vertices", geometry.GetVertexStats()}, {"Indices", geometry.GetIndexStats()}})
+                    {
+                        ImGui::Text("%s: %.2f of %.2f MB, %zu ranges, %zu free blocks (largest %.2f MB)", label,
+                                    arena.Used * 1e-6, arena.Capacity * 1e-6, arena.Allocations, arena.FreeBlocks,
+                                    arena.LargestFree * 1e-6);
+                    }
+                    if (ImGui::Button("Defragment"))
+                    {
+                        geometry.Defragment();
+                    }
+                    ImGui::Text("Streaming: %.2f MB per frame, %s", stream.GetFrameBytes() * 1e-6,
+                                persistentStreaming ? "persistent mapping" : "orphaning");
+                    ImGui::TreePop();
+                }
             }
             ImGui::EndGroup();
 
@@ -232,6 +413,8 @@ int main()
 
         mat4 view = camera.GetViewMatrix();
         mat4 projection = perspective(radians(camera.Zoom), float(screenWidth) / float(screenHeight), 0.1f, 100.0f);
+        const auto frustum = Frustum::fromMatrix(projection * view);
+        lodSelector.SetView(camera.Position, projection, static_cast<float>(screenHeight));
 
         ////// Light //////
         mat4 lightModel{1.0f};
@@ -253,17 +436,23 @@ int main()
         lightShader.setMat4("view", view);
         lightShader.setMat4("projection", projection);
 
-        shapeMap.at(lightShape).Draw(lightShader);
+        auto& lightShapeObj = shapeMap.at(lightShape);
+        if (frustum.intersects(lightShapeObj.GetBounds().transform(lightModel)))
+        {
+            lightShapeObj.Draw(lightShader);
+        }
         ///////////////////////
 
         ////// Geometry shape //////
         auto objMaterial = materialMap.at(material);
 
-        auto shapeShader = &pongShader;
+        const bool instanced = instanceCount > 1;
+
+        auto shapeShader = instanced ? &pongInstancedShader : &pongShader;
 
         if (lightningModel == "Gouraud")
         {
-            shapeShader = &gouraudShader;
+            shapeShader = instanced ? &gouraudInstancedShader : &gouraudShader;
         }
 
         shapeShader->use();
@@ -282,14 +471,94 @@ int main()
         shapeShader->setVec3("material.specular", objMaterial.specular);
         shapeShader->setFloat("material.shininess", objMaterial.shininess);
 
-        shapeShader->setMat4("model", shapeModel);
+        const auto shapeModel = shapeTransform.matrix();
+
         shapeShader->setMat4("view", view);
         shapeShader->setMat4("projection", projection);
 
-        auto normalMatrix = mat3{shapeModel}.transpose().inverse();
-        shapeShader->setMat3("normal", normalMatrix);
+        auto& shapeObj = shapeMap.at(shape);
+        const auto shapeBounds = shapeObj.GetBounds().transform(shapeModel);
+        const Sphere shapeSphere{shapeBounds.center(), shapeBounds.extents().magnitude()};
+
+        std::fill(lodCounts, lodCounts + MAX_LOD_LEVELS, 0);
+
+        if (!instanced)
+        {
+            shapeShader->setMat4("model", shapeModel);
+            shapeShader->setMat3("normal", normalMatrix(shapeModel));
+
+            lodSelector.Select(&shapeSphere, 1, shapeObj.GetLevelCount(), &shapeLevel);
+
+            shapeTriangles = shapeObj.GetTriangleCount(shapeLevel);
+            submittedTriangles = 0;
+            if (frustum.intersects(shapeBounds))
+            {
+                if (meshletCulling)
+                {
+                    const auto eye = shapeModel.inverse() * vec4{camera.Position.x, camera.Position.y,
+                                                                 camera.Position.z, 1.0f};
+                    submittedTriangles = shapeObj.DrawCulled(*shapeShader, projection * view * shapeModel,
+                                                             vec3{eye.x, eye.y, eye.z}, shapeLevel);
+                }
+                else
+                {
+                    shapeObj.Draw(*shapeShader, shapeLevel);
+                    submittedTriangles = shapeTriangles;
+                }
+                lodCounts[shapeLevel] = 1;
+            }
+        }
+        else
+        {
+            // Cube shaped grid centered on the shape, every copy shares its rotation and scale.
+            const int side = static_cast<int>(std::ceil(std::cbrt(static_cast<float>(instanceCount))));
+            const auto extents = shapeBounds.extents();
+            const float spacing = 2.5f * std::max(extents.x, std::max(extents.y, extents.z));
+            const vec3 origin{static_cast<float>(side - 1) * spacing * -0.5f};
+
+            instanceOffsets.resize(instanceCount);
+            instanceBounds.resize(instanceCount);
+            instanceVisible.resize(instanceCount);
+            instanceSpheres.resize(instanceCount);
+            instanceLevels.resize(instanceCount);
+            for (int i = 0; i < instanceCount; i++)
+            {
+                const vec3 cell{static_cast<float>(i % side), static_cast<float>(i / side % side),
+                                static_cast<float>(i / (side * side))};
+                instanceOffsets[i] = origin + cell * spacing;
+                instanceBounds[i] = AABB{shapeBounds.min + instanceOffsets[i], shapeBounds.max + instanceOffsets[i]};
+                instanceSpheres[i] = Sphere{shapeSphere.center + instanceOffsets[i], shapeSphere.radius};
+            }
+            cull(frustum, instanceBounds.data(), instanceCount, instanceVisible.data());
+
+            // Only the visible copies are uploaded, grouped by detail level with one instanced draw per level.
+            const int levelCount = shapeObj.GetLevelCount();
+            lodSelector.Select(instanceSpheres.data(), instanceCount, levelCount, instanceLevels.data());
+            lodSelector.Bucket(instanceLevels.data(), instanceVisible.data(), instanceCount, levelCount);
+
+            instanceModels.clear();
+            for (int l = 0; l < levelCount; l++)
+            {
+                const auto* instances = lodSelector.GetInstances(l);
+                for (size_t k = 0; k < lodSelector.GetCount(l); k++)
+                {
+                    const auto& o = instanceOffsets[instances[k]];
+                    auto model = shapeModel;
+                    model[3] += vec4{o.x, o.y, o.z, 0.0f};
+                    instanceModels.push_back(model);
+                }
+            }
+            instanceNormals.assign(instanceModels.size(), normalMatrix(shapeModel));
 
-        shapeMap.at(shape).Draw(pongShader);
+            size_t first = 0;
+            for (int l = 0; l < levelCount; l++)
+            {
+                lodCounts[l] = lodSelector.GetCount(l);
+                shapeObj.DrawInstanced(*shapeShader, instanceModels.data() + first, instanceNormals.data() + first,
+                                       lodCounts[l], l);
+                first += lodCounts[l];
+            }
+        }
         ///////////////////////
 
         ////// Light direction //////
@@ -301,9 +570,17 @@ int main()
             lightDirShader.setMat4("view", view);
             lightDirShader.setMat4("projection", projection);
             lightDirShader.setVec3("Color", vec3{0, 1.0f, 0});
+            // The line is plain floats.
+            lightDirShader.setVec3("positionScale", vec3{1.0f});
+            lightDirShader.setVec3("positionOffset", vec3{0.0f});
+
+            const size_t lineOffset = stream.Write(lineVertices, sizeof(lineVertices));
+            glBindVertexArray(lightDirVAO.Get());
+            glBindBuffer(GL_ARRAY_BUFFER, stream.Get());
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)lineOffset);
+            glEnableVertexAttribArray(0);
 
             glLineWidth(2.0f);
-            glBindVertexArray(lightDirVAO);
             glDrawArrays(GL_LINES, 0, 2);
         }
         ////////////////////////////
@@ -311,17 +588,11 @@ int main()
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
+        stream.EndFrame();
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImGui::DestroyContext();
-
-    glfwDestroyWindow(window);
-    glfwTerminate();
-
     return 0;
 }
 
@@ -350,17 +621,57 @@ void processInput(GLFWwindow* window)
 
     if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
     {
-        shapeModel = rotate(shapeModel, radians(rotationSpeed), vec3{0, 0, 1});
+        shapeTransform.rotate(radians(rotationSpeed), vec3{0, 0, 1});
     }
     if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
     {
-        shapeModel = rotate(shapeModel, radians(-1 * rotationSpeed), vec3{0, 0, 1});
+        shapeTransform.rotate(radians(-1 * rotationSpeed), vec3{0, 0, 1});
+    }
+}
+
+// Imports the mesh, centers and scales it to fit the unit cube and optimizes it for the vertex cache. Prints the
+// load and cache stats or the error.
+bool importAsset(const std::string& path, const int levels, LodChain& lods)
+{
+    Mesh mesh;
+    ImportStats stats;
+    if (!importMesh(path, mesh, stats))
+    {
+        std::cout << "ERROR::IMPORT: " << stats.Error << std::endl;
+        return false;
+    }
+    std::cout << path << ": " << mesh.Indices.size() / 3 << " triangles, " << stats.Bytes * 1e-6 << " MB in "
+              << stats.Seconds * 1e3 << " ms (" << stats.MegabytesPerSecond() << " MB/s)" << std::endl;
+
+    const auto bounds = computeBounds(mesh.Vertices.data(), mesh.Vertices.size());
+    const auto extents = bounds.extents();
+    const float size = std::max(extents.x, std::max(extents.y, extents.z));
+    // translate() sets the translation column rather than multiplying, so it is the scaled center: p * s - c * s.
+    const float s = size > 0.0f ? 0.5f / size : 1.0f;
+    const auto fit = translate(scale(mat4{1.0f}, vec3{s}), -bounds.center() * s);
+    transformVertices(fit, mesh.Vertices.data(), mesh.Vertices.data(), mesh.Vertices.size());
+
+    const auto before = analyzeVertexCache(mesh.Indices.data(), mesh.Indices.size(), mesh.Vertices.size());
+    const auto start = glfwGetTime();
+    lods = LodChain{mesh, levels};
+    const auto& finest = lods.GetLevel(0);
+    const auto after = analyzeVertexCache(lods.GetIndices(0), finest.IndexCount, finest.VertexCount);
+    std::cout << path << ": ACMR " << before.ACMR << " -> " << after.ACMR << ", ATVR " << before.ATVR << " -> "
+              << after.ATVR << std::endl;
+
+    std::cout << path << ": " << lods.GetLevelCount() << " detail levels in " << (glfwGetTime() - start) * 1e3
+              << " ms, triangles";
+    for (int l = 0; l < lods.GetLevelCount(); l++)
+    {
+        std::cout << " " << lods.GetLevel(l).IndexCount / 3;
     }
+    std::cout << std::endl;
+    return true;
 }
 
 void scrollCallback(GLFWwindow* window, double xoffset, double yoffset)
 {
     const auto rotationSpeed = 5.0f;
 
-    shapeModel = rotate(shapeModel, radians(yoffset * rotationSpeed), vec3{1, 0, 0});
+    shapeTransform.rotate(radians(yoffset * rotationSpeed), vec3{1, 0, 0});
 }
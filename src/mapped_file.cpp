@@ -0,0 +1,124 @@
+#include "mapped_file.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string& path)
+{
+    const HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        CloseHandle(file);
+        return;
+    }
+    size = static_cast<size_t>(fileSize.QuadPart);
+
+    if (size > 0)
+    {
+        // The view keeps the mapping and the file alive, so both handles can be closed right away.
+        const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr)
+        {
+            data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+
+    open = size == 0 || data != nullptr;
+    if (!open)
+    {
+        size = 0;
+    }
+}
+
+void MappedFile::close()
+{
+    if (data != nullptr)
+    {
+        UnmapViewOfFile(data);
+    }
+}
+#else
+MappedFile::MappedFile(const std::string& path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        return;
+    }
+    size = static_cast<size_t>(st.st_size);
+
+    if (size > 0)
+    {
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED)
+        {
+            // Importers touch the whole file from several threads at once, ask for read-ahead of all of it.
+            posix_madvise(mapped, size, POSIX_MADV_WILLNEED);
+            data = static_cast<const char*>(mapped);
+        }
+    }
+    ::close(fd);
+
+    open = size == 0 || data != nullptr;
+    if (!open)
+    {
+        size = 0;
+    }
+}
+
+void MappedFile::close()
+{
+    if (data != nullptr)
+    {
+        munmap(const_cast<char*>(data), size);
+    }
+}
+#endif
+
+MappedFile::~MappedFile() { close(); }
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data(std::exchange(other.data, nullptr)),
+      size(std::exchange(other.size, 0)),
+      open(std::exchange(other.open, false))
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        data = std::exchange(other.data, nullptr);
+        size = std::exchange(other.size, 0);
+        open = std::exchange(other.open, false);
+    }
+    return *this;
+}
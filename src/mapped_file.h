@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file. The mapping is released with the object; it is move-only so the
+// pointers handed out stay valid for as long as exactly one owner exists.
+class MappedFile
+{
+   public:
+    MappedFile() = default;
+    // IsOpen() is false when the file can't be opened or mapped.
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool IsOpen() const { return open; }
+    // Not null terminated. Null for an empty file.
+    const char* GetData() const { return data; }
+    size_t GetSize() const { return size; }
+
+   private:
+    const char* data = nullptr;
+    size_t size = 0;
+    bool open = false;
+
+    void close();
+};
@@ -1,13 +1,167 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
 #include <math.h>
 #include <random>
 #include <iostream>
+#include <type_traits>
+
+/////////////////////////// SIMD ////////////////////////////////
+// The vec4/mat4 arithmetic can be backed by SSE4.1 or AVX2 intrinsics. The backend is selected at compile time
+// with MATH_SIMD_SSE41 or MATH_SIMD_AVX2 (see MATH_SIMD in CMakeLists.txt); without either the scalar code is used.
+//
+// The SIMD paths evaluate every component in the same order as the scalar code and never contract into FMA, so
+// vec4 and mat4 operators, vec4::dot included, are bit-identical to the scalar backend (0 ULP).
+#if defined(MATH_SIMD_AVX2)
+#if !defined(__AVX2__)
+#error "MATH_SIMD_AVX2 requires AVX2 code generation (-mavx2)"
+#endif
+#define MATH_SIMD_SSE41
+#endif
+
+#if defined(MATH_SIMD_SSE41)
+#if !defined(__SSE4_1__)
+#error "MATH_SIMD_SSE41 requires SSE4.1 code generation (-msse4.1)"
+#endif
+#include <immintrin.h>
+#endif
+
+#if defined(MATH_SIMD_AVX2)
+#define MATH_MAT4_ALIGN 32
+#else
+#define MATH_MAT4_ALIGN 16
+#endif
+////////////////////////////////////////////////////////////////
 
 /////////////////////////// Utils ///////////////////////////////
-inline float radians(const float deg) { return deg * M_PI / 180; }
-inline float degress(const float radians) { return radians * 180 / M_PI; }
+// The whole math layer is constexpr. Code paths that can't run in a constant expression (intrinsics, <cmath>,
+// indexing through pointer arithmetic) check MATH_IS_CONSTANT_EVALUATED() and fall back to portable code.
+#if defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER)
+#define MATH_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#else
+#define MATH_IS_CONSTANT_EVALUATED() false
+#endif
+
+constexpr float PI = 3.14159265358979323846f;
+
+constexpr float radians(const float deg) { return deg * (PI / 180.0f); }
+constexpr float degress(const float radians) { return radians * (180.0f / PI); }
+
+// <cmath> is not constexpr, at compile time these use Newton iterations and Taylor series evaluated in double.
+constexpr float constexprSqrt(const float v)
+{
+    if (!MATH_IS_CONSTANT_EVALUATED())
+    {
+        return std::sqrt(v);
+    }
+
+    if (!(v > 0.0f))
+    {
+        return v == 0.0f ? 0.0f : NAN;
+    }
+
+    double r = v >= 1.0f ? v : 1.0;
+    for (int i = 0; i < 64; i++)
+    {
+        r = 0.5 * (r + v / r);
+    }
+    return static_cast<float>(r);
+}
+
+constexpr float constexprSin(const float a)
+{
+    if (!MATH_IS_CONSTANT_EVALUATED())
+    {
+        return std::sin(a);
+    }
+
+    // Reduce to [-pi, pi]
+    constexpr double twoPi = 6.28318530717958647692;
+    double x = a - twoPi * static_cast<long long>(a / twoPi);
+    x = x > twoPi / 2 ? x - twoPi : x < -twoPi / 2 ? x + twoPi : x;
+
+    double term = x;
+    double sum = x;
+    for (int i = 1; i < 16; i++)
+    {
+        term *= -x * x / ((2 * i) * (2 * i + 1));
+        sum += term;
+    }
+    return static_cast<float>(sum);
+}
+
+constexpr float constexprCos(const float a)
+{
+    if (!MATH_IS_CONSTANT_EVALUATED())
+    {
+        return std::cos(a);
+    }
+    return constexprSin(a + PI / 2);
+}
+
+constexpr float constexprTan(const float a)
+{
+    if (!MATH_IS_CONSTANT_EVALUATED())
+    {
+        return std::tan(a);
+    }
+    return constexprSin(a) / constexprCos(a);
+}
+
+// Sine and cosine of the same angle in one call.
+constexpr void preciseSincos(const float a, float &s, float &c)
+{
+    // At runtime GCC/Clang fold the adjacent sinf/cosf calls into a single sincosf.
+    s = constexprSin(a);
+    c = constexprCos(a);
+}
+
+// Polynomial approximation for animation and camera code. The angle is reduced to [-pi/4, pi/4] around the nearest
+// multiple of pi/2 (Cody-Waite, three-part pi/2) and evaluated with degree 7/8 minimax polynomials, no libm call and
+// no branches besides the quadrant swap.
+// Max absolute error vs. double precision: 1e-7 for |a| <= 1e3, 1e-6 for |a| <= 1e5.
+constexpr void fastSincos(const float a, float &s, float &c)
+{
+    const auto q = static_cast<int>(a * (2 / PI) + (a >= 0 ? 0.5f : -0.5f));
+    const auto qf = static_cast<float>(q);
+    const auto r = ((a - qf * 1.5703125f) - qf * 4.837512969970703125e-4f) - qf * 7.54978995489188216e-8f;
+    const auto r2 = r * r;
+
+    const auto sr = r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+    const auto cr = 1.0f - 0.5f * r2 +
+                    r2 * r2 * (4.166664568298827e-2f + r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f));
+
+    switch (q & 3)
+    {
+    case 0:
+        s = sr;
+        c = cr;
+        break;
+    case 1:
+        s = cr;
+        c = -sr;
+        break;
+    case 2:
+        s = -sr;
+        c = -cr;
+        break;
+    default:
+        s = -cr;
+        c = sr;
+        break;
+    }
+}
+
+// Used by rotate(), quat::fromAxisAngle() and the camera. Precise unless MATH_FAST_TRIG is defined.
+constexpr void sincos(const float a, float &s, float &c)
+{
+#if defined(MATH_FAST_TRIG)
+    fastSincos(a, s, c);
+#else
+    preciseSincos(a, s, c);
+#endif
+}
 
 inline float randomFloat(const float min, const float max)
 {
@@ -18,873 +172,1068 @@ inline float randomFloat(const float min, const float max)
 }
 ////////////////////////////////////////////////////////////////
 
-struct mat4;
+/////////////////////////// Types ///////////////////////////////
+// vec<T, N> and mat<T, R, C> (R rows, C columns, stored column major like OpenGL) implement every operation once
+// over their components. The vec specializations only add the named members, and the float vec4/mat4 operations
+// are specialized further down with the SIMD backend.
+template <typename T, int N>
+struct vec;
+
+template <typename T, int R, int C>
+struct mat;
+
+using vec2 = vec<float, 2>;
+using vec3 = vec<float, 3>;
+using vec4 = vec<float, 4>;
+
+using mat2 = mat<float, 2, 2>;
+using mat3 = mat<float, 3, 3>;
+using mat4 = mat<float, 4, 4>;
+
+// Double precision, for camera math in large worlds.
+using dvec2 = vec<double, 2>;
+using dvec3 = vec<double, 3>;
+using dvec4 = vec<double, 4>;
+
+using dmat3 = mat<double, 3, 3>;
+using dmat4 = mat<double, 4, 4>;
+
+// Compressed storage.
+using i16vec2 = vec<int16_t, 2>;
+using i16vec3 = vec<int16_t, 3>;
+using i16vec4 = vec<int16_t, 4>;
+
+// Members shared by every vec<T, N>.
+template <typename T, int N>
+struct vecBase
+{
+    using value_type = T;
+
+    constexpr T &operator[](const int i);
+    constexpr const T &operator[](const int i) const;
+
+    constexpr T dot(const vec<T, N> &rhs) const;
+    constexpr T magnitude() const;
+    constexpr vec<T, N> normalize() const;
+
+   private:
+    constexpr vec<T, N> &self() { return static_cast<vec<T, N> &>(*this); }
+    constexpr const vec<T, N> &self() const { return static_cast<const vec<T, N> &>(*this); }
+};
 
-struct vec2
+template <typename T>
+struct vec<T, 2> : vecBase<T, 2>
 {
     union
     {
-        float x, r, u;
+        T x, r, u;
     };
 
     union
     {
-        float y, g, v;
+        T y, g, v;
     };
 
-    vec2();
-    vec2(const float x, const float y);
-
-    // Operators
-    float &operator[](const int i);
-    const float &operator[](const int i) const;
-
-    vec2 operator/(const float rhs) const;
+    constexpr vec();
+    constexpr vec(const T x, const T y);
 
-    vec2 operator*(const vec2 &rhs) const;
-
-    bool operator==(const vec2 &rhs) const;
-    bool operator!=(const vec2 &rhs) const;
+    template <typename U>
+    explicit constexpr vec(const vec<U, 2> &rhs);
 };
 
-struct vec3
+template <typename T>
+struct vec<T, 3> : vecBase<T, 3>
 {
     union
     {
-        float x, r;
+        T x, r;
     };
 
     union
     {
-        float y, g;
+        T y, g;
     };
 
     union
     {
-        float z, b;
+        T z, b;
     };
 
-    vec3();
-    vec3(const float x, const float y, const float z);
-    vec3(const float val);
-
-    vec3 cross(const vec3 &rhs) const;
-    float dot(const vec3 &r) const;
-    vec3 normalize() const;
-    float magnitude() const;
-
-    // Operators
-    vec3 operator*(const float &rhs) const;
-    vec3 operator*(const vec3 &rhs) const;
-    void operator*=(const float &rhs);
-    void operator*=(const vec3 &rhs);
+    constexpr vec();
+    constexpr vec(const T x, const T y, const T z);
+    constexpr vec(const T val);
 
-    vec3 operator-(const vec3 &rhs) const;
-    void operator-=(const vec3 &rhs);
-    vec3 operator+(const vec3 &rhs) const;
-    void operator+=(const vec3 &rhs);
+    template <typename U>
+    explicit constexpr vec(const vec<U, 3> &rhs);
 
-    vec3 operator/(const float &rhs) const;
-
-    bool operator!=(const vec3 &rhs) const;
-    bool operator==(const vec3 &rhs) const;
-
-    float &operator[](const int i);
-    const float &operator[](const int i) const;
-
-    // Friend operators
-    friend vec3 operator*(const float &lhs, const vec3 &rhs) { return vec3{rhs.x * lhs, rhs.y * lhs, rhs.z * lhs}; }
-    friend std::ostream &operator<<(std::ostream &os, const vec3 &v3);
+    constexpr vec cross(const vec &rhs) const;
 };
 
-struct vec4
+template <typename T>
+struct alignas(4 * sizeof(T) >= 16 ? 16 : alignof(T)) vec<T, 4> : vecBase<T, 4>
 {
     union
     {
-        float x, r;
+        T x, r;
     };
 
     union
     {
-        float y, g;
+        T y, g;
     };
 
     union
     {
-        float z, b;
+        T z, b;
     };
 
     union
     {
-        float w, a;
+        T w, a;
     };
 
-    vec4();
-    vec4(const float x, const float y, const float z, const float w);
-
-    float dot(const vec4 &rhs) const;
-
-    // Operators
-    vec4 operator*(const vec4 &rhs) const;
-
-    vec4 operator+(const vec4 &rhs) const;
+    constexpr vec();
+    constexpr vec(const T x, const T y, const T z, const T w);
 
-    vec4 operator/(const float rhs) const;
+    template <typename U>
+    explicit constexpr vec(const vec<U, 4> &rhs);
+};
 
-    bool operator==(const vec4 &rhs) const;
+template <typename T, int R, int C>
+constexpr size_t matAlignment()
+{
+    return R == 4 && C == 4 && std::is_same<T, float>::value ? MATH_MAT4_ALIGN : alignof(vec<T, R>);
+}
 
-    float &operator[](const int i);
-    const float &operator[](const int i) const;
+template <typename T, int R, int C>
+struct alignas(matAlignment<T, R, C>()) mat
+{
+    constexpr mat() = default;
+    constexpr mat(const T diagonal);
 
-    // Friend operators
-    friend vec4 operator*(const float lhs, const vec4 &rhs)
+    // One vec<T, R> per column.
+    template <typename... Cols,
+              std::enable_if_t<sizeof...(Cols) == C && (std::is_same_v<Cols, vec<T, R>> && ...), int> = 0>
+    constexpr mat(const Cols &...columns) : cols{columns...}
     {
-        return vec4{rhs.x * lhs, rhs.y * lhs, rhs.z * lhs, rhs.w * lhs};
     }
 
-    friend vec4 operator*(const vec4 &lhs, const float rhs)
+    // R * C values, column by column.
+    template <typename... Ts, std::enable_if_t<sizeof...(Ts) == R * C && (std::is_arithmetic_v<Ts> && ...), int> = 0>
+    constexpr mat(const Ts... values) : cols{}
     {
-        return vec4{rhs * lhs.x, rhs * lhs.y, rhs * lhs.z, rhs * lhs.w};
+        const T v[] = {static_cast<T>(values)...};
+        for (int c = 0; c < C; c++)
+        {
+            for (int r = 0; r < R; r++)
+            {
+                cols[c][r] = v[c * R + r];
+            }
+        }
     }
-};
 
-struct mat2
-{
-    mat2() = default;
-    mat2(const float diagonal);
-    mat2(const vec2 col0, const vec2 col1);
-    mat2(const float m00, const float m01, const float m10, const float m11);
+    // Converts the element type and/or takes the upper left block, e.g. mat3{mat4}. Missing diagonal entries are 1.
+    template <typename U, int R2, int C2>
+    explicit constexpr mat(const mat<U, R2, C2> &rhs);
 
-    float determinant() const;
+    constexpr vec<T, C> row(const int i) const;
+    constexpr mat<T, C, R> transpose() const;
 
-    mat2 transpose() const;
-    mat2 minor() const;
-    mat2 cofactor() const;
-    mat2 adjugate() const;
-    mat2 inverse() const;
+    // Square matrices only. minor() and cofactor() are implemented for 2x2 and 3x3.
+    constexpr T determinant() const;
+    constexpr mat minor() const;
+    constexpr mat cofactor() const;
+    constexpr mat adjugate() const;
+    constexpr mat inverse() const;
 
-    vec2 row0() const;
-    vec2 row1() const;
+    // 4x4 only. Inverse of a matrix whose last row is [0 0 0 1] (rigid and TRS transforms).
+    constexpr mat affineInverse() const;
 
     // Operators
-    vec2 &operator[](const int i);
-    const vec2 &operator[](const int i) const;
-
-    mat2 operator/(const float rhs) const;
+    constexpr vec<T, R> &operator[](const int i);
+    constexpr const vec<T, R> &operator[](const int i) const;
 
-    mat2 operator*(const mat2 &rhs) const;
-    void operator*=(const float rhs);
-
-    bool operator==(const mat2 &rhs) const;
-
-    // Friend operators
-    friend std::ostream &operator<<(std::ostream &os, const mat2 &m2);
-
-    vec2 col0;
-    vec2 col1;
+    vec<T, R> cols[C];
 };
 
-struct mat3
-{
-    mat3() = default;
-    mat3(const float diagonal);
-    mat3(const vec3 col0, const vec3 col1, const vec3 col2);
-    mat3(const float m00, const float m01, const float m02, const float m10, const float m11, const float m12,
-         const float m20, const float m21, const float m22);
-    mat3(const mat4 &m4);
-
-    float determinant() const;
-
-    mat3 transpose() const;
-    mat3 minor() const;
-    mat3 cofactor() const;
-    mat3 adjugate() const;
-    mat3 inverse() const;
-
-    vec3 row0() const;
-    vec3 row1() const;
-    vec3 row2() const;
-
-    // Operators
-    vec3 &operator[](const int i);
-    const vec3 &operator[](const int i) const;
-
-    mat3 operator/(const float rhs) const;
-
-    mat3 operator*(const float rhs) const;
-    mat3 operator*(const mat3 &rhs) const;
-
-    bool operator==(const mat3 &rhs) const;
-
-    // Friend operators
-    friend std::ostream &operator<<(std::ostream &os, const mat3 &m3);
-
-    vec3 col0;
-    vec3 col1;
-    vec3 col2;
-};
+static_assert(sizeof(vec3) == 3 * sizeof(float) && sizeof(vec4) == 4 * sizeof(float), "vec must be tightly packed");
+static_assert(sizeof(mat3) == 9 * sizeof(float) && sizeof(mat4) == 16 * sizeof(float), "mat must be tightly packed");
+////////////////////////////////////////////////////////////////
 
-struct mat4
+/////////////////////////// vec ////////////////////////////////
+template <typename T, int N>
+constexpr T &vecBase<T, N>::operator[](const int i)
 {
-    mat4() = default;
-    mat4(const float diagonal);
-    mat4(const mat4 &rhs);
-
-    mat4(const float m00, const float m01, const float m02, const float m03, const float m10, const float m11,
-         const float m12, const float m13, const float m20, const float m21, const float m22, const float m23,
-         const float m30, const float m31, const float m32, const float m33);
-
-    float determinant() const;
-
-    /* mat4 transpose() const; */
-    /* mat4 adjugate() const; */
-    /* mat4 inverse() const; */
-
-    // Operators
-    vec4 &operator[](const int i);
-    const vec4 &operator[](const int i) const;
+    auto &s = self();
 
-    bool operator==(const mat4 &rhs) const;
-
-    mat4 operator*(const mat4 &rhs);
-
-    mat4 operator/(const float rhs) const;
-
-    // Friend operators
-    friend std::ostream &operator<<(std::ostream &os, const mat4 &m4);
+    if (MATH_IS_CONSTANT_EVALUATED())
+    {
+        if constexpr (N == 2)
+        {
+            return i == 0 ? s.x : s.y;
+        }
+        else if constexpr (N == 3)
+        {
+            return i == 0 ? s.x : i == 1 ? s.y : s.z;
+        }
+        else
+        {
+            return i == 0 ? s.x : i == 1 ? s.y : i == 2 ? s.z : s.w;
+        }
+    }
+    return (&s.x)[i];
+}
 
-    vec4 col0;
-    vec4 col1;
-    vec4 col2;
-    vec4 col3;
-};
+template <typename T, int N>
+constexpr const T &vecBase<T, N>::operator[](const int i) const
+{
+    return const_cast<vecBase &>(*this)[i];
+}
 
-/////////////////////////// vec2 ////////////////////////////////
-inline vec2::vec2() : x(0), y(0) {}
+template <typename T, int N>
+constexpr T vecBase<T, N>::dot(const vec<T, N> &rhs) const
+{
+    const auto &v = self();
+    if constexpr (N == 2)
+    {
+        return static_cast<T>(v.x * rhs.x + v.y * rhs.y);
+    }
+    else if constexpr (N == 3)
+    {
+        return static_cast<T>(v.x * rhs.x + v.y * rhs.y + v.z * rhs.z);
+    }
+    else
+    {
+        return static_cast<T>(v.x * rhs.x + v.y * rhs.y + v.z * rhs.z + v.w * rhs.w);
+    }
+}
 
-inline vec2::vec2(const float x, const float y) : x(x), y(y) {}
+template <typename T, int N>
+constexpr T vecBase<T, N>::magnitude() const
+{
+    if constexpr (std::is_same<T, float>::value)
+    {
+        return constexprSqrt(dot(self()));
+    }
+    else
+    {
+        return static_cast<T>(std::sqrt(dot(self())));
+    }
+}
 
-inline float &vec2::operator[](const int i) { return (&x)[i]; }
+template <typename T, int N>
+constexpr vec<T, N> vecBase<T, N>::normalize() const
+{
+    return self() / magnitude();
+}
 
-inline const float &vec2::operator[](const int i) const { return (&x)[i]; }
+template <typename T>
+constexpr vec<T, 2>::vec() : x(0), y(0)
+{
+}
 
-inline vec2 vec2::operator/(const float rhs) const { return vec2{x / rhs, y / rhs}; }
+template <typename T>
+constexpr vec<T, 2>::vec(const T x, const T y) : x(x), y(y)
+{
+}
 
-inline vec2 vec2::operator*(const vec2 &rhs) const { return vec2{x * rhs.x, y * rhs.y}; }
+template <typename T>
+template <typename U>
+constexpr vec<T, 2>::vec(const vec<U, 2> &rhs) : x(static_cast<T>(rhs.x)), y(static_cast<T>(rhs.y))
+{
+}
 
-inline bool vec2::operator==(const vec2 &rhs) const { return x == rhs.x && y == rhs.y; }
-inline bool vec2::operator!=(const vec2 &rhs) const { return x != rhs.x || y != rhs.y; }
-/////////////////////////////////////////////////////////////////
+template <typename T>
+constexpr vec<T, 3>::vec() : x(0), y(0), z(0)
+{
+}
 
-/////////////////////////// vec3 ////////////////////////////////
-inline vec3::vec3() : x(0), y(0), z(0) {}
+template <typename T>
+constexpr vec<T, 3>::vec(const T x, const T y, const T z) : x(x), y(y), z(z)
+{
+}
 
-inline vec3::vec3(const float x, const float y, const float z) : x(x), y(y), z(z) {}
+template <typename T>
+constexpr vec<T, 3>::vec(const T val) : x(val), y(val), z(val)
+{
+}
 
-inline vec3::vec3(const float val) : x(val), y(val), z(val) {}
+template <typename T>
+template <typename U>
+constexpr vec<T, 3>::vec(const vec<U, 3> &rhs)
+    : x(static_cast<T>(rhs.x)), y(static_cast<T>(rhs.y)), z(static_cast<T>(rhs.z))
+{
+}
 
-inline vec3 vec3::cross(const vec3 &rhs) const
+template <typename T>
+constexpr vec<T, 3> vec<T, 3>::cross(const vec &rhs) const
 {
-    return vec3{
+    return vec{
         (y * rhs.z) - (z * rhs.y),
         (z * rhs.x) - (x * rhs.z),
         (x * rhs.y) - (y * rhs.x),
     };
 }
 
-inline float vec3::dot(const vec3 &rhs) const { return x * rhs.x + y * rhs.y + z * rhs.z; }
-
-inline vec3 vec3::normalize() const { return *this / magnitude(); }
-
-inline float vec3::magnitude() const { return sqrt(pow(x, 2) + pow(y, 2) + pow(z, 2)); }
-
-inline vec3 vec3::operator*(const float &rhs) const { return vec3{x * rhs, y * rhs, z * rhs}; }
-
-inline void vec3::operator*=(const float &rhs)
+template <typename T>
+constexpr vec<T, 4>::vec() : x(0), y(0), z(0), w(0)
 {
-    x *= rhs;
-    y *= rhs;
-    z *= rhs;
 }
 
-inline vec3 vec3::operator*(const vec3 &rhs) const { return vec3{x * rhs.x, y * rhs.y, z * rhs.z}; }
-
-inline void vec3::operator*=(const vec3 &rhs)
+template <typename T>
+constexpr vec<T, 4>::vec(const T x, const T y, const T z, const T w) : x(x), y(y), z(z), w(w)
 {
-    x *= rhs.x;
-    y *= rhs.y;
-    z *= rhs.z;
 }
 
-inline vec3 vec3::operator-(const vec3 &rhs) const { return vec3{x - rhs.x, y - rhs.y, z - rhs.z}; }
-
-inline void vec3::operator-=(const vec3 &rhs)
+template <typename T>
+template <typename U>
+constexpr vec<T, 4>::vec(const vec<U, 4> &rhs)
+    : x(static_cast<T>(rhs.x)), y(static_cast<T>(rhs.y)), z(static_cast<T>(rhs.z)), w(static_cast<T>(rhs.w))
 {
-    x -= rhs.x;
-    y -= rhs.y;
-    z -= rhs.z;
 }
 
-inline vec3 vec3::operator+(const vec3 &rhs) const { return vec3{x + rhs.x, y + rhs.y, z + rhs.z}; }
-
-inline void vec3::operator+=(const vec3 &rhs)
+// Operators
+// The components are spelled out per size: a loop over operator[] indexes the unions through a pointer, which GCC
+// and Clang don't turn back into plain member accesses and which made vec3 arithmetic several times slower.
+template <typename T, int N, typename Op>
+constexpr vec<T, N> componentwise(const vec<T, N> &lhs, const vec<T, N> &rhs, Op op)
 {
-    x += rhs.x;
-    y += rhs.y;
-    z += rhs.z;
+    if constexpr (N == 2)
+    {
+        return vec<T, N>{op(lhs.x, rhs.x), op(lhs.y, rhs.y)};
+    }
+    else if constexpr (N == 3)
+    {
+        return vec<T, N>{op(lhs.x, rhs.x), op(lhs.y, rhs.y), op(lhs.z, rhs.z)};
+    }
+    else
+    {
+        return vec<T, N>{op(lhs.x, rhs.x), op(lhs.y, rhs.y), op(lhs.z, rhs.z), op(lhs.w, rhs.w)};
+    }
 }
 
-inline vec3 vec3::operator/(const float &rhs) const { return vec3{x / rhs, y / rhs, z / rhs}; }
-
-inline bool vec3::operator!=(const vec3 &rhs) const { return x != rhs.x || y != rhs.y || z != rhs.z; }
-
-inline bool vec3::operator==(const vec3 &rhs) const { return x == rhs.x && y == rhs.y && z == rhs.z; }
-
-inline float &vec3::operator[](const int i) { return (&x)[i]; }
-
-inline const float &vec3::operator[](const int i) const { return (&x)[i]; }
-
-inline std::ostream &operator<<(std::ostream &os, const vec3 &v3)
+template <typename T, int N>
+constexpr vec<T, N> operator+(const vec<T, N> &lhs, const vec<T, N> &rhs)
 {
-    os << "[ " << v3.x << " " << v3.y << " " << v3.z << " ]";
-    return os;
+    return componentwise(lhs, rhs, [](const T a, const T b) { return static_cast<T>(a + b); });
 }
-////////////////////////////////////////////////////////////////
-
-/////////////////////////// vec4 ////////////////////////////////
-inline vec4::vec4() : x(0), y(0), z(0), w(0) {}
-
-inline vec4::vec4(const float x, const float y, const float z, const float w) : x(x), y(y), z(z), w(w) {}
-
-inline float &vec4::operator[](const int i) { return (&x)[i]; }
-
-inline const float &vec4::operator[](const int i) const { return (&x)[i]; }
 
-inline vec4 vec4::operator*(const vec4 &rhs) const { return vec4{x * rhs.x, y * rhs.y, z * rhs.z, w * rhs.w}; }
-
-inline vec4 vec4::operator+(const vec4 &rhs) const { return vec4{x + rhs.x, y + rhs.y, z + rhs.z, w + rhs.w}; }
-
-inline vec4 vec4::operator/(const float rhs) const { return vec4{x / rhs, y / rhs, z / rhs, w / rhs}; }
+template <typename T, int N>
+constexpr vec<T, N> operator-(const vec<T, N> &lhs, const vec<T, N> &rhs)
+{
+    return componentwise(lhs, rhs, [](const T a, const T b) { return static_cast<T>(a - b); });
+}
 
-inline bool vec4::operator==(const vec4 &rhs) const { return x == rhs.x && y == rhs.y && z == rhs.z && w == rhs.w; }
+template <typename T, int N>
+constexpr vec<T, N> operator-(const vec<T, N> &rhs)
+{
+    return componentwise(rhs, rhs, [](const T a, const T) { return static_cast<T>(-a); });
+}
 
-inline float vec4::dot(const vec4 &rhs) const { return x * rhs.x + y * rhs.y + z * rhs.z + w * rhs.w; }
-/////////////////////////////////////////////////////////////////
+template <typename T, int N>
+constexpr vec<T, N> operator*(const vec<T, N> &lhs, const vec<T, N> &rhs)
+{
+    return componentwise(lhs, rhs, [](const T a, const T b) { return static_cast<T>(a * b); });
+}
 
-/////////////////////////// mat2 ////////////////////////////////
+template <typename T, int N>
+constexpr vec<T, N> operator*(const vec<T, N> &lhs, const typename vec<T, N>::value_type rhs)
+{
+    return componentwise(lhs, lhs, [rhs](const T a, const T) { return static_cast<T>(a * rhs); });
+}
 
-inline mat2::mat2(const float diagonal) : col0(diagonal, 0), col1(0, diagonal) {}
+template <typename T, int N>
+constexpr vec<T, N> operator*(const typename vec<T, N>::value_type lhs, const vec<T, N> &rhs)
+{
+    return rhs * lhs;
+}
 
-inline mat2::mat2(const vec2 col0, const vec2 col1) : col0(col0), col1(col1) {}
+template <typename T, int N>
+constexpr vec<T, N> operator/(const vec<T, N> &lhs, const typename vec<T, N>::value_type rhs)
+{
+    return componentwise(lhs, lhs, [rhs](const T a, const T) { return static_cast<T>(a / rhs); });
+}
 
-inline mat2::mat2(const float m00, const float m01, const float m10, const float m11) : col0(m00, m01), col1(m10, m11)
+template <typename T, int N>
+constexpr vec<T, N> &operator+=(vec<T, N> &lhs, const vec<T, N> &rhs)
 {
+    // In place, for accumulators in loops.
+    lhs.x += rhs.x;
+    lhs.y += rhs.y;
+    if constexpr (N > 2)
+    {
+        lhs.z += rhs.z;
+    }
+    if constexpr (N > 3)
+    {
+        lhs.w += rhs.w;
+    }
+    return lhs;
 }
 
-inline float mat2::determinant() const { return col0[0] * col1[1] - col0[1] * col1[0]; }
+template <typename T, int N>
+constexpr vec<T, N> &operator-=(vec<T, N> &lhs, const vec<T, N> &rhs)
+{
+    // In place, for accumulators in loops.
+    lhs.x -= rhs.x;
+    lhs.y -= rhs.y;
+    if constexpr (N > 2)
+    {
+        lhs.z -= rhs.z;
+    }
+    if constexpr (N > 3)
+    {
+        lhs.w -= rhs.w;
+    }
+    return lhs;
+}
 
-inline mat2 mat2::transpose() const
+template <typename T, int N>
+constexpr vec<T, N> &operator*=(vec<T, N> &lhs, const vec<T, N> &rhs)
 {
-    const auto r0 = row0();
-    const auto r1 = row1();
+    return lhs = lhs * rhs;
+}
 
-    return mat2{r0, r1};
+template <typename T, int N>
+constexpr vec<T, N> &operator*=(vec<T, N> &lhs, const typename vec<T, N>::value_type rhs)
+{
+    return lhs = lhs * rhs;
 }
 
-inline mat2 mat2::minor() const
+template <typename T, int N>
+constexpr vec<T, N> &operator/=(vec<T, N> &lhs, const typename vec<T, N>::value_type rhs)
 {
-    return mat2{
-        (*this)[1][1], (*this)[1][0],  // Col 0
-        (*this)[0][1], (*this)[0][0],  // Col 1
-    };
+    return lhs = lhs / rhs;
 }
 
-inline mat2 mat2::cofactor() const
+template <typename T, int N>
+constexpr bool operator==(const vec<T, N> &lhs, const vec<T, N> &rhs)
 {
-    mat2 m = minor();
-    m[0][1] *= -1;
-    m[1][0] *= -1;
-    return m;
+    if constexpr (N == 2)
+    {
+        return lhs.x == rhs.x && lhs.y == rhs.y;
+    }
+    else if constexpr (N == 3)
+    {
+        return lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z;
+    }
+    else
+    {
+        return lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z && lhs.w == rhs.w;
+    }
 }
 
-inline mat2 mat2::adjugate() const { return cofactor().transpose(); }
+template <typename T, int N>
+constexpr bool operator!=(const vec<T, N> &lhs, const vec<T, N> &rhs)
+{
+    return !(lhs == rhs);
+}
 
-inline mat2 mat2::inverse() const { return adjugate() / determinant(); }
+template <typename T, int N>
+inline std::ostream &operator<<(std::ostream &os, const vec<T, N> &v)
+{
+    os << "[ ";
+    for (int i = 0; i < N; i++)
+    {
+        os << v[i] << " ";
+    }
+    os << "]";
+    return os;
+}
+/////////////////////////////////////////////////////////////////
 
-inline vec2 mat2::row0() const { return vec2{(*this)[0][0], (*this)[1][0]}; }
+/////////////////////////// vec4 SIMD ///////////////////////////
+#if defined(MATH_SIMD_SSE41)
+inline __m128 simdLoad(const vec4 &v) { return _mm_load_ps(&v.x); }
 
-inline vec2 mat2::row1() const { return vec2{(*this)[0][1], (*this)[1][1]}; }
+inline vec4 simdStore(const __m128 v)
+{
+    vec4 r;
+    _mm_store_ps(&r.x, v);
+    return r;
+}
 
-// Write matrix in row major on the ostream.
-inline std::ostream &operator<<(std::ostream &os, const mat2 &m2)
+template <>
+constexpr float vecBase<float, 4>::dot(const vec4 &rhs) const
 {
-    os << "[" << m2[0][0] << " " << m2[1][0] << "]\n";
-    os << "[" << m2[0][1] << " " << m2[1][1] << "]\n";
-    return os;
+    if (!MATH_IS_CONSTANT_EVALUATED())
+    {
+        // Summed left to right like the scalar code; _mm_dp_ps() adds (x + y) + (z + w).
+        const __m128 p = _mm_mul_ps(simdLoad(self()), simdLoad(rhs));
+        __m128 sum = _mm_add_ss(p, _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1)));
+        sum = _mm_add_ss(sum, _mm_movehl_ps(p, p));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 3, 3)));
+        return _mm_cvtss_f32(sum);
+    }
+    return self().x * rhs.x + self().y * rhs.y + self().z * rhs.z + self().w * rhs.w;
 }
 
-inline vec2 &mat2::operator[](const int i) { return (&col0)[i]; }
-inline const vec2 &mat2::operator[](const int i) const { return (&col0)[i]; }
+template <>
+constexpr vec4 operator+<float, 4>(const vec4 &lhs, const vec4 &rhs)
+{
+    if (!MATH_IS_CONSTANT_EVALUATED())
+    {
+        return simdStore(_mm_add_ps(simdLoad(lhs), simdLoad(rhs)));
+    }
+    return vec4{lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z, lhs.w + rhs.w};
+}
 
-inline mat2 mat2::operator/(const float rhs) const
+template <>
+constexpr vec4 operator-<float, 4>(const vec4 &lhs, const vec4 &rhs)
 {
-    return mat2{
-        (*this)[0] / rhs,  // Col 0
-        (*this)[1] / rhs,  // Col 1
-    };
+    if (!MATH_IS_CONSTANT_EVALUATED())
+    {
+        return simdStore(_mm_sub_ps(simdLoad(lhs), simdLoad(rhs)));
+    }
+    return vec4{lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z, lhs.w - rhs.w};
 }
 
-inline mat2 mat2::operator*(const mat2 &rhs) const
+template <>
+constexpr vec4 operator*<float, 4>(const vec4 &lhs, const vec4 &rhs)
 {
-    return mat2{
-        (*this)[0][0] * rhs[0][0] + (*this)[1][0] * rhs[0][1],
-        (*this)[0][1] * rhs[0][0] + (*this)[1][1] * rhs[0][1],  // Col 0
-        (*this)[0][0] * rhs[1][0] + (*this)[1][0] * rhs[1][1],
-        (*this)[0][1] * rhs[1][0] + (*this)[1][1] * rhs[1][1],  // Col 1
-    };
+    if (!MATH_IS_CONSTANT_EVALUATED())
+    {
+        return simdStore(_mm_mul_ps(simdLoad(lhs), simdLoad(rhs)));
+    }
+    return vec4{lhs.x * rhs.x, lhs.y * rhs.y, lhs.z * rhs.z, lhs.w * rhs.w};
 }
 
-inline void mat2::operator*=(const float rhs)
+template <>
+constexpr vec4 operator*<float, 4>(const vec4 &lhs, const float rhs)
 {
-    (*this)[0][0] *= rhs;
-    (*this)[0][1] *= rhs;
-    (*this)[1][0] *= rhs;
-    (*this)[1][1] *= rhs;
+    if (!MATH_IS_CONSTANT_EVALUATED())
+    {
+        return simdStore(_mm_mul_ps(simdLoad(lhs), _mm_set1_ps(rhs)));
+    }
+    return vec4{lhs.x * rhs, lhs.y * rhs, lhs.z * rhs, lhs.w * rhs};
 }
 
-inline bool mat2::operator==(const mat2 &rhs) const { return (*this)[0] == rhs[0] && (*this)[1] == rhs[1]; }
+template <>
+constexpr vec4 operator/<float, 4>(const vec4 &lhs, const float rhs)
+{
+    if (!MATH_IS_CONSTANT_EVALUATED())
+    {
+        return simdStore(_mm_div_ps(simdLoad(lhs), _mm_set1_ps(rhs)));
+    }
+    return vec4{lhs.x / rhs, lhs.y / rhs, lhs.z / rhs, lhs.w / rhs};
+}
+#endif
 /////////////////////////////////////////////////////////////////
 
-/////////////////////////// mat3 ////////////////////////////////
-inline mat3::mat3(const float diagonal)
-    : col0{diagonal, 0.0f, 0.0f}, col1{0.0f, diagonal, 0.0f}, col2{0.0f, 0.0f, diagonal}
+/////////////////////////// mat ////////////////////////////////
+template <typename T, int R, int C>
+constexpr mat<T, R, C>::mat(const T diagonal) : cols{}
 {
+    for (int i = 0; i < R && i < C; i++)
+    {
+        cols[i][i] = diagonal;
+    }
 }
 
-inline mat3::mat3(const vec3 col0, const vec3 col1, const vec3 col2) : col0(col0), col1(col1), col2(col2) {}
+template <typename T, int R, int C>
+template <typename U, int R2, int C2>
+constexpr mat<T, R, C>::mat(const mat<U, R2, C2> &rhs) : cols{}
+{
+    for (int c = 0; c < C; c++)
+    {
+        for (int r = 0; r < R; r++)
+        {
+            cols[c][r] = c < C2 && r < R2 ? static_cast<T>(rhs[c][r]) : static_cast<T>(r == c ? 1 : 0);
+        }
+    }
+}
 
-inline mat3::mat3(const float m00, const float m01, const float m02, const float m10, const float m11, const float m12,
-                  const float m20, const float m21, const float m22)
-    : col0(m00, m01, m02), col1(m10, m11, m12), col2(m20, m21, m22)
+template <typename T, int R, int C>
+constexpr vec<T, R> &mat<T, R, C>::operator[](const int i)
 {
+    return cols[i];
 }
 
-inline mat3::mat3(const mat4 &m4)
-    : col0(m4[0].x, m4[0].y, m4[0].z), col1(m4[1].x, m4[1].y, m4[1].z), col2(m4[2].x, m4[2].y, m4[2].z)
+template <typename T, int R, int C>
+constexpr const vec<T, R> &mat<T, R, C>::operator[](const int i) const
 {
+    return cols[i];
 }
 
-inline float mat3::determinant() const
+template <typename T, int R, int C>
+constexpr vec<T, C> mat<T, R, C>::row(const int i) const
 {
-    const mat2 a{
-        (*this)[1][1], (*this)[1][2],  // col 0
-        (*this)[2][1], (*this)[2][2],  // col 1
-    };
+    vec<T, C> v;
+    for (int c = 0; c < C; c++)
+    {
+        v[c] = cols[c][i];
+    }
+    return v;
+}
 
-    const mat2 b{
-        (*this)[0][1], (*this)[0][2],  // col 0
-        (*this)[2][1], (*this)[2][2],  // col 1
-    };
+template <typename T, int R, int C>
+constexpr mat<T, C, R> mat<T, R, C>::transpose() const
+{
+    mat<T, C, R> t;
+    for (int r = 0; r < R; r++)
+    {
+        t[r] = row(r);
+    }
+    return t;
+}
 
-    const mat2 c{
-        (*this)[0][1], (*this)[0][2],  // col 0
-        (*this)[1][1], (*this)[1][2],  // col 1
-    };
+template <typename T, int R, int C>
+constexpr T mat<T, R, C>::determinant() const
+{
+    static_assert(R == C && R >= 2 && R <= 4, "determinant() needs a 2x2, 3x3 or 4x4 matrix");
 
-    const auto aPivot = (*this)[0][0];
-    const auto bPivot = (*this)[1][0];
-    const auto cPivot = (*this)[2][0];
+    const auto &m = *this;
 
-    return aPivot * a.determinant() - bPivot * b.determinant() + cPivot * c.determinant();
+    if constexpr (R == 2)
+    {
+        return m[0][0] * m[1][1] - m[0][1] * m[1][0];
+    }
+    else if constexpr (R == 3)
+    {
+        const mat<T, 2, 2> a{
+            m[1][1], m[1][2],  // col 0
+            m[2][1], m[2][2],  // col 1
+        };
+
+        const mat<T, 2, 2> b{
+            m[0][1], m[0][2],  // col 0
+            m[2][1], m[2][2],  // col 1
+        };
+
+        const mat<T, 2, 2> c{
+            m[0][1], m[0][2],  // col 0
+            m[1][1], m[1][2],  // col 1
+        };
+
+        return m[0][0] * a.determinant() - m[1][0] * b.determinant() + m[2][0] * c.determinant();
+    }
+    else
+    {
+        const mat<T, 3, 3> a{
+            m[1][1], m[1][2], m[1][3],  // col 0
+            m[2][1], m[2][2], m[2][3],  // col 1
+            m[3][1], m[3][2], m[3][3],  // col 2
+        };
+
+        const mat<T, 3, 3> b{
+            m[0][1], m[0][2], m[0][3],  // col 0
+            m[2][1], m[2][2], m[2][3],  // col 1
+            m[3][1], m[3][2], m[3][3],  // col 2
+        };
+
+        const mat<T, 3, 3> c{
+            m[0][1], m[0][2], m[0][3],  // col 0
+            m[1][1], m[1][2], m[1][3],  // col 1
+            m[3][1], m[3][2], m[3][3],  // col 2
+        };
+
+        const mat<T, 3, 3> d{
+            m[0][1], m[0][2], m[0][3],  // col 0
+            m[1][1], m[1][2], m[1][3],  // col 1
+            m[2][1], m[2][2], m[2][3],  // col 2
+        };
+
+        return m[0][0] * a.determinant() - m[1][0] * b.determinant() + m[2][0] * c.determinant() -
+               m[3][0] * d.determinant();
+    }
 }
 
-inline mat3 mat3::minor() const
+template <typename T, int R, int C>
+constexpr mat<T, R, C> mat<T, R, C>::minor() const
 {
-    mat3 m;
+    static_assert(R == C && R >= 2 && R <= 3, "minor() needs a 2x2 or 3x3 matrix");
 
-    m[0][0] = mat2{(*this)[1][1], (*this)[1][2], (*this)[2][1], (*this)[2][2]}.determinant();
-    m[0][1] = mat2{(*this)[1][0], (*this)[1][2], (*this)[2][0], (*this)[2][2]}.determinant();
-    m[0][2] = mat2{(*this)[1][0], (*this)[1][1], (*this)[2][0], (*this)[2][1]}.determinant();
+    const auto &m = *this;
 
-    m[1][0] = mat2{(*this)[0][1], (*this)[0][2], (*this)[2][1], (*this)[2][2]}.determinant();
-    m[1][1] = mat2{(*this)[0][0], (*this)[0][2], (*this)[2][0], (*this)[2][2]}.determinant();
-    m[1][2] = mat2{(*this)[0][0], (*this)[0][1], (*this)[2][0], (*this)[2][1]}.determinant();
+    if constexpr (R == 2)
+    {
+        return mat{
+            m[1][1], m[1][0],  // Col 0
+            m[0][1], m[0][0],  // Col 1
+        };
+    }
+    else
+    {
+        mat n;
 
-    m[2][0] = mat2{(*this)[0][1], (*this)[0][2], (*this)[1][1], (*this)[1][2]}.determinant();
-    m[2][1] = mat2{(*this)[0][0], (*this)[0][2], (*this)[1][0], (*this)[1][2]}.determinant();
-    m[2][2] = mat2{(*this)[0][0], (*this)[0][1], (*this)[1][0], (*this)[1][1]}.determinant();
+        n[0][0] = mat<T, 2, 2>{m[1][1], m[1][2], m[2][1], m[2][2]}.determinant();
+        n[0][1] = mat<T, 2, 2>{m[1][0], m[1][2], m[2][0], m[2][2]}.determinant();
+        n[0][2] = mat<T, 2, 2>{m[1][0], m[1][1], m[2][0], m[2][1]}.determinant();
 
-    return m;
+        n[1][0] = mat<T, 2, 2>{m[0][1], m[0][2], m[2][1], m[2][2]}.determinant();
+        n[1][1] = mat<T, 2, 2>{m[0][0], m[0][2], m[2][0], m[2][2]}.determinant();
+        n[1][2] = mat<T, 2, 2>{m[0][0], m[0][1], m[2][0], m[2][1]}.determinant();
+
+        n[2][0] = mat<T, 2, 2>{m[0][1], m[0][2], m[1][1], m[1][2]}.determinant();
+        n[2][1] = mat<T, 2, 2>{m[0][0], m[0][2], m[1][0], m[1][2]}.determinant();
+        n[2][2] = mat<T, 2, 2>{m[0][0], m[0][1], m[1][0], m[1][1]}.determinant();
+
+        return n;
+    }
 }
 
-inline mat3 mat3::cofactor() const
+template <typename T, int R, int C>
+constexpr mat<T, R, C> mat<T, R, C>::cofactor() const
 {
-    mat3 c = minor();
-    c[0][1] *= -1;
-    c[1][0] *= -1;
-    c[1][2] *= -1;
-    c[2][1] *= -1;
+    mat c = minor();
+    for (int i = 0; i < C; i++)
+    {
+        for (int j = 0; j < R; j++)
+        {
+            if ((i + j) % 2 == 1)
+            {
+                c[i][j] *= -1;
+            }
+        }
+    }
     return c;
 }
 
-inline mat3 mat3::transpose() const
+template <typename T, int R, int C>
+constexpr mat<T, R, C> mat<T, R, C>::adjugate() const
 {
-    const auto r0 = row0();
-    const auto r1 = row1();
-    const auto r2 = row2();
+    static_assert(R == C && R >= 2 && R <= 4, "adjugate() needs a 2x2, 3x3 or 4x4 matrix");
 
-    return mat3{r0, r1, r2};
+    if constexpr (R < 4)
+    {
+        return cofactor().transpose();
+    }
+    else
+    {
+        // Cofactor expansion sharing the 2x2 minors of the first two and last two columns, so every 3x3 minor is
+        // built from 12 precomputed determinants instead of being expanded on its own.
+        const auto &m = *this;
+
+        const auto s0 = m[0][0] * m[1][1] - m[1][0] * m[0][1];
+        const auto s1 = m[0][0] * m[1][2] - m[1][0] * m[0][2];
+        const auto s2 = m[0][0] * m[1][3] - m[1][0] * m[0][3];
+        const auto s3 = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+        const auto s4 = m[0][1] * m[1][3] - m[1][1] * m[0][3];
+        const auto s5 = m[0][2] * m[1][3] - m[1][2] * m[0][3];
+
+        const auto c5 = m[2][2] * m[3][3] - m[3][2] * m[2][3];
+        const auto c4 = m[2][1] * m[3][3] - m[3][1] * m[2][3];
+        const auto c3 = m[2][1] * m[3][2] - m[3][1] * m[2][2];
+        const auto c2 = m[2][0] * m[3][3] - m[3][0] * m[2][3];
+        const auto c1 = m[2][0] * m[3][2] - m[3][0] * m[2][2];
+        const auto c0 = m[2][0] * m[3][1] - m[3][0] * m[2][1];
+
+        mat a;
+
+        // Col 0
+        a[0][0] = m[1][1] * c5 - m[1][2] * c4 + m[1][3] * c3;
+        a[0][1] = -m[0][1] * c5 + m[0][2] * c4 - m[0][3] * c3;
+        a[0][2] = m[3][1] * s5 - m[3][2] * s4 + m[3][3] * s3;
+        a[0][3] = -m[2][1] * s5 + m[2][2] * s4 - m[2][3] * s3;
+
+        // Col 1
+        a[1][0] = -m[1][0] * c5 + m[1][2] * c2 - m[1][3] * c1;
+        a[1][1] = m[0][0] * c5 - m[0][2] * c2 + m[0][3] * c1;
+        a[1][2] = -m[3][0] * s5 + m[3][2] * s2 - m[3][3] * s1;
+        a[1][3] = m[2][0] * s5 - m[2][2] * s2 + m[2][3] * s1;
+
+        // Col 2
+        a[2][0] = m[1][0] * c4 - m[1][1] * c2 + m[1][3] * c0;
+        a[2][1] = -m[0][0] * c4 + m[0][1] * c2 - m[0][3] * c0;
+        a[2][2] = m[3][0] * s4 - m[3][1] * s2 + m[3][3] * s0;
+        a[2][3] = -m[2][0] * s4 + m[2][1] * s2 - m[2][3] * s0;
+
+        // Col 3
+        a[3][0] = -m[1][0] * c3 + m[1][1] * c1 - m[1][2] * c0;
+        a[3][1] = m[0][0] * c3 - m[0][1] * c1 + m[0][2] * c0;
+        a[3][2] = -m[3][0] * s3 + m[3][1] * s1 - m[3][2] * s0;
+        a[3][3] = m[2][0] * s3 - m[2][1] * s1 + m[2][2] * s0;
+
+        return a;
+    }
 }
 
-inline mat3 mat3::adjugate() const { return cofactor().transpose(); }
-
-inline mat3 mat3::inverse() const { return adjugate() / determinant(); }
-
-inline vec3 mat3::row0() const { return vec3{(*this)[0][0], (*this)[1][0], (*this)[2][0]}; }
-
-inline vec3 mat3::row1() const { return vec3{(*this)[0][1], (*this)[1][1], (*this)[2][1]}; }
+template <typename T, int R, int C>
+constexpr mat<T, R, C> mat<T, R, C>::inverse() const
+{
+    if constexpr (R < 4)
+    {
+        return adjugate() / determinant();
+    }
+    else
+    {
+        const mat a = adjugate();
 
-inline vec3 mat3::row2() const { return vec3{(*this)[0][2], (*this)[1][2], (*this)[2][2]}; }
+        // Expansion along the first row, reusing the cofactors already in the adjugate.
+        const auto &m = *this;
+        const auto det = m[0][0] * a[0][0] + m[1][0] * a[0][1] + m[2][0] * a[0][2] + m[3][0] * a[0][3];
 
-inline vec3 &mat3::operator[](const int i) { return (&col0)[i]; }
-inline const vec3 &mat3::operator[](const int i) const { return (&col0)[i]; }
+        return a * (T{1} / det);
+    }
+}
 
-inline mat3 mat3::operator/(const float rhs) const
+template <typename T, int R, int C>
+constexpr mat<T, R, C> mat<T, R, C>::affineInverse() const
 {
-    return mat3{
-        (*this)[0] / rhs,
-        (*this)[1] / rhs,
-        (*this)[2] / rhs,
+    static_assert(R == 4 && C == 4, "affineInverse() needs a 4x4 matrix");
+
+    const auto &m = *this;
+
+    const vec<T, 3> c0{m[0].x, m[0].y, m[0].z};
+    const vec<T, 3> c1{m[1].x, m[1].y, m[1].z};
+    const vec<T, 3> c2{m[2].x, m[2].y, m[2].z};
+    const vec<T, 3> t{m[3].x, m[3].y, m[3].z};
+
+    // Rows of the inverse 3x3 block are the cross products of the columns divided by the determinant.
+    const auto invDet = T{1} / c0.dot(c1.cross(c2));
+    const auto r0 = c1.cross(c2) * invDet;
+    const auto r1 = c2.cross(c0) * invDet;
+    const auto r2 = c0.cross(c1) * invDet;
+
+    return mat{
+        r0.x,       r1.x,       r2.x,       T{0},  // Col 0
+        r0.y,       r1.y,       r2.y,       T{0},  // Col 1
+        r0.z,       r1.z,       r2.z,       T{0},  // Col 2
+        -r0.dot(t), -r1.dot(t), -r2.dot(t), T{1},  // Col 3
     };
 }
 
-inline mat3 mat3::operator*(const float rhs) const
+// Operators
+template <typename T, int R, int K, int C>
+constexpr mat<T, R, C> operator*(const mat<T, R, K> &lhs, const mat<T, K, C> &rhs)
 {
-    return mat3{
-        (*this)[0] * rhs,
-        (*this)[1] * rhs,
-        (*this)[2] * rhs,
-    };
+    mat<T, R, C> m;
+    for (int c = 0; c < C; c++)
+    {
+        for (int r = 0; r < R; r++)
+        {
+            T d = lhs[0][r] * rhs[c][0];
+            for (int k = 1; k < K; k++)
+            {
+                d = d + lhs[k][r] * rhs[c][k];
+            }
+            m[c][r] = d;
+        }
+    }
+    return m;
 }
 
-inline mat3 mat3::operator*(const mat3 &rhs) const
+template <typename T, int R, int C>
+constexpr vec<T, R> operator*(const mat<T, R, C> &lhs, const vec<T, C> &rhs)
 {
-    mat3 r;
-
-    const vec3 lhsRow0{(*this)[0][0], (*this)[1][0], (*this)[2][0]};
-    const vec3 lhsRow1{(*this)[0][1], (*this)[1][1], (*this)[2][1]};
-    const vec3 lhsRow2{(*this)[0][2], (*this)[1][2], (*this)[2][2]};
+    vec<T, R> v = lhs[0] * rhs[0];
+    for (int c = 1; c < C; c++)
+    {
+        v = v + lhs[c] * rhs[c];
+    }
+    return v;
+}
 
-    r[0][0] = lhsRow0.dot(rhs[0]);
-    r[1][0] = lhsRow0.dot(rhs[1]);
-    r[2][0] = lhsRow0.dot(rhs[2]);
+template <typename T, int R, int C>
+constexpr mat<T, R, C> operator*(const mat<T, R, C> &lhs, const typename vec<T, R>::value_type rhs)
+{
+    mat<T, R, C> m;
+    for (int c = 0; c < C; c++)
+    {
+        m[c] = lhs[c] * rhs;
+    }
+    return m;
+}
 
-    r[0][1] = lhsRow1.dot(rhs[0]);
-    r[1][1] = lhsRow1.dot(rhs[1]);
-    r[2][1] = lhsRow1.dot(rhs[2]);
+template <typename T, int R, int C>
+constexpr mat<T, R, C> operator/(const mat<T, R, C> &lhs, const typename vec<T, R>::value_type rhs)
+{
+    mat<T, R, C> m;
+    for (int c = 0; c < C; c++)
+    {
+        m[c] = lhs[c] / rhs;
+    }
+    return m;
+}
 
-    r[0][2] = lhsRow2.dot(rhs[0]);
-    r[1][2] = lhsRow2.dot(rhs[1]);
-    r[2][2] = lhsRow2.dot(rhs[2]);
+template <typename T, int R, int C>
+constexpr mat<T, R, C> &operator*=(mat<T, R, C> &lhs, const typename vec<T, R>::value_type rhs)
+{
+    return lhs = lhs * rhs;
+}
 
-    return r;
+template <typename T, int R, int C>
+constexpr bool operator==(const mat<T, R, C> &lhs, const mat<T, R, C> &rhs)
+{
+    for (int c = 0; c < C; c++)
+    {
+        if (lhs[c] != rhs[c])
+        {
+            return false;
+        }
+    }
+    return true;
 }
 
-inline bool mat3::operator==(const mat3 &rhs) const
+template <typename T, int R, int C>
+constexpr bool operator!=(const mat<T, R, C> &lhs, const mat<T, R, C> &rhs)
 {
-    return (*this)[0] == rhs[0] && (*this)[1] == rhs[1] && (*this)[2] == rhs[2];
+    return !(lhs == rhs);
 }
 
 // Write matrix in row major on the ostream.
-inline std::ostream &operator<<(std::ostream &os, const mat3 &m3)
+template <typename T, int R, int C>
+inline std::ostream &operator<<(std::ostream &os, const mat<T, R, C> &m)
 {
-    os << "[ " << m3[0][0] << " " << m3[1][0] << " " << m3[2][0] << " ]\n";
-    os << "[ " << m3[0][1] << " " << m3[1][1] << " " << m3[2][1] << " ]\n";
-    os << "[ " << m3[0][2] << " " << m3[1][2] << " " << m3[2][2] << " ]\n";
+    for (int r = 0; r < R; r++)
+    {
+        os << m.row(r) << "\n";
+    }
     return os;
 }
 /////////////////////////////////////////////////////////////////
 
-/////////////////////////////////////////////////////////////////
-
-/////////////////////////// mat4 ////////////////////////////////
-inline mat4::mat4(const float diagonal)
-    : col0{diagonal, 0.0f, 0.0f, 0.0f},
-      col1{0.0f, diagonal, 0.0f, 0.0f},
-      col2{0.0f, 0.0f, diagonal, 0.0f},
-      col3{0.0f, 0.0f, 0.0f, diagonal}
+/////////////////////////// mat4 SIMD ///////////////////////////
+#if defined(MATH_SIMD_SSE41)
+template <>
+constexpr mat4 operator*<float, 4, 4, 4>(const mat4 &lhs, const mat4 &rhs)
 {
+    mat4 m;
+
+    if (MATH_IS_CONSTANT_EVALUATED())
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            for (int r = 0; r < 4; r++)
+            {
+                m[c][r] = lhs[0][r] * rhs[c][0] + lhs[1][r] * rhs[c][1] + lhs[2][r] * rhs[c][2] + lhs[3][r] * rhs[c][3];
+            }
+        }
+        return m;
+    }
+
+#if defined(MATH_SIMD_AVX2)
+    // Two result columns per iteration: each 128-bit lane holds one rhs column.
+    const __m256 c0 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&lhs[0]));
+    const __m256 c1 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&lhs[1]));
+    const __m256 c2 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&lhs[2]));
+    const __m256 c3 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&lhs[3]));
+
+    for (int i = 0; i < 4; i += 2)
+    {
+        const __m256 r = _mm256_load_ps(&rhs[i].x);
+
+        __m256 acc = _mm256_mul_ps(c0, _mm256_shuffle_ps(r, r, 0x00));
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(c1, _mm256_shuffle_ps(r, r, 0x55)));
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(c2, _mm256_shuffle_ps(r, r, 0xAA)));
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(c3, _mm256_shuffle_ps(r, r, 0xFF)));
+
+        _mm256_store_ps(&m[i].x, acc);
+    }
+#else
+    const __m128 c0 = simdLoad(lhs[0]);
+    const __m128 c1 = simdLoad(lhs[1]);
+    const __m128 c2 = simdLoad(lhs[2]);
+    const __m128 c3 = simdLoad(lhs[3]);
+
+    for (int i = 0; i < 4; i++)
+    {
+        const __m128 r = simdLoad(rhs[i]);
+
+        __m128 acc = _mm_mul_ps(c0, _mm_shuffle_ps(r, r, 0x00));
+        acc = _mm_add_ps(acc, _mm_mul_ps(c1, _mm_shuffle_ps(r, r, 0x55)));
+        acc = _mm_add_ps(acc, _mm_mul_ps(c2, _mm_shuffle_ps(r, r, 0xAA)));
+        acc = _mm_add_ps(acc, _mm_mul_ps(c3, _mm_shuffle_ps(r, r, 0xFF)));
+
+        _mm_store_ps(&m[i].x, acc);
+    }
+#endif
+
+    return m;
 }
-inline mat4::mat4(const mat4 &r) : col0(r.col0), col1(r.col1), col2(r.col2), col3(r.col3) {}
+#endif
+/////////////////////////////////////////////////////////////////
 
-inline mat4::mat4(const float m00, const float m01, const float m02, const float m03, const float m10, const float m11,
-                  const float m12, const float m13, const float m20, const float m21, const float m22, const float m23,
-                  const float m30, const float m31, const float m32, const float m33)
-    : col0(m00, m01, m02, m03), col1(m10, m11, m12, m13), col2(m20, m21, m22, m23), col3(m30, m31, m32, m33)
+struct quat
 {
-}
+    float x, y, z, w;
+
+    // Identity rotation.
+    constexpr quat();
+    constexpr quat(const float x, const float y, const float z, const float w);
+
+    // Rotation of angle radians around axis, which does not need to be normalized.
+    static constexpr quat fromAxisAngle(const vec3 &axis, const float angle);
+
+    constexpr float dot(const quat &rhs) const;
+    constexpr quat normalize() const;
+    constexpr quat conjugate() const;
 
-inline float mat4::determinant() const
+    constexpr mat3 toMat3() const;
+
+    // Operators
+    constexpr quat operator*(const quat &rhs) const;
+    constexpr vec3 operator*(const vec3 &v) const;
+
+    constexpr quat operator*(const float rhs) const;
+    constexpr quat operator+(const quat &rhs) const;
+    constexpr quat operator-() const;
+
+    constexpr bool operator==(const quat &rhs) const;
+};
+
+// Translation, rotation and scale kept apart (40 bytes instead of a 64 byte mat4). The matrix is only built when
+// matrix() is called, and rotations compose as quaternions, so repeated updates don't drift from orthonormality.
+struct Transform
 {
-    const mat3 a{
-        (*this)[1][1], (*this)[1][2], (*this)[1][3],  // col 0
-        (*this)[2][1], (*this)[2][2], (*this)[2][3],  // col 1
-        (*this)[3][1], (*this)[3][2], (*this)[3][3],  // col 2
-    };
+    vec3 t;
+    quat r;
+    vec3 s;
 
-    const mat3 b{
-        (*this)[0][1], (*this)[0][2], (*this)[0][3],  // col 0
-        (*this)[2][1], (*this)[2][2], (*this)[2][3],  // col 1
-        (*this)[3][1], (*this)[3][2], (*this)[3][3],  // col 2
-    };
+    constexpr Transform();
+    constexpr Transform(const vec3 &t, const quat &r, const vec3 &s);
 
-    const mat3 c{
-        (*this)[0][1], (*this)[0][2], (*this)[0][3],  // col 0
-        (*this)[1][1], (*this)[1][2], (*this)[1][3],  // col 1
-        (*this)[3][1], (*this)[3][2], (*this)[3][3],  // col 2
-    };
+    // Rotates angle radians around axis in local space. Same as rotate(matrix(), angle, axis) for uniform scales.
+    constexpr void rotate(const float angle, const vec3 &axis);
 
-    const mat3 d{
-        (*this)[0][1], (*this)[0][2], (*this)[0][3],  // col 0
-        (*this)[1][1], (*this)[1][2], (*this)[1][3],  // col 1
-        (*this)[2][1], (*this)[2][2], (*this)[2][3],  // col 2
-    };
+    // T * R * S
+    constexpr mat4 matrix() const;
 
-    const auto aPivot = (*this)[0][0];
-    const auto bPivot = (*this)[1][0];
-    const auto cPivot = (*this)[2][0];
-    const auto dPivot = (*this)[3][0];
-
-    return aPivot * a.determinant() - bPivot * b.determinant() + cPivot * c.determinant() - dPivot * d.determinant();
-
-    return 0.0f;
-}
-
-/* inline mat4 mat4::transpose() const */
-/* { */
-/*     mat4 t; */
-
-/*     t[0][0] = (*this)[0][0]; */
-/*     t[1][0] = (*this)[0][1]; */
-/*     t[2][0] = (*this)[0][2]; */
-/*     t[3][0] = (*this)[0][3]; */
-
-/*     t[0][1] = (*this)[1][0]; */
-/*     t[1][1] = (*this)[1][1]; */
-/*     t[2][1] = (*this)[1][2]; */
-/*     t[3][1] = (*this)[1][3]; */
-
-/*     t[0][2] = (*this)[2][0]; */
-/*     t[1][2] = (*this)[2][1]; */
-/*     t[2][2] = (*this)[2][2]; */
-/*     t[3][2] = (*this)[2][3]; */
-
-/*     t[0][3] = (*this)[3][0]; */
-/*     t[1][3] = (*this)[3][1]; */
-/*     t[2][3] = (*this)[3][2]; */
-/*     t[3][3] = (*this)[3][3]; */
-
-/*     return t; */
-/* } */
-
-/* inline mat4 mat4::adjugate() const */
-/* { */
-/*     mat4 c; */
-
-/*     // Col0 */
-/*     c[0][0] = */
-/*         mat3{ */
-/*             (*this)[1][1], (*this)[1][2], (*this)[1][3],  // Col0 */
-/*             (*this)[2][1], (*this)[2][2], (*this)[2][3],  // Col1 */
-/*             (*this)[3][1], (*this)[3][2], (*this)[3][3],  // Col2 */
-/*         } */
-/*             .determinant(); */
-/*     c[0][1] = */
-/*         -mat3{ */
-/*             (*this)[1][0], (*this)[1][2], (*this)[1][3],  // Col0 */
-/*             (*this)[2][0], (*this)[2][2], (*this)[2][3],  // Col1 */
-/*             (*this)[3][0], (*this)[3][2], (*this)[3][3],  // Col2 */
-/*         } */
-/*              .determinant(); */
-/*     c[0][2] = */
-/*         mat3{ */
-/*             (*this)[1][0], (*this)[1][1], (*this)[1][3],  // Col0 */
-/*             (*this)[2][0], (*this)[2][1], (*this)[2][3],  // Col1 */
-/*             (*this)[3][0], (*this)[3][1], (*this)[3][3],  // Col2 */
-/*         } */
-/*             .determinant(); */
-/*     c[0][3] = */
-/*         mat3{ */
-/*             (*this)[1][0], (*this)[1][1], (*this)[1][2],  // Col0 */
-/*             (*this)[2][0], (*this)[2][1], (*this)[2][2],  // Col1 */
-/*             (*this)[3][0], (*this)[3][1], (*this)[3][2],  // Col2 */
-/*         } */
-/*             .determinant() * */
-/*         -1; */
-
-/*     // Col 1 */
-/*     c[1][0] = */
-/*         mat3{ */
-/*             (*this)[0][1], (*this)[0][2], (*this)[0][3],  // Col0 */
-/*             (*this)[2][1], (*this)[2][2], (*this)[2][3],  // Col1 */
-/*             (*this)[3][1], (*this)[3][2], (*this)[3][3],  // Col2 */
-/*         } */
-/*             .determinant() * */
-/*         -1; */
-/*     c[1][1] = */
-/*         mat3{ */
-/*             (*this)[0][0], (*this)[0][2], (*this)[0][3],  // Col0 */
-/*             (*this)[2][0], (*this)[2][2], (*this)[2][3],  // Col1 */
-/*             (*this)[3][0], (*this)[3][2], (*this)[3][3],  // Col2 */
-/*         } */
-/*             .determinant(); */
-/*     c[1][2] = */
-/*         mat3{ */
-/*             (*this)[0][0], (*this)[0][1], (*this)[0][3],  // Col0 */
-/*             (*this)[2][0], (*this)[2][1], (*this)[2][3],  // Col1 */
-/*             (*this)[3][0], (*this)[3][1], (*this)[3][3],  // Col2 */
-/*         } */
-/*             .determinant() * */
-/*         -1; */
-/*     c[1][3] = */
-/*         mat3{ */
-/*             (*this)[0][0], (*this)[0][1], (*this)[0][2],  // Col0 */
-/*             (*this)[2][0], (*this)[2][1], (*this)[2][2],  // Col1 */
-/*             (*this)[3][0], (*this)[3][1], (*this)[3][2],  // Col2 */
-/*         } */
-/*             .determinant(); */
-
-/*     // Col 2 */
-/*     c[2][0] = */
-/*         mat3{ */
-/*             (*this)[0][1], (*this)[0][2], (*this)[0][3],  // Col0 */
-/*             (*this)[1][1], (*this)[1][2], (*this)[1][3],  // Col1 */
-/*             (*this)[3][1], (*this)[3][2], (*this)[3][3],  // Col2 */
-/*         } */
-/*             .determinant(); */
-/*     c[2][1] = */
-/*         mat3{ */
-/*             (*this)[0][0], (*this)[0][2], (*this)[0][3],  // Col0 */
-/*             (*this)[1][0], (*this)[1][2], (*this)[1][3],  // Col1 */
-/*             (*this)[3][0], (*this)[3][2], (*this)[3][3],  // Col2 */
-/*         } */
-/*             .determinant() * */
-/*         -1; */
-/*     c[2][2] = */
-/*         mat3{ */
-/*             (*this)[0][0], (*this)[0][1], (*this)[0][3],  // Col0 */
-/*             (*this)[1][0], (*this)[1][1], (*this)[1][3],  // Col1 */
-/*             (*this)[3][0], (*this)[3][1], (*this)[3][3],  // Col2 */
-/*         } */
-/*             .determinant(); */
-/*     c[2][3] = */
-/*         mat3{ */
-/*             (*this)[0][0], (*this)[0][1], (*this)[0][2],  // Col0 */
-/*             (*this)[1][0], (*this)[1][1], (*this)[1][2],  // Col1 */
-/*             (*this)[3][0], (*this)[3][1], (*this)[3][2],  // Col2 */
-/*         } */
-/*             .determinant() * */
-/*         -1; */
-
-/*     // Col 3 */
-/*     c[3][0] = */
-/*         mat3{ */
-/*             (*this)[0][1], (*this)[0][2], (*this)[0][3],  // Col0 */
-/*             (*this)[1][1], (*this)[1][2], (*this)[1][3],  // Col1 */
-/*             (*this)[2][1], (*this)[2][2], (*this)[2][3],  // Col2 */
-/*         } */
-/*             .determinant() * */
-/*         -1; */
-/*     c[3][1] = */
-/*         mat3{ */
-/*             (*this)[0][0], (*this)[0][2], (*this)[0][3],  // Col0 */
-/*             (*this)[1][0], (*this)[1][2], (*this)[1][3],  // Col1 */
-/*             (*this)[2][0], (*this)[2][2], (*this)[2][3],  // Col2 */
-/*         } */
-/*             .determinant(); */
-/*     c[3][2] = */
-/*         mat3{ */
-/*             (*this)[0][0], (*this)[0][1], (*this)[0][3],  // Col0 */
-/*             (*this)[1][0], (*this)[1][1], (*this)[1][3],  // Col1 */
-/*             (*this)[2][0], (*this)[2][1], (*this)[2][3],  // Col2 */
-/*         } */
-/*             .determinant() * */
-/*         -1; */
-/*     c[3][3] = */
-/*         mat3{ */
-/*             (*this)[0][0], (*this)[0][1], (*this)[0][2],  // Col0 */
-/*             (*this)[1][0], (*this)[1][1], (*this)[1][2],  // Col1 */
-/*             (*this)[2][0], (*this)[2][1], (*this)[2][2],  // Col2 */
-/*         } */
-/*             .determinant(); */
-
-/*     return c; */
-/* } */
-
-/* inline mat4 mat4::inverse() const { return adjugate() / determinant(); } */
-
-inline vec4 &mat4::operator[](const int i) { return (&col0)[i]; }
-inline const vec4 &mat4::operator[](const int i) const { return (&col0)[i]; }
-
-inline bool mat4::operator==(const mat4 &rhs) const
-{
-    return (*this)[0] == rhs[0] && (*this)[1] == rhs[1] && (*this)[2] == rhs[2] && (*this)[3] == rhs[3];
-}
-
-inline mat4 mat4::operator*(const mat4 &rhs)
-{
-    mat4 m{};
-
-    const vec4 lhsRow0{(*this)[0][0], (*this)[1][0], (*this)[2][0], (*this)[3][0]};
-    const vec4 lhsRow1{(*this)[0][1], (*this)[1][1], (*this)[2][1], (*this)[3][1]};
-    const vec4 lhsRow2{(*this)[0][2], (*this)[1][2], (*this)[2][2], (*this)[3][2]};
-    const vec4 lhsRow4{(*this)[0][3], (*this)[1][3], (*this)[2][3], (*this)[3][3]};
-
-    m[0][0] = lhsRow0.dot(rhs[0]);
-    m[1][0] = lhsRow0.dot(rhs[1]);
-    m[2][0] = lhsRow0.dot(rhs[2]);
-    m[3][0] = lhsRow0.dot(rhs[3]);
-
-    m[0][1] = lhsRow1.dot(rhs[0]);
-    m[1][1] = lhsRow1.dot(rhs[1]);
-    m[2][1] = lhsRow1.dot(rhs[2]);
-    m[3][1] = lhsRow1.dot(rhs[3]);
-
-    m[0][2] = lhsRow2.dot(rhs[0]);
-    m[1][2] = lhsRow2.dot(rhs[1]);
-    m[2][2] = lhsRow2.dot(rhs[2]);
-    m[3][2] = lhsRow2.dot(rhs[3]);
-
-    m[0][3] = lhsRow4.dot(rhs[0]);
-    m[1][3] = lhsRow4.dot(rhs[1]);
-    m[2][3] = lhsRow4.dot(rhs[2]);
-    m[3][3] = lhsRow4.dot(rhs[3]);
+    // Parent * child. Exact for uniform scales; non-uniform parent scale can't be represented without shear.
+    constexpr Transform operator*(const Transform &rhs) const;
+};
 
-    return m;
-}
+struct Plane
+{
+    // Points with normal.dot(p) + d >= 0 are on the positive side.
+    vec3 normal;
+    float d;
 
-inline mat4 mat4::operator/(const float rhs) const
+    constexpr float distance(const vec3 &p) const;
+};
+
+struct AABB
 {
-    mat4 m;
-    m[0] = (*this)[0] / rhs;
-    m[1] = (*this)[1] / rhs;
-    m[2] = (*this)[2] / rhs;
-    m[3] = (*this)[3] / rhs;
-    return m;
-}
+    vec3 min;
+    vec3 max;
 
-// Write matrix in row major on the ostream.
-inline std::ostream &operator<<(std::ostream &os, const mat4 &m4)
+    constexpr vec3 center() const;
+    constexpr vec3 extents() const;
+
+    // Bounds of the transformed box (Arvo's method, no corner enumeration).
+    constexpr AABB transform(const mat4 &m) const;
+};
+
+struct Sphere
 {
-    os << "[" << m4[0][0] << " " << m4[1][0] << " " << m4[2][0] << " " << m4[3][0] << "]\n";
-    os << "[" << m4[0][1] << " " << m4[1][1] << " " << m4[2][1] << " " << m4[3][1] << "]\n";
-    os << "[" << m4[0][2] << " " << m4[1][2] << " " << m4[2][2] << " " << m4[3][2] << "]\n";
-    os << "[" << m4[0][3] << " " << m4[1][3] << " " << m4[2][3] << " " << m4[3][3] << "]\n";
-    return os;
-}
-////////////////////////////////////////////////////////////////
+    vec3 center;
+    float radius;
+};
 
-inline mat4 translate(const mat4 &m, const vec3 &v)
+struct Frustum
+{
+    // Left, right, bottom, top, near, far. Normals point inside.
+    Plane planes[6];
+
+    // Gribb-Hartmann extraction from a clip matrix, usually projection * view. Planes are normalized.
+    static constexpr Frustum fromMatrix(const mat4 &m);
+
+    // Conservative: boxes and spheres crossing a frustum corner outside all planes are reported visible.
+    constexpr bool intersects(const AABB &box) const;
+    constexpr bool intersects(const Sphere &sphere) const;
+};
+
+constexpr mat4 translate(const mat4 &m, const vec3 &v)
 {
     mat4 t{m};
     t[3][0] = v.x;
@@ -893,10 +1242,10 @@ inline mat4 translate(const mat4 &m, const vec3 &v)
     return t;
 }
 
-inline mat4 rotate(const mat4 &m, const float &a, const vec3 &v)
+constexpr mat4 rotate(const mat4 &m, const float &a, const vec3 &v)
 {
-    const auto c = cos(a);
-    const auto s = sin(a);
+    float s = 0, c = 0;
+    sincos(a, s, c);
 
     const auto r = v.normalize();
     const auto x = r.x;
@@ -905,17 +1254,17 @@ inline mat4 rotate(const mat4 &m, const float &a, const vec3 &v)
 
     mat4 rot;
 
-    rot[0][0] = (1 - c) * pow(x, 2) + c;
+    rot[0][0] = (1 - c) * x * x + c;
     rot[0][1] = (1 - c) * x * y + s * z;
     rot[0][2] = (1 - c) * x * z - s * y;
 
     rot[1][0] = (1 - c) * x * y - s * z;
-    rot[1][1] = (1 - c) * pow(y, 2) + c;
+    rot[1][1] = (1 - c) * y * y + c;
     rot[1][2] = (1 - c) * y * z + s * x;
 
     rot[2][0] = (1 - c) * x * z + s * y;
     rot[2][1] = (1 - c) * y * z - s * x;
-    rot[2][2] = (1 - c) * pow(z, 2) + c;
+    rot[2][2] = (1 - c) * z * z + c;
 
     mat4 res;
     res[0] = rot[0][0] * m[0] + rot[0][1] * m[1] + rot[0][2] * m[2];
@@ -926,11 +1275,11 @@ inline mat4 rotate(const mat4 &m, const float &a, const vec3 &v)
     return res;
 }
 
-inline mat4 perspective(const float &fov, const float &aspectRatio, const float &zNear, const float &zFar)
+constexpr mat4 perspective(const float &fov, const float &aspectRatio, const float &zNear, const float &zFar)
 {
     mat4 p{0};
 
-    const auto tanHalfFov = tan(fov / 2);
+    const auto tanHalfFov = constexprTan(fov / 2);
 
     p[0][0] = 1 / (aspectRatio * tanHalfFov);
     p[1][1] = 1 / tanHalfFov;
@@ -941,7 +1290,7 @@ inline mat4 perspective(const float &fov, const float &aspectRatio, const float
     return p;
 }
 
-inline mat4 lookAt(const vec3 &eye, const vec3 &target, const vec3 &worldUp)
+constexpr mat4 lookAt(const vec3 &eye, const vec3 &target, const vec3 &worldUp)
 {
     const auto forward = (eye - target).normalize();
     const auto left = worldUp.cross(forward).normalize();
@@ -968,7 +1317,7 @@ inline mat4 lookAt(const vec3 &eye, const vec3 &target, const vec3 &worldUp)
     return lookAtm;
 }
 
-inline mat4 scale(const mat4 &m, const vec3 &v)
+constexpr mat4 scale(const mat4 &m, const vec3 &v)
 {
     mat4 s{};
     s[0] = v.x * m[0];
@@ -977,3 +1326,234 @@ inline mat4 scale(const mat4 &m, const vec3 &v)
     s[3] = m[3];
     return s;
 }
+
+// Inverse transpose of the upper 3x3 block, for transforming normals. Rotations with a uniform scale skip the
+// inverse and rescale the block; anything else uses the cofactor matrix (column cross products) over the determinant.
+constexpr mat3 normalMatrix(const mat4 &m)
+{
+    const vec3 c0{m[0].x, m[0].y, m[0].z};
+    const vec3 c1{m[1].x, m[1].y, m[1].z};
+    const vec3 c2{m[2].x, m[2].y, m[2].z};
+
+    const auto l0 = c0.dot(c0);
+    const auto l1 = c1.dot(c1);
+    const auto l2 = c2.dot(c2);
+
+    const auto eps = 1e-5f * l0;
+    const auto approx = [eps](const float a, const float b) { return a - b < eps && b - a < eps; };
+
+    // Orthogonal columns of equal length: M = sR and (M^-1)^T = R / s = M / s^2.
+    if (approx(l0, l1) && approx(l0, l2) && approx(c0.dot(c1), 0) && approx(c0.dot(c2), 0) && approx(c1.dot(c2), 0))
+    {
+        return mat3{c0, c1, c2} * (1.0f / l0);
+    }
+
+    const auto x0 = c1.cross(c2);
+    const auto x1 = c2.cross(c0);
+    const auto x2 = c0.cross(c1);
+    const auto invDet = 1.0f / c0.dot(x0);
+
+    return mat3{x0 * invDet, x1 * invDet, x2 * invDet};
+}
+
+/////////////////////////// quat ////////////////////////////////
+constexpr quat::quat() : x(0), y(0), z(0), w(1) {}
+
+constexpr quat::quat(const float x, const float y, const float z, const float w) : x(x), y(y), z(z), w(w) {}
+
+constexpr quat quat::fromAxisAngle(const vec3 &axis, const float angle)
+{
+    float s = 0, c = 0;
+    sincos(angle * 0.5f, s, c);
+
+    const auto a = axis.normalize() * s;
+    return quat{a.x, a.y, a.z, c};
+}
+
+constexpr float quat::dot(const quat &rhs) const { return x * rhs.x + y * rhs.y + z * rhs.z + w * rhs.w; }
+
+constexpr quat quat::normalize() const { return *this * (1.0f / constexprSqrt(dot(*this))); }
+
+constexpr quat quat::conjugate() const { return quat{-x, -y, -z, w}; }
+
+constexpr mat3 quat::toMat3() const
+{
+    const auto xx = x * x, yy = y * y, zz = z * z;
+    const auto xy = x * y, xz = x * z, yz = y * z;
+    const auto wx = w * x, wy = w * y, wz = w * z;
+
+    return mat3{
+        1 - 2 * (yy + zz), 2 * (xy + wz),     2 * (xz - wy),      // Col 0
+        2 * (xy - wz),     1 - 2 * (xx + zz), 2 * (yz + wx),      // Col 1
+        2 * (xz + wy),     2 * (yz - wx),     1 - 2 * (xx + yy),  // Col 2
+    };
+}
+
+constexpr quat quat::operator*(const quat &rhs) const
+{
+    return quat{
+        w * rhs.x + x * rhs.w + y * rhs.z - z * rhs.y,
+        w * rhs.y - x * rhs.z + y * rhs.w + z * rhs.x,
+        w * rhs.z + x * rhs.y - y * rhs.x + z * rhs.w,
+        w * rhs.w - x * rhs.x - y * rhs.y - z * rhs.z,
+    };
+}
+
+constexpr vec3 quat::operator*(const vec3 &v) const
+{
+    const vec3 q{x, y, z};
+    const auto t = 2.0f * q.cross(v);
+    return v + w * t + q.cross(t);
+}
+
+constexpr quat quat::operator*(const float rhs) const { return quat{x * rhs, y * rhs, z * rhs, w * rhs}; }
+
+constexpr quat quat::operator+(const quat &rhs) const { return quat{x + rhs.x, y + rhs.y, z + rhs.z, w + rhs.w}; }
+
+constexpr quat quat::operator-() const { return quat{-x, -y, -z, -w}; }
+
+constexpr bool quat::operator==(const quat &rhs) const { return x == rhs.x && y == rhs.y && z == rhs.z && w == rhs.w; }
+
+// Normalized linear interpolation along the shortest arc. Cheaper than slerp, but not constant speed.
+constexpr quat nlerp(const quat &a, const quat &b, const float t)
+{
+    const auto end = a.dot(b) < 0 ? -b : b;
+    return (a * (1 - t) + end * t).normalize();
+}
+
+// Spherical linear interpolation along the shortest arc.
+inline quat slerp(const quat &a, const quat &b, const float t)
+{
+    auto cosTheta = a.dot(b);
+    auto end = b;
+
+    if (cosTheta < 0)
+    {
+        cosTheta = -cosTheta;
+        end = -b;
+    }
+
+    // Nearly parallel, sin(theta) would divide by ~0.
+    if (cosTheta > 0.9995f)
+    {
+        return nlerp(a, end, t);
+    }
+
+    const auto theta = std::acos(cosTheta);
+    const auto sinTheta = std::sin(theta);
+
+    return a * (std::sin((1 - t) * theta) / sinTheta) + end * (std::sin(t * theta) / sinTheta);
+}
+/////////////////////////////////////////////////////////////////
+
+/////////////////////////// Transform ///////////////////////////
+constexpr Transform::Transform() : t(0.0f), r(), s(1.0f) {}
+
+constexpr Transform::Transform(const vec3 &t, const quat &r, const vec3 &s) : t(t), r(r), s(s) {}
+
+constexpr void Transform::rotate(const float angle, const vec3 &axis)
+{
+    r = (r * quat::fromAxisAngle(axis, angle)).normalize();
+}
+
+constexpr mat4 Transform::matrix() const
+{
+    const auto rot = r.toMat3();
+
+    return mat4{
+        rot[0].x * s.x, rot[0].y * s.x, rot[0].z * s.x, 0.0f,  // Col 0
+        rot[1].x * s.y, rot[1].y * s.y, rot[1].z * s.y, 0.0f,  // Col 1
+        rot[2].x * s.z, rot[2].y * s.z, rot[2].z * s.z, 0.0f,  // Col 2
+        t.x,            t.y,            t.z,            1.0f,  // Col 3
+    };
+}
+
+constexpr Transform Transform::operator*(const Transform &rhs) const
+{
+    return Transform{t + r * (s * rhs.t), r * rhs.r, s * rhs.s};
+}
+/////////////////////////////////////////////////////////////////
+
+/////////////////////////// Culling /////////////////////////////
+constexpr float Plane::distance(const vec3 &p) const { return normal.dot(p) + d; }
+
+constexpr vec3 AABB::center() const { return (min + max) * 0.5f; }
+
+constexpr vec3 AABB::extents() const { return (max - min) * 0.5f; }
+
+constexpr AABB AABB::transform(const mat4 &m) const
+{
+    const auto c = center();
+    const auto e = extents();
+
+    vec3 tc{m[3][0], m[3][1], m[3][2]};
+    vec3 te{};
+
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            const auto v = m[j][i];
+            tc[i] += v * c[j];
+            te[i] += (v < 0 ? -v : v) * e[j];
+        }
+    }
+
+    return AABB{tc - te, tc + te};
+}
+
+constexpr Frustum Frustum::fromMatrix(const mat4 &m)
+{
+    const vec4 r0{m[0][0], m[1][0], m[2][0], m[3][0]};
+    const vec4 r1{m[0][1], m[1][1], m[2][1], m[3][1]};
+    const vec4 r2{m[0][2], m[1][2], m[2][2], m[3][2]};
+    const vec4 r3{m[0][3], m[1][3], m[2][3], m[3][3]};
+
+    const vec4 p[6] = {
+        r3 + r0,  // Left
+        r3 - r0,  // Right
+        r3 + r1,  // Bottom
+        r3 - r1,  // Top
+        r3 + r2,  // Near
+        r3 - r2,  // Far
+    };
+
+    Frustum f{};
+    for (int i = 0; i < 6; i++)
+    {
+        const vec3 n{p[i].x, p[i].y, p[i].z};
+        const auto invLen = 1.0f / n.magnitude();
+        f.planes[i] = Plane{n * invLen, p[i].w * invLen};
+    }
+    return f;
+}
+
+constexpr bool Frustum::intersects(const AABB &box) const
+{
+    const auto c = box.center();
+    const auto e = box.extents();
+
+    for (const auto &plane : planes)
+    {
+        const auto &n = plane.normal;
+        const auto r = (n.x < 0 ? -n.x : n.x) * e.x + (n.y < 0 ? -n.y : n.y) * e.y + (n.z < 0 ? -n.z : n.z) * e.z;
+        if (plane.distance(c) < -r)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+constexpr bool Frustum::intersects(const Sphere &sphere) const
+{
+    for (const auto &plane : planes)
+    {
+        if (plane.distance(sphere.center) < -sphere.radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+/////////////////////////////////////////////////////////////////
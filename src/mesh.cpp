@@ -0,0 +1,87 @@
+#include "mesh.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+constexpr unsigned int EMPTY = ~0u;
+
+static uint32_t floatBits(const float f)
+{
+    // + 0.0f folds -0 into +0, so values that compare equal also hash equal.
+    const float v = f + 0.0f;
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+static size_t hashVertex(const Vertex& v)
+{
+    const uint32_t bits[] = {floatBits(v.Position.x), floatBits(v.Position.y), floatBits(v.Position.z),
+                             floatBits(v.Normal.x),   floatBits(v.Normal.y),   floatBits(v.Normal.z)};
+
+    // FNV-1a over the words, followed by a final avalanche so the low bits used by the table are well mixed.
+    uint64_t h = 14695981039346656037ull;
+    for (const auto b : bits)
+    {
+        h = (h ^ b) * 1099511628211ull;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return static_cast<size_t>(h);
+}
+
+Mesh weldVertices(const Vertex* vertices, const size_t n)
+{
+    Mesh mesh;
+    mesh.Indices.reserve(n);
+
+    // Open addressing with linear probing. The table holds indices into mesh.Vertices and is kept at most half full.
+    size_t capacity = 16;
+    while (capacity < n * 2)
+    {
+        capacity *= 2;
+    }
+    const size_t mask = capacity - 1;
+    std::vector<unsigned int> table(capacity, EMPTY);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        const auto& v = vertices[i];
+
+        size_t slot = hashVertex(v) & mask;
+        while (table[slot] != EMPTY)
+        {
+            const auto& other = mesh.Vertices[table[slot]];
+            if (other.Position == v.Position && other.Normal == v.Normal)
+            {
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+
+        if (table[slot] == EMPTY)
+        {
+            table[slot] = static_cast<unsigned int>(mesh.Vertices.size());
+            mesh.Vertices.push_back(v);
+        }
+        mesh.Indices.push_back(table[slot]);
+    }
+
+    return mesh;
+}
+
+AABB computeBounds(const Vertex* vertices, const size_t n)
+{
+    AABB bounds{vertices[0].Position, vertices[0].Position};
+    for (size_t i = 1; i < n; i++)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            bounds.min[axis] = std::min(bounds.min[axis], vertices[i].Position[axis]);
+            bounds.max[axis] = std::max(bounds.max[axis], vertices[i].Position[axis]);
+        }
+    }
+    return bounds;
+}
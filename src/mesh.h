@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "math.h"
+
+struct Vertex
+{
+    vec3 Position;
+    vec3 Normal;
+};
+
+// Indexed triangle list.
+struct Mesh
+{
+    std::vector<Vertex> Vertices;
+    std::vector<unsigned int> Indices;
+};
+
+// Builds an indexed mesh from a triangle soup, merging vertices whose position and normal are exactly equal.
+// Vertices keep the order of their first occurrence.
+Mesh weldVertices(const Vertex* vertices, const size_t n);
+
+// Object space bounds of the vertices, n must be at least 1.
+AABB computeBounds(const Vertex* vertices, const size_t n);
@@ -0,0 +1,249 @@
+#include "mesh_file.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <thread>
+#include <utility>
+
+#include "simplifier.h"
+
+namespace fs = std::filesystem;
+
+static const char MAGIC[8] = {'G', 'S', 'M', 'E', 'S', 'H', '\0', '\0'};
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+static uint64_t alignUp(const uint64_t offset)
+{
+    return (offset + MESH_FILE_ALIGNMENT - 1) / MESH_FILE_ALIGNMENT * MESH_FILE_ALIGNMENT;
+}
+
+/////////////////////////// Mesh file ///////////////////////////
+bool writeMeshFile(const std::string& path, const LodLevel* levels, const int levelCount, const Vertex* vertices,
+                   const unsigned int* indices, const uint64_t key)
+{
+    if (levelCount < 1 || levelCount > MAX_LOD_LEVELS)
+    {
+        return false;
+    }
+
+    MeshFileHeader header{};
+    std::memcpy(header.Magic, MAGIC, sizeof(MAGIC));
+    header.Version = MESH_FILE_VERSION;
+    header.ByteOrder = BYTE_ORDER_MARK;
+    header.VertexSize = sizeof(Vertex);
+    header.LevelCount = static_cast<uint32_t>(levelCount);
+    header.Key = key;
+
+    for (int l = 0; l < levelCount; l++)
+    {
+        const auto& level = levels[l];
+        header.Levels[l] = MeshFileLevel{level.FirstVertex, level.VertexCount, level.FirstIndex, level.IndexCount};
+        header.VertexCount = std::max<uint64_t>(header.VertexCount, level.FirstVertex + level.VertexCount);
+        header.IndexCount = std::max<uint64_t>(header.IndexCount, level.FirstIndex + level.IndexCount);
+    }
+    if (levels[0].VertexCount == 0)
+    {
+        return false;
+    }
+
+    const auto bounds = computeBounds(vertices + levels[0].FirstVertex, levels[0].VertexCount);
+    for (int axis = 0; axis < 3; axis++)
+    {
+        header.Bounds[axis] = bounds.min[axis];
+        header.Bounds[axis + 3] = bounds.max[axis];
+    }
+
+    header.VertexOffset = alignUp(sizeof(MeshFileHeader));
+    header.IndexOffset = alignUp(header.VertexOffset + header.VertexCount * sizeof(Vertex));
+
+    // Unique per thread, so concurrent writers of the same key don't interleave; the last rename wins.
+    const auto temporary =
+        path + ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    std::FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    uint64_t position = 0;
+    const auto write = [file, &position](const void* data, const uint64_t size) {
+        position += size;
+        return std::fwrite(data, 1, size, file) == size;
+    };
+    const auto pad = [&write, &position](const uint64_t offset) {
+        static const char zeros[MESH_FILE_ALIGNMENT] = {};
+        return write(zeros, offset - position);
+    };
+
+    bool ok = write(&header, sizeof(header));
+    ok = ok && pad(header.VertexOffset) && write(vertices, header.VertexCount * sizeof(Vertex));
+    ok = ok && pad(header.IndexOffset) && write(indices, header.IndexCount * sizeof(unsigned int));
+    ok = std::fclose(file) == 0 && ok;
+
+    std::error_code error;
+    if (ok)
+    {
+        fs::rename(temporary, path, error);
+    }
+    if (!ok || error)
+    {
+        fs::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+bool writeMeshFile(const std::string& path, const LodChain& lods, const uint64_t key)
+{
+    LodLevel levels[MAX_LOD_LEVELS];
+    for (int l = 0; l < lods.GetLevelCount(); l++)
+    {
+        levels[l] = lods.GetLevel(l);
+    }
+    return writeMeshFile(path, levels, lods.GetLevelCount(), lods.GetVertices(0) - levels[0].FirstVertex,
+                         lods.GetIndices(0) - levels[0].FirstIndex, key);
+}
+
+bool writeMeshFile(const std::string& path, const Mesh& mesh, const uint64_t key)
+{
+    const LodLevel level{0, mesh.Vertices.size(), 0, mesh.Indices.size()};
+    return writeMeshFile(path, &level, 1, mesh.Vertices.data(), mesh.Indices.data(), key);
+}
+
+MeshFile::MeshFile(const std::string& path) : file(path)
+{
+    const auto size = file.GetSize();
+    if (size < sizeof(MeshFileHeader))
+    {
+        return;
+    }
+
+    // mmap returns page aligned memory, so the header can be read in place.
+    const auto* h = reinterpret_cast<const MeshFileHeader*>(file.GetData());
+    const bool valid = std::memcmp(h->Magic, MAGIC, sizeof(MAGIC)) == 0 && h->Version == MESH_FILE_VERSION &&
+                       h->ByteOrder == BYTE_ORDER_MARK && h->VertexSize == sizeof(Vertex) && h->LevelCount >= 1 &&
+                       h->LevelCount <= MAX_LOD_LEVELS && h->VertexOffset % MESH_FILE_ALIGNMENT == 0 &&
+                       h->IndexOffset % MESH_FILE_ALIGNMENT == 0 && h->VertexOffset <= size &&
+                       h->IndexOffset <= size && h->VertexCount <= (size - h->VertexOffset) / sizeof(Vertex) &&
+                       h->IndexCount <= (size - h->IndexOffset) / sizeof(unsigned int);
+    if (!valid)
+    {
+        return;
+    }
+
+    for (uint32_t l = 0; l < h->LevelCount; l++)
+    {
+        const auto& level = h->Levels[l];
+        if (level.FirstVertex > h->VertexCount || level.VertexCount > h->VertexCount - level.FirstVertex ||
+            level.FirstIndex > h->IndexCount || level.IndexCount > h->IndexCount - level.FirstIndex)
+        {
+            return;
+        }
+    }
+
+    header = h;
+}
+
+MeshFile::MeshFile(MeshFile&& other) noexcept
+    : file(std::move(other.file)), header(std::exchange(other.header, nullptr))
+{
+}
+
+MeshFile& MeshFile::operator=(MeshFile&& other) noexcept
+{
+    file = std::move(other.file);
+    header = std::exchange(other.header, nullptr);
+    return *this;
+}
+
+AABB MeshFile::GetBounds() const
+{
+    const auto* b = header->Bounds;
+    return AABB{vec3{b[0], b[1], b[2]}, vec3{b[3], b[4], b[5]}};
+}
+
+LodLevel MeshFile::GetLevel(const int level) const
+{
+    const auto& l = header->Levels[level];
+    return LodLevel{l.FirstVertex, l.VertexCount, l.FirstIndex, l.IndexCount};
+}
+
+const Vertex* MeshFile::GetVertices(const int level) const
+{
+    return reinterpret_cast<const Vertex*>(file.GetData() + header->VertexOffset) + header->Levels[level].FirstVertex;
+}
+
+const unsigned int* MeshFile::GetIndices(const int level) const
+{
+    return reinterpret_cast<const unsigned int*>(file.GetData() + header->IndexOffset) +
+           header->Levels[level].FirstIndex;
+}
+////////////////////////////////////////////////////////////////
+
+/////////////////////////// Mesh cache //////////////////////////
+// FNV-1a, the keys only need to tell sources apart, not resist anyone.
+static uint64_t hashBytes(const void* data, const size_t size, uint64_t h = 14695981039346656037ull)
+{
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        h = (h ^ bytes[i]) * 1099511628211ull;
+    }
+    return h;
+}
+
+template <typename T>
+static uint64_t hashValue(const T& value, const uint64_t h)
+{
+    return hashBytes(&value, sizeof(value), h);
+}
+
+MeshCache::MeshCache(const std::string& directory) : directory(directory)
+{
+    std::error_code error;
+    fs::create_directories(directory, error);
+}
+
+std::string MeshCache::GetPath(const uint64_t key) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.mesh", static_cast<unsigned long long>(key));
+    return (fs::path{directory} / name).string();
+}
+
+uint64_t meshKey(const ParametricShape& shape, const int levels)
+{
+    // Field by field, the struct has padding.
+    auto h = hashValue(MESH_FILE_VERSION, hashValue(GENERATOR_VERSION, hashValue(levels, hashBytes("lod", 3))));
+    h = hashValue(shape.Type, h);
+    h = hashValue(shape.Radius, h);
+    h = hashValue(shape.Height, h);
+    h = hashValue(shape.TubeRadius, h);
+    for (int axis = 0; axis < 3; axis++)
+    {
+        h = hashValue(shape.Dimensions[axis], h);
+    }
+    return h;
+}
+
+uint64_t fileKey(const std::string& path, const int levels)
+{
+    std::error_code error;
+    const auto absolute = fs::absolute(path, error).string();
+    const auto size = fs::file_size(path, error);
+    if (error)
+    {
+        return 0;
+    }
+    const auto modified = fs::last_write_time(path, error).time_since_epoch().count();
+
+    auto h = hashValue(MESH_FILE_VERSION, hashValue(SIMPLIFIER_VERSION, hashValue(levels, hashBytes("file", 4))));
+    h = hashValue(IMPORT_VERSION, h);
+    h = hashBytes(absolute.data(), absolute.size(), h);
+    h = hashValue(static_cast<uint64_t>(size), h);
+    return hashValue(static_cast<int64_t>(modified), h);
+}
+////////////////////////////////////////////////////////////////
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "generators.h"
+#include "mapped_file.h"
+#include "math.h"
+#include "mesh.h"
+
+/////////////////////////// Mesh file ///////////////////////////
+// Binary container for the detail levels of one mesh, loaded by mapping it without any parsing:
+//
+//   MeshFileHeader | padding | vertices of all levels | padding | indices of all levels
+//
+// Both blobs start on a page boundary, so a mapped blob can be handed to glBufferData() (or a GeometryBuffer through
+// AddExternal()) in place. Values are stored in the host's byte order, files from a host with the other order are
+// rejected like any other version mismatch.
+
+// Bump whenever the layout of the header, Vertex or the index type changes.
+constexpr uint32_t MESH_FILE_VERSION = 1;
+constexpr size_t MESH_FILE_ALIGNMENT = 4096;
+
+struct MeshFileLevel
+{
+    uint64_t FirstVertex;
+    uint64_t VertexCount;
+    uint64_t FirstIndex;
+    uint64_t IndexCount;
+};
+
+struct MeshFileHeader
+{
+    char Magic[8];
+    uint32_t Version;
+    uint32_t ByteOrder;  // 0x01020304 as written by the host
+    uint32_t VertexSize;
+    uint32_t LevelCount;
+    uint64_t Key;  // cache key of the source, 0 when written outside a cache
+    float Bounds[6];  // min and max of the finest level
+    uint64_t VertexOffset;
+    uint64_t VertexCount;
+    uint64_t IndexOffset;
+    uint64_t IndexCount;
+    MeshFileLevel Levels[MAX_LOD_LEVELS];
+};
+
+// Writes the levels, finest first, whose vertices and indices are stored back to back like in a LodChain. The file
+// is written under a temporary name and renamed, so readers never see a partial file. Returns false on I/O errors.
+bool writeMeshFile(const std::string& path, const LodLevel* levels, const int levelCount, const Vertex* vertices,
+                   const unsigned int* indices, const uint64_t key = 0);
+bool writeMeshFile(const std::string& path, const LodChain& lods, const uint64_t key = 0);
+bool writeMeshFile(const std::string& path, const Mesh& mesh, const uint64_t key = 0);
+
+// Read-only view of a mapped mesh file, with the same accessors as LodChain.
+class MeshFile
+{
+   public:
+    MeshFile() = default;
+    // IsOpen() is false when the file is missing, truncated or has another version.
+    explicit MeshFile(const std::string& path);
+
+    // Moving keeps the mapping, so pointers handed out earlier stay valid.
+    MeshFile(MeshFile&& other) noexcept;
+    MeshFile& operator=(MeshFile&& other) noexcept;
+
+    bool IsOpen() const { return header != nullptr; }
+    uint64_t GetKey() const { return header->Key; }
+    AABB GetBounds() const;
+    size_t GetSize() const { return file.GetSize(); }
+
+    int GetLevelCount() const { return static_cast<int>(header->LevelCount); }
+    LodLevel GetLevel(const int level) const;
+
+    const Vertex* GetVertices(const int level) const;
+    const unsigned int* GetIndices(const int level) const;
+
+   private:
+    MappedFile file;
+    const MeshFileHeader* header = nullptr;
+};
+////////////////////////////////////////////////////////////////
+
+/////////////////////////// Mesh cache //////////////////////////
+// Directory of mesh files named after a 64-bit key of their source. A miss converts the source once; every later
+// load only maps the file.
+class MeshCache
+{
+   public:
+    // Creates the directory when it doesn't exist yet.
+    explicit MeshCache(const std::string& directory);
+
+    // Opens the file for key. On a miss build(path) is called to write it, e.g. with writeMeshFile(), and should
+    // return false when it can't; the returned file is closed then. Safe to call from several threads with
+    // different keys.
+    template <typename Fn>
+    MeshFile Load(const uint64_t key, Fn&& build) const;
+
+    std::string GetPath(const uint64_t key) const;
+
+   private:
+    std::string directory;
+};
+
+// Key of a generated LOD chain: the shape's parameters, the level count and the file and generator versions.
+uint64_t meshKey(const ParametricShape& shape, const int levels);
+
+// Bump whenever the processing of an imported file before it is cached changes (importMesh(), the fit to the unit
+// cube), it is part of fileKey().
+constexpr uint32_t IMPORT_VERSION = 3;
+
+// Key of an imported file: its absolute path, size and modification time, the level count and the file, import and
+// simplifier versions. Hashing the contents of a large source on every start would cost more than loading its cached
+// conversion. 0 when the file doesn't exist.
+uint64_t fileKey(const std::string& path, const int levels);
+
+template <typename Fn>
+MeshFile MeshCache::Load(const uint64_t key, Fn&& build) const
+{
+    const auto path = GetPath(key);
+
+    MeshFile file{path};
+    if (file.IsOpen() && file.GetKey() == key)
+    {
+        return file;
+    }
+
+    // Stale or foreign file: unmap it first, the new one replaces it under the same name.
+    file = MeshFile{};
+    if (!build(path))
+    {
+        return MeshFile{};
+    }
+    return MeshFile{path};
+}
+////////////////////////////////////////////////////////////////
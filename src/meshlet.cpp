@@ -0,0 +1,157 @@
+#include "meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// A meshlet ends before a triangle whose normal is further than this from the mean normal so far, cos(75 degrees).
+constexpr float MESHLET_SPLIT_COSINE = 0.26f;
+
+// Cones whose triangles spread almost to a half space can't cull anything.
+constexpr float MESHLET_MIN_CONE_DOT = 0.1f;
+
+static vec3 triangleNormal(const Vertex* vertices, const unsigned int* corners)
+{
+    const auto& a = vertices[corners[0]].Position;
+    const auto& b = vertices[corners[1]].Position;
+    const auto& c = vertices[corners[2]].Position;
+    const auto n = (b - a).cross(c - a);
+    const float length = n.magnitude();
+    return length > 0.0f ? n / length : vec3{0.0f};
+}
+
+// normals holds the unit normal of every triangle of the mesh.
+static Meshlet finishMeshlet(const Vertex* vertices, const unsigned int* indices, const vec3* normals,
+                             const size_t begin, const size_t end)
+{
+    Meshlet meshlet{};
+    meshlet.FirstIndex = static_cast<unsigned int>(begin);
+    meshlet.IndexCount = static_cast<unsigned int>(end - begin);
+
+    vec3 lo = vertices[indices[begin]].Position, hi = lo;
+    for (size_t i = begin; i < end; i++)
+    {
+        const auto& p = vertices[indices[i]].Position;
+        lo = vec3{std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z)};
+        hi = vec3{std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z)};
+    }
+    meshlet.Center = (lo + hi) * 0.5f;
+
+    float radius2 = 0.0f;
+    for (size_t i = begin; i < end; i++)
+    {
+        const auto d = vertices[indices[i]].Position - meshlet.Center;
+        radius2 = std::max(radius2, d.dot(d));
+    }
+    meshlet.Radius = std::sqrt(radius2);
+
+    vec3 normalSum{0.0f};
+    for (size_t t = begin / 3; t < end / 3; t++)
+    {
+        normalSum += normals[t];
+    }
+    const float sumLength = normalSum.magnitude();
+    meshlet.ConeAxis = sumLength > 0.0f ? normalSum * (1.0f / sumLength) : vec3{0.0f, 0.0f, 1.0f};
+    float minDot = 1.0f;
+    for (size_t t = begin / 3; t < end / 3; t++)
+    {
+        minDot = std::min(minDot, normals[t].dot(meshlet.ConeAxis));
+    }
+    meshlet.ConeCutoff = minDot > MESHLET_MIN_CONE_DOT ? std::sqrt(1.0f - minDot * minDot) : 1.0f;
+    return meshlet;
+}
+
+std::vector<Meshlet> buildMeshlets(const Vertex* vertices, const size_t vertexCount, const unsigned int* indices,
+                                   const size_t indexCount)
+{
+    std::vector<Meshlet> meshlets;
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+    {
+        return meshlets;
+    }
+
+    std::vector<vec3> normals(triangleCount);
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        normals[t] = triangleNormal(vertices, &indices[t * 3]);
+    }
+
+    // The meshlet that last used every vertex, plus one; counts the distinct vertices without clearing a set.
+    std::vector<unsigned int> stamps(vertexCount, 0);
+    unsigned int stamp = 1;
+    size_t begin = 0, uniqueVertices = 0;
+    vec3 normalSum{0.0f};
+
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        const unsigned int* corners = &indices[t * 3];
+        size_t newVertices = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            newVertices += stamps[corners[k]] != stamp && (k == 0 || corners[k] != corners[0]) &&
+                           (k < 2 || corners[k] != corners[1]);
+        }
+        const auto& normal = normals[t];
+        const float sumLength = normalSum.magnitude();
+
+        const bool full = uniqueVertices + newVertices > MESHLET_MAX_VERTICES ||
+                          t * 3 - begin >= MESHLET_MAX_TRIANGLES * 3;
+        const bool turned = sumLength > 0.0f && normal.dot(normalSum) < MESHLET_SPLIT_COSINE * sumLength;
+        if (t * 3 > begin && (full || turned))
+        {
+            meshlets.push_back(finishMeshlet(vertices, indices, normals.data(), begin, t * 3));
+            begin = t * 3;
+            uniqueVertices = 0;
+            normalSum = vec3{0.0f};
+            stamp++;
+        }
+
+        for (int k = 0; k < 3; k++)
+        {
+            uniqueVertices += stamps[corners[k]] != stamp;
+            stamps[corners[k]] = stamp;
+        }
+        normalSum += normal;
+    }
+    meshlets.push_back(finishMeshlet(vertices, indices, normals.data(), begin, triangleCount * 3));
+    return meshlets;
+}
+
+bool isBackfacing(const Meshlet& meshlet, const vec3& eye)
+{
+    // Every point of the sphere is behind the plane of every normal in the cone as seen from eye.
+    const auto toCenter = meshlet.Center - eye;
+    return toCenter.dot(meshlet.ConeAxis) >= meshlet.ConeCutoff * toCenter.magnitude() + meshlet.Radius;
+}
+
+size_t cullMeshlets(const Meshlet* meshlets, const size_t count, const DrawRange& range, const Frustum& frustum,
+                    const vec3& eye, std::vector<DrawRange>& visible)
+{
+    size_t triangles = 0;
+    bool extend = false;
+    for (size_t m = 0; m < count; m++)
+    {
+        const auto& meshlet = meshlets[m];
+        if (isBackfacing(meshlet, eye) || !frustum.intersects(Sphere{meshlet.Center, meshlet.Radius}))
+        {
+            extend = false;
+            continue;
+        }
+
+        if (extend)
+        {
+            visible.back().IndexCount += meshlet.IndexCount;
+        }
+        else
+        {
+            auto part = range;
+            part.FirstIndex += meshlet.FirstIndex;
+            part.IndexCount = meshlet.IndexCount;
+            visible.push_back(part);
+        }
+        extend = true;
+        triangles += meshlet.IndexCount / 3;
+    }
+    return triangles;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "geometry.h"
+#include "math.h"
+#include "mesh.h"
+
+/////////////////////////// Meshlets ////////////////////////////
+// Small clusters of a mesh's triangles with the data to cull them on the CPU before drawing. Meshlets are runs of
+// the index list as it is, so they draw straight out of the buffers a mesh already has; optimizeMesh() leaves the
+// triangles in a spatially coherent order, which keeps the runs compact and their normals close together.
+constexpr size_t MESHLET_MAX_VERTICES = 64;
+constexpr size_t MESHLET_MAX_TRIANGLES = 124;
+
+// Meshes with fewer triangles are drawn whole, culling would cost more than it saves.
+constexpr size_t MESHLET_MIN_TRIANGLES = 4096;
+
+struct Meshlet
+{
+    unsigned int FirstIndex;  // relative to the mesh
+    unsigned int IndexCount;
+
+    // Object space bounding sphere of the vertices.
+    vec3 Center;
+    float Radius;
+
+    // Normal cone: the cutoff is the sine of the widest angle between a triangle normal and the axis, see
+    // isBackfacing(). Cones of 1 never cull.
+    vec3 ConeAxis;
+    float ConeCutoff;
+};
+
+// Splits the triangle list into runs of at most MESHLET_MAX_VERTICES distinct vertices and MESHLET_MAX_TRIANGLES
+// triangles. A run also ends early at a triangle facing too far from the normals gathered so far, which keeps the
+// cones narrow enough to cull.
+std::vector<Meshlet> buildMeshlets(const Vertex* vertices, const size_t vertexCount, const unsigned int* indices,
+                                   const size_t indexCount);
+
+// True when no triangle of the meshlet can face eye, both in object space.
+bool isBackfacing(const Meshlet& meshlet, const vec3& eye);
+
+// Appends the parts of range (the mesh the meshlets were built from) that survive the frustum and backface tests to
+// visible, consecutive meshlets merged into one range. frustum and eye are in object space, e.g. the frustum of
+// projection * view * model. Returns the number of triangles appended.
+size_t cullMeshlets(const Meshlet* meshlets, const size_t count, const DrawRange& range, const Frustum& frustum,
+                    const vec3& eye, std::vector<DrawRange>& visible);
+////////////////////////////////////////////////////////////////
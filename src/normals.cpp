@@ -0,0 +1,300 @@
+#include "normals.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "parallel.h"
+
+constexpr unsigned int EMPTY = ~0u;
+
+// Triangles or vertices per thread.
+constexpr size_t NORMAL_RANGE = 1 << 14;
+
+// Unit normal of every triangle and the weight of each of its corners in the sums around a vertex.
+struct Faces
+{
+    std::vector<vec3> Normals;
+    std::vector<float> Weights;  // per corner
+};
+
+// Corners around every key (a vertex or a position), as offsets into one shared list.
+struct Adjacency
+{
+    std::vector<unsigned int> Offsets;  // keyCount + 1
+    std::vector<unsigned int> Corners;
+};
+
+// Angle between the directions u and v of the given lengths. Abramowitz and Stegun 4.4.45, at most 7e-5 radians off,
+// plenty for weights; std::acos() took most of the time of the ANGLE mode.
+static float angle(const vec3& u, const float lu, const vec3& v, const float lv)
+{
+    const float x = std::min(std::max(u.dot(v) / (lu * lv), -1.0f), 1.0f);
+    const float a = std::abs(x);
+    const float r = std::sqrt(1.0f - a) * (1.5707288f + a * (-0.2121144f + a * (0.0742610f + a * -0.0187293f)));
+    return x >= 0.0f ? r : PI - r;
+}
+
+// Cross product of the triangle's edges, twice the area long, and the weight of each corner such that normal * weight
+// is its share of the sum around the vertex. Reads only positions, so computeNormals() can write the normals of the
+// same vertices.
+static void faceNormal(const Vertex* vertices, const unsigned int* corners, const NormalMode mode, vec3& normal,
+                       float* weights)
+{
+    const auto& a = vertices[corners[0]].Position;
+    const auto& b = vertices[corners[1]].Position;
+    const auto& c = vertices[corners[2]].Position;
+
+    const auto ab = b - a, bc = c - b, ca = a - c;
+    normal = ab.cross(c - a);
+    const float area = normal.magnitude();
+    const float inverseArea = area > 0.0f ? 1.0f / area : 0.0f;
+
+    switch (mode)
+    {
+    case NormalMode::FLAT:
+        std::fill(weights, weights + 3, inverseArea);
+        break;
+    case NormalMode::AREA:
+        std::fill(weights, weights + 3, 1.0f);
+        break;
+    case NormalMode::ANGLE:
+    {
+        // Interior angles, the third is what the other two leave of PI. Edges run around the triangle, so the angle
+        // at a corner is PI minus the one between its two edges.
+        const float lab = ab.magnitude(), lbc = bc.magnitude(), lca = ca.magnitude();
+        if (inverseArea == 0.0f)
+        {
+            std::fill(weights, weights + 3, 0.0f);
+            break;
+        }
+        weights[0] = PI - angle(ca, lca, ab, lab);
+        weights[1] = PI - angle(ab, lab, bc, lbc);
+        weights[2] = std::max(PI - weights[0] - weights[1], 0.0f);
+        for (int k = 0; k < 3; k++)
+        {
+            weights[k] *= inverseArea;
+        }
+        break;
+    }
+    }
+}
+
+// Unit normals and weights to match, the crease test needs the angle between faces.
+static Faces computeFaces(const Vertex* vertices, const unsigned int* indices, const size_t triangleCount,
+                          const NormalMode mode)
+{
+    Faces faces;
+    faces.Normals.resize(triangleCount);
+    faces.Weights.resize(triangleCount * 3);
+
+    parallelFor(triangleCount, NORMAL_RANGE, [&](const size_t begin, const size_t end) {
+        for (size_t t = begin; t < end; t++)
+        {
+            auto& normal = faces.Normals[t];
+            float* weights = &faces.Weights[t * 3];
+            faceNormal(vertices, &indices[t * 3], mode, normal, weights);
+
+            const float area = normal.magnitude();
+            const float inverseArea = area > 0.0f ? 1.0f / area : 0.0f;
+            normal *= inverseArea;
+            for (int k = 0; k < 3; k++)
+            {
+                weights[k] *= area;
+            }
+        }
+    });
+    return faces;
+}
+
+// Counting sort of the corners by key. A single pass over the indices, cheap next to the per-vertex sums.
+static Adjacency buildAdjacency(const unsigned int* keys, const size_t cornerCount, const size_t keyCount)
+{
+    Adjacency adjacency;
+    adjacency.Offsets.assign(keyCount + 1, 0);
+    adjacency.Corners.resize(cornerCount);
+
+    for (size_t c = 0; c < cornerCount; c++)
+    {
+        adjacency.Offsets[keys[c] + 1]++;
+    }
+    for (size_t k = 0; k < keyCount; k++)
+    {
+        adjacency.Offsets[k + 1] += adjacency.Offsets[k];
+    }
+
+    std::vector<unsigned int> fill(adjacency.Offsets.begin(), adjacency.Offsets.end() - 1);
+    for (size_t c = 0; c < cornerCount; c++)
+    {
+        adjacency.Corners[fill[keys[c]]++] = static_cast<unsigned int>(c);
+    }
+    return adjacency;
+}
+
+static uint32_t floatBits(const float f)
+{
+    // + 0.0f folds -0 into +0, so values that compare equal also hash equal.
+    const float v = f + 0.0f;
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+// First vertex with the same position for every vertex, the same open addressing table as weldVertices().
+static std::vector<unsigned int> weldPositions(const Vertex* vertices, const size_t vertexCount)
+{
+    size_t capacity = 16;
+    while (capacity < vertexCount * 2)
+    {
+        capacity *= 2;
+    }
+    const size_t mask = capacity - 1;
+    std::vector<unsigned int> table(capacity, EMPTY);
+    std::vector<unsigned int> ids(vertexCount);
+
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        const auto& p = vertices[v].Position;
+        uint64_t h = 14695981039346656037ull;
+        for (const auto b : {floatBits(p.x), floatBits(p.y), floatBits(p.z)})
+        {
+            h = (h ^ b) * 1099511628211ull;
+        }
+        h ^= h >> 33;
+
+        size_t slot = static_cast<size_t>(h) & mask;
+        while (table[slot] != EMPTY && vertices[table[slot]].Position != p)
+        {
+            slot = (slot + 1) & mask;
+        }
+        if (table[slot] == EMPTY)
+        {
+            table[slot] = static_cast<unsigned int>(v);
+        }
+        ids[v] = table[slot];
+    }
+    return ids;
+}
+
+void computeNormals(Vertex* vertices, const size_t vertexCount, const unsigned int* indices, const size_t indexCount,
+                    const NormalMode mode)
+{
+    // Every thread owns a range of vertices and walks all triangles, adding only to its own vertices. Walking the
+    // indices is cheap next to the sums, and a triangle's normal is only computed again by the threads owning its
+    // other corners.
+    const size_t triangleCount = indexCount / 3;
+    parallelFor(vertexCount, NORMAL_RANGE, [&](const size_t begin, const size_t end) {
+        const auto owned = [begin, end](const unsigned int v) { return v - begin < end - begin; };
+
+        for (size_t v = begin; v < end; v++)
+        {
+            vertices[v].Normal = vec3{0.0f};
+        }
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            const unsigned int* corners = &indices[t * 3];
+            if (!owned(corners[0]) && !owned(corners[1]) && !owned(corners[2]))
+            {
+                continue;
+            }
+
+            vec3 normal;
+            float weights[3];
+            faceNormal(vertices, corners, mode, normal, weights);
+            for (int k = 0; k < 3; k++)
+            {
+                if (owned(corners[k]))
+                {
+                    vertices[corners[k]].Normal += normal * weights[k];
+                }
+            }
+        }
+        for (size_t v = begin; v < end; v++)
+        {
+            auto& n = vertices[v].Normal;
+            const float l = n.magnitude();
+            n = l > 0.0f ? n / l : vec3{0.0f};
+        }
+    });
+}
+
+Mesh generateNormals(const Vertex* vertices, const size_t vertexCount, const unsigned int* indices,
+                     const size_t indexCount, const NormalMode mode, const float creaseAngle)
+{
+    const size_t triangleCount = indexCount / 3;
+    const size_t cornerCount = triangleCount * 3;
+    const auto faces = computeFaces(vertices, indices, triangleCount, mode);
+
+    const auto positionIds = weldPositions(vertices, vertexCount);
+    std::vector<unsigned int> keys(cornerCount);
+    for (size_t c = 0; c < cornerCount; c++)
+    {
+        keys[c] = positionIds[indices[c]];
+    }
+    const auto adjacency = buildAdjacency(keys.data(), cornerCount, vertexCount);
+
+    // Every corner sums the faces around its position in the same order, so corners on the same side of a crease
+    // end up with bitwise equal normals and weld back together.
+    const float minCosine = std::cos(creaseAngle);
+    std::vector<vec3> normals(cornerCount);
+    parallelFor(triangleCount, NORMAL_RANGE, [&](const size_t begin, const size_t end) {
+        for (size_t t = begin; t < end; t++)
+        {
+            const auto& own = faces.Normals[t];
+            // A degenerate triangle has no side of a crease to be on and takes the smooth normal.
+            const bool degenerate = own.dot(own) == 0.0f;
+
+            for (size_t c = t * 3; c < t * 3 + 3; c++)
+            {
+                vec3 n = own;
+                if (mode != NormalMode::FLAT)
+                {
+                    n = vec3{0.0f};
+                    for (auto i = adjacency.Offsets[keys[c]]; i < adjacency.Offsets[keys[c] + 1]; i++)
+                    {
+                        const auto other = adjacency.Corners[i];
+                        const auto& normal = faces.Normals[other / 3];
+                        if (degenerate || own.dot(normal) >= minCosine)
+                        {
+                            n += normal * faces.Weights[other];
+                        }
+                    }
+                    const float l = n.magnitude();
+                    n = l > 0.0f ? n / l : vec3{0.0f};
+                }
+                normals[c] = n;
+            }
+        }
+    });
+
+    // One vertex per distinct normal around each position, positions in the order of their first vertex.
+    Mesh mesh;
+    mesh.Indices.resize(cornerCount);
+    for (size_t p = 0; p < vertexCount; p++)
+    {
+        const size_t first = mesh.Vertices.size();
+        for (auto i = adjacency.Offsets[p]; i < adjacency.Offsets[p + 1]; i++)
+        {
+            const auto c = adjacency.Corners[i];
+            size_t v = first;
+            while (v < mesh.Vertices.size() && mesh.Vertices[v].Normal != normals[c])
+            {
+                v++;
+            }
+            if (v == mesh.Vertices.size())
+            {
+                mesh.Vertices.push_back(Vertex{vertices[p].Position, normals[c]});
+            }
+            mesh.Indices[c] = static_cast<unsigned int>(v);
+        }
+    }
+    return mesh;
+}
+
+Mesh generateNormals(const Mesh& mesh, const NormalMode mode, const float creaseAngle)
+{
+    return generateNormals(mesh.Vertices.data(), mesh.Vertices.size(), mesh.Indices.data(), mesh.Indices.size(), mode,
+                           creaseAngle);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+
+#include "math.h"
+#include "mesh.h"
+
+/////////////////////////// Normal generation ///////////////////
+// Vertex normals from positions and triangles (counter-clockwise seen from the outside):
+//
+//   FLAT   every corner takes the normal of its triangle, faces are split apart.
+//   AREA   sum of the face normals around a vertex weighted by triangle area, big triangles dominate.
+//   ANGLE  sum weighted by the angle of every triangle at the vertex (Thurmer and Wuthrich), independent of how
+//          the faces around the vertex happen to be split into triangles.
+//
+// Both passes run over triangle and vertex ranges in parallel without atomics or locks: face normals and corner
+// weights are written per triangle, then every vertex gathers the triangles around it and writes only itself.
+enum class NormalMode
+{
+    FLAT,
+    AREA,
+    ANGLE
+};
+
+// Faces meeting at a sharper angle than this keep separate normals in generateNormals().
+constexpr float CREASE_ANGLE = radians(60.0f);
+
+// Smooth normals over the vertices as indexed, vertices are never split; FLAT weighs every face around a vertex the
+// same. Vertices no triangle uses get a zero normal.
+void computeNormals(Vertex* vertices, const size_t vertexCount, const unsigned int* indices, const size_t indexCount,
+                    const NormalMode mode = NormalMode::AREA);
+
+// New mesh with vertices welded by position and split again wherever the faces around a position form a crease:
+// every corner averages the faces within creaseAngle of its own face, and corners with equal results share a vertex.
+// creaseAngle is ignored in FLAT mode; PI smooths everything.
+Mesh generateNormals(const Vertex* vertices, const size_t vertexCount, const unsigned int* indices,
+                     const size_t indexCount, const NormalMode mode = NormalMode::ANGLE,
+                     const float creaseAngle = CREASE_ANGLE);
+
+Mesh generateNormals(const Mesh& mesh, const NormalMode mode = NormalMode::ANGLE,
+                     const float creaseAngle = CREASE_ANGLE);
+////////////////////////////////////////////////////////////////
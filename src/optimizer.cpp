@@ -0,0 +1,347 @@
+#include "optimizer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+constexpr unsigned int NONE = ~0u;
+
+// Triangles around every vertex, as offsets into one shared list.
+struct Adjacency
+{
+    std::vector<unsigned int> Offsets;  // vertexCount + 1
+    std::vector<unsigned int> Triangles;
+};
+
+static Adjacency buildAdjacency(const unsigned int* indices, const size_t indexCount, const size_t vertexCount)
+{
+    Adjacency adjacency;
+    adjacency.Offsets.assign(vertexCount + 1, 0);
+    adjacency.Triangles.resize(indexCount);
+
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        adjacency.Offsets[indices[i] + 1]++;
+    }
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        adjacency.Offsets[v + 1] += adjacency.Offsets[v];
+    }
+
+    std::vector<unsigned int> fill(adjacency.Offsets.begin(), adjacency.Offsets.end() - 1);
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        adjacency.Triangles[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+    }
+    return adjacency;
+}
+
+// FIFO cache by time stamps: a vertex is cached while fewer than cacheSize misses happened since it was loaded.
+class CacheSimulator
+{
+   public:
+    CacheSimulator(const size_t vertexCount, const unsigned int cacheSize)
+        : stamps(vertexCount, 0), time(cacheSize + 1), cacheSize(cacheSize)
+    {
+    }
+
+    // Returns the number of misses of the triangle.
+    unsigned int Triangle(const unsigned int* triangle)
+    {
+        unsigned int misses = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            if (time - stamps[triangle[k]] > cacheSize)
+            {
+                stamps[triangle[k]] = time++;
+                misses++;
+            }
+        }
+        return misses;
+    }
+
+    // Every vertex misses again, as if the cache was flushed.
+    void Reset() { time += cacheSize + 1; }
+
+   private:
+    std::vector<unsigned int> stamps;
+    unsigned int time;
+    unsigned int cacheSize;
+};
+
+VertexCacheStats analyzeVertexCache(const unsigned int* indices, const size_t indexCount, const size_t vertexCount,
+                                    const unsigned int cacheSize)
+{
+    CacheSimulator cache{vertexCount, cacheSize};
+    std::vector<uint8_t> referenced(vertexCount, 0);
+
+    size_t misses = 0;
+    for (size_t i = 0; i + 2 < indexCount; i += 3)
+    {
+        misses += cache.Triangle(indices + i);
+    }
+
+    size_t unique = 0;
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        unique += !referenced[indices[i]];
+        referenced[indices[i]] = 1;
+    }
+
+    const size_t triangles = indexCount / 3;
+    return VertexCacheStats{triangles > 0 ? static_cast<float>(misses) / triangles : 0.0f,
+                            unique > 0 ? static_cast<float>(misses) / unique : 0.0f};
+}
+
+void optimizeVertexCache(unsigned int* indices, const size_t indexCount, const size_t vertexCount,
+                         const unsigned int cacheSize)
+{
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    const auto adjacency = buildAdjacency(indices, triangleCount * 3, vertexCount);
+
+    // Triangles not emitted yet around every vertex.
+    std::vector<unsigned int> live(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        live[v] = adjacency.Offsets[v + 1] - adjacency.Offsets[v];
+    }
+
+    std::vector<unsigned int> stamps(vertexCount, 0);
+    unsigned int time = cacheSize + 1;
+
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<unsigned int> output;
+    output.reserve(triangleCount * 3);
+
+    // Recently used vertices, where fanning continues when the candidates run out.
+    std::vector<unsigned int> deadEnds;
+    std::vector<unsigned int> candidates;
+    size_t cursor = 0;
+
+    for (size_t fan = 0; fan != NONE;)
+    {
+        candidates.clear();
+        for (auto t = adjacency.Offsets[fan]; t < adjacency.Offsets[fan + 1]; t++)
+        {
+            const auto triangle = adjacency.Triangles[t];
+            if (emitted[triangle])
+            {
+                continue;
+            }
+            emitted[triangle] = 1;
+
+            for (int k = 0; k < 3; k++)
+            {
+                const auto v = indices[triangle * 3 + k];
+                output.push_back(v);
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (time - stamps[v] > cacheSize)
+                {
+                    stamps[v] = time++;
+                }
+            }
+        }
+
+        // The candidate that entered the cache earliest and whose remaining triangles won't push it out, else any
+        // candidate with triangles left.
+        size_t next = NONE;
+        int bestPriority = -1;
+        for (const auto v : candidates)
+        {
+            if (live[v] == 0)
+            {
+                continue;
+            }
+            int priority = 0;
+            if (time - stamps[v] + 2 * live[v] <= cacheSize)
+            {
+                priority = static_cast<int>(time - stamps[v]);
+            }
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                next = v;
+            }
+        }
+
+        while (next == NONE && !deadEnds.empty())
+        {
+            const auto v = deadEnds.back();
+            deadEnds.pop_back();
+            next = live[v] > 0 ? v : NONE;
+        }
+        while (next == NONE && cursor < vertexCount)
+        {
+            next = live[cursor] > 0 ? cursor : NONE;
+            cursor++;
+        }
+        fan = next;
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void optimizeOverdraw(unsigned int* indices, const size_t indexCount, const Vertex* vertices,
+                      const size_t vertexCount, const float threshold, const unsigned int cacheSize)
+{
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    // Hard boundaries: triangles missing all three vertices, where the cache order started over.
+    std::vector<size_t> hard;
+    {
+        CacheSimulator cache{vertexCount, cacheSize};
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            if (cache.Triangle(indices + t * 3) == 3 || t == 0)
+            {
+                hard.push_back(t);
+            }
+        }
+        hard.push_back(triangleCount);
+    }
+
+    // Soft boundaries split hard clusters wherever the part since the last boundary alone is already as cache
+    // efficient as the threshold allows.
+    std::vector<size_t> clusters;
+    {
+        CacheSimulator cache{vertexCount, cacheSize};
+        for (size_t h = 0; h + 1 < hard.size(); h++)
+        {
+            const size_t begin = hard[h], end = hard[h + 1];
+
+            cache.Reset();
+            size_t misses = 0;
+            for (size_t t = begin; t < end; t++)
+            {
+                misses += cache.Triangle(indices + t * 3);
+            }
+            const float target = threshold * static_cast<float>(misses) / static_cast<float>(end - begin);
+
+            cache.Reset();
+            clusters.push_back(begin);
+            misses = 0;
+            size_t start = begin;
+            for (size_t t = begin; t < end; t++)
+            {
+                misses += cache.Triangle(indices + t * 3);
+                if (t + 1 < end && static_cast<float>(misses) <= target * static_cast<float>(t + 1 - start))
+                {
+                    clusters.push_back(t + 1);
+                    cache.Reset();
+                    misses = 0;
+                    start = t + 1;
+                }
+            }
+        }
+        clusters.push_back(triangleCount);
+    }
+
+    // Area weighted centroid of the mesh, then how far every cluster faces away from it. The cross product is twice
+    // the area, which cancels out in every weighted average.
+    std::vector<vec3> normals(triangleCount), centroids(triangleCount);
+    std::vector<float> areas(triangleCount);
+    vec3 meshCenter{0.0f};
+    float meshArea = 0.0f;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        const auto& a = vertices[indices[t * 3]].Position;
+        const auto& b = vertices[indices[t * 3 + 1]].Position;
+        const auto& c = vertices[indices[t * 3 + 2]].Position;
+        normals[t] = (b - a).cross(c - a);
+        centroids[t] = (a + b + c) / 3.0f;
+        areas[t] = normals[t].magnitude();
+        meshCenter += centroids[t] * areas[t];
+        meshArea += areas[t];
+    }
+    meshCenter = meshArea > 0.0f ? meshCenter / meshArea : meshCenter;
+
+    const size_t clusterCount = clusters.size() - 1;
+    std::vector<float> facing(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        vec3 center{0.0f}, normal{0.0f};
+        float area = 0.0f;
+        for (size_t t = clusters[c]; t < clusters[c + 1]; t++)
+        {
+            center += centroids[t] * areas[t];
+            normal += normals[t];
+            area += areas[t];
+        }
+        const float length = normal.magnitude();
+        facing[c] = area > 0.0f && length > 0.0f ? (center / area - meshCenter).dot(normal / length) : 0.0f;
+    }
+
+    std::vector<size_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&facing](const size_t a, const size_t b) {
+        return facing[a] > facing[b];
+    });
+
+    std::vector<unsigned int> sorted;
+    sorted.reserve(triangleCount * 3);
+    for (const auto c : order)
+    {
+        sorted.insert(sorted.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+    }
+    std::copy(sorted.begin(), sorted.end(), indices);
+}
+
+size_t optimizeVertexFetch(Vertex* vertices, const size_t vertexCount, unsigned int* indices, const size_t indexCount)
+{
+    std::vector<unsigned int> remap(vertexCount, NONE);
+    unsigned int next = 0;
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        auto& slot = remap[indices[i]];
+        if (slot == NONE)
+        {
+            slot = next++;
+        }
+        indices[i] = slot;
+    }
+
+    const size_t referenced = next;
+    for (auto& slot : remap)
+    {
+        if (slot == NONE)
+        {
+            slot = next++;
+        }
+    }
+
+    std::vector<Vertex> reordered(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        reordered[remap[v]] = vertices[v];
+    }
+    std::copy(reordered.begin(), reordered.end(), vertices);
+    return referenced;
+}
+
+size_t optimizeMesh(Vertex* vertices, const size_t vertexCount, unsigned int* indices, const size_t indexCount)
+{
+    optimizeVertexCache(indices, indexCount, vertexCount);
+    optimizeOverdraw(indices, indexCount, vertices, vertexCount);
+    return optimizeVertexFetch(vertices, vertexCount, indices, indexCount);
+}
+
+void optimizeMesh(Mesh& mesh)
+{
+    const auto referenced = optimizeMesh(mesh.Vertices.data(), mesh.Vertices.size(), mesh.Indices.data(),
+                                         mesh.Indices.size());
+    mesh.Vertices.resize(referenced);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+
+#include "mesh.h"
+
+/////////////////////////// Mesh optimization ///////////////////
+// Reorders indexed triangle lists for the GPU, meant to run once when a mesh is built or converted:
+//
+//   1. optimizeVertexCache() orders triangles so vertices are reused while still in the post-transform cache.
+//   2. optimizeOverdraw() reorders clusters of that order so outward facing ones are drawn first, trading a little
+//      of the cache efficiency for early depth rejection.
+//   3. optimizeVertexFetch() renumbers vertices in the order they are first used, so fetches walk memory linearly.
+//
+// None of the passes changes the triangles themselves or their winding.
+
+// FIFO size the reordering targets and the statistics simulate, in vertices.
+constexpr unsigned int VERTEX_CACHE_SIZE = 16;
+
+struct VertexCacheStats
+{
+    float ACMR;  // average cache miss ratio: transformed vertices per triangle, 0.5 to 3
+    float ATVR;  // average transform to vertex ratio: transformed vertices per referenced vertex, 1 at best
+};
+
+// Simulates a FIFO post-transform cache of cacheSize entries over the triangle list.
+VertexCacheStats analyzeVertexCache(const unsigned int* indices, const size_t indexCount, const size_t vertexCount,
+                                    const unsigned int cacheSize = VERTEX_CACHE_SIZE);
+
+// Tipsify (Sander, Nehab and Barczak, "Fast triangle reordering for vertex locality and reduced overdraw"): fans
+// around the most recently used vertex whose remaining triangles still fit the cache, linear in the triangle count.
+void optimizeVertexCache(unsigned int* indices, const size_t indexCount, const size_t vertexCount,
+                         const unsigned int cacheSize = VERTEX_CACHE_SIZE);
+
+// Splits the cache optimized order into clusters and sorts them so clusters facing away from the mesh center come
+// first. Clusters end where the cache order restarts or where the cluster alone is within threshold of the cache
+// efficiency of the whole run, so 1.05 gives up at most about 5% ACMR.
+void optimizeOverdraw(unsigned int* indices, const size_t indexCount, const Vertex* vertices,
+                      const size_t vertexCount, const float threshold = 1.05f,
+                      const unsigned int cacheSize = VERTEX_CACHE_SIZE);
+
+// Renumbers the vertices in order of first use and rewrites indices to match. Unreferenced vertices are moved to
+// the end; returns the number of referenced ones.
+size_t optimizeVertexFetch(Vertex* vertices, const size_t vertexCount, unsigned int* indices, const size_t indexCount);
+
+// All three passes in order. Returns the number of referenced vertices, see optimizeVertexFetch().
+size_t optimizeMesh(Vertex* vertices, const size_t vertexCount, unsigned int* indices, const size_t indexCount);
+
+// Same as above, unreferenced vertices are removed.
+void optimizeMesh(Mesh& mesh);
+////////////////////////////////////////////////////////////////
@@ -0,0 +1,138 @@
+#include "parallel.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+// Threads started once and kept waiting for jobs, so a parallelFor() in the frame loop costs a wake-up instead of
+// creating and joining threads. Jobs are queued in call order; whoever takes one claims its ranges one at a time
+// until none are left, then drops it from the queue.
+class WorkerPool
+{
+   public:
+    WorkerPool()
+    {
+        const unsigned int count = std::max(1u, std::thread::hardware_concurrency()) - 1;
+        threads.reserve(count);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            threads.emplace_back([this]() { work(); });
+        }
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    void Run(const size_t ranges, void (*run)(void *context, size_t range), void *context)
+    {
+        Job job{run, context, ranges};
+        if (!threads.empty())
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                jobs.push_back(&job);
+            }
+            wake.notify_all();
+        }
+
+        const size_t executed = execute(job);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        finish(job, executed);
+        finished.wait(lock, [&job]() { return job.done == job.ranges && job.users == 0; });
+    }
+
+   private:
+    struct Job
+    {
+        void (*run)(void *context, size_t range);
+        void *context;
+        size_t ranges;
+        std::atomic<size_t> next{0};
+
+        // Guarded by the mutex. The job lives on its caller's stack, so the caller also waits for the workers
+        // still holding it.
+        size_t done = 0;
+        size_t users = 0;
+
+        Job(void (*run)(void *, size_t), void *context, const size_t ranges)
+            : run(run), context(context), ranges(ranges)
+        {
+        }
+    };
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    std::vector<Job *> jobs;
+    bool stopping = false;
+
+    static size_t execute(Job &job)
+    {
+        size_t executed = 0;
+        for (size_t range = job.next++; range < job.ranges; range = job.next++)
+        {
+            job.run(job.context, range);
+            executed++;
+        }
+        return executed;
+    }
+
+    // With the mutex held, after execute() found every range claimed.
+    void finish(Job &job, const size_t executed)
+    {
+        const auto queued = std::find(jobs.begin(), jobs.end(), &job);
+        if (queued != jobs.end())
+        {
+            jobs.erase(queued);
+        }
+        job.done += executed;
+    }
+
+    void work()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;)
+        {
+            wake.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if (stopping)
+            {
+                return;
+            }
+
+            auto &job = *jobs.front();
+            job.users++;
+            lock.unlock();
+            const size_t executed = execute(job);
+            lock.lock();
+
+            finish(job, executed);
+            job.users--;
+            if (job.done == job.ranges && job.users == 0)
+            {
+                finished.notify_all();
+            }
+        }
+    }
+};
+
+void parallelRun(const size_t ranges, void (*run)(void *context, size_t range), void *context)
+{
+    static WorkerPool pool;
+    pool.Run(ranges, run, context);
+}
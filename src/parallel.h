@@ -0,0 +1,40 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+
+// Calls run(context, range) for every range in [0, ranges) on the worker pool and the calling thread and returns when
+// all of them are done. The pool has one thread less than the hardware and is started by the first call; a call
+// from inside a range works through its own ranges rather than waiting for a free worker.
+void parallelRun(const size_t ranges, void (*run)(void *context, size_t range), void *context);
+
+// Splits [0, count) into contiguous ranges of at least minRange items and calls fn(begin, end) for each of them,
+// one range per hardware thread. The calling thread takes part, so small inputs run inline.
+template <typename Fn>
+inline void parallelFor(const size_t count, const size_t minRange, Fn &&fn)
+{
+    const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t ranges = std::min(threads, std::max<size_t>(1, count / std::max<size_t>(1, minRange)));
+
+    if (ranges <= 1)
+    {
+        fn(size_t{0}, count);
+        return;
+    }
+
+    struct Context
+    {
+        Fn *fn;
+        size_t count;
+        size_t step;
+    };
+    Context context{&fn, count, (count + ranges - 1) / ranges};
+
+    const auto run = [](void *c, const size_t range) {
+        const auto &context = *static_cast<Context *>(c);
+        const size_t begin = range * context.step;
+        (*context.fn)(begin, std::min(begin + context.step, context.count));
+    };
+    parallelRun((count + context.step - 1) / context.step, run, &context);
+}
@@ -0,0 +1,318 @@
+#include "range_allocator.h"
+
+#include <algorithm>
+#include <cassert>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Index of the highest and lowest set bit, x must not be 0.
+static uint32_t highestBit(const uint32_t x)
+{
+#ifdef _MSC_VER
+    unsigned long bit;
+    _BitScanReverse(&bit, x);
+    return bit;
+#else
+    return 31 - __builtin_clz(x);
+#endif
+}
+
+static uint32_t lowestBit(const uint32_t x)
+{
+#ifdef _MSC_VER
+    unsigned long bit;
+    _BitScanForward(&bit, x);
+    return bit;
+#else
+    return __builtin_ctz(x);
+#endif
+}
+
+// Size class of a block: sizes below ARENA_SL_COUNT get a list each in the first row, larger ones fall into
+// ARENA_SL_COUNT lists per power of two.
+static void sizeClass(const uint32_t size, uint32_t& fl, uint32_t& sl)
+{
+    if (size < ARENA_SL_COUNT)
+    {
+        fl = 0;
+        sl = size;
+        return;
+    }
+    const uint32_t bit = highestBit(size);
+    fl = bit - ARENA_SL_BITS + 1;
+    sl = (size >> (bit - ARENA_SL_BITS)) ^ ARENA_SL_COUNT;
+}
+
+uint32_t arenaFitSize(uint32_t size)
+{
+    size = std::max(size, 1u);
+    return size < ARENA_SL_COUNT ? size : size + (1u << (highestBit(size) - ARENA_SL_BITS)) - 1;
+}
+
+uint32_t arenaGrowCapacity(const uint32_t capacity, const uint32_t size, const uint32_t minimum)
+{
+    return std::max({capacity * 2, capacity + arenaFitSize(size), minimum});
+}
+
+RangeAllocator::RangeAllocator(const uint32_t capacity)
+{
+    for (auto& row : heads)
+    {
+        std::fill(std::begin(row), std::end(row), ARENA_NONE);
+    }
+    Grow(capacity);
+}
+
+ArenaHandle RangeAllocator::Allocate(uint32_t size)
+{
+    size = std::max(size, 1u);
+
+    // The class rounding must not overflow.
+    if (size > ~0u - (~0u >> ARENA_SL_BITS))
+    {
+        return ARENA_NONE;
+    }
+
+    // Round up to the next class boundary, so every block in the class found is large enough.
+    uint32_t fl, sl;
+    sizeClass(arenaFitSize(size), fl, sl);
+
+    uint32_t secondMap = secondLevelMaps[fl] & (~0u << sl);
+    if (secondMap == 0)
+    {
+        const uint32_t firstMap = fl + 1 < ARENA_FL_COUNT ? firstLevelMap & (~0u << (fl + 1)) : 0;
+        if (firstMap == 0)
+        {
+            return ARENA_NONE;
+        }
+        fl = lowestBit(firstMap);
+        secondMap = secondLevelMaps[fl];
+    }
+    sl = lowestBit(secondMap);
+
+    const uint32_t block = heads[fl][sl];
+    removeFree(block);
+    blocks[block].Free = false;
+
+    // The rest goes back as a free block right after it.
+    if (blocks[block].Size > size)
+    {
+        const uint32_t rest = newBlock(blocks[block].Offset + size, blocks[block].Size - size);
+        blocks[block].Size = size;
+
+        linkAfter(block, rest);
+        insertFree(rest);
+    }
+
+    used += size;
+    allocations++;
+    return block;
+}
+
+void RangeAllocator::Free(const ArenaHandle handle)
+{
+    assert(handle < blocks.size() && !blocks[handle].Free && "Invalid or freed arena handle");
+
+    uint32_t block = handle;
+    used -= blocks[block].Size;
+    allocations--;
+    blocks[block].Free = true;
+
+    // Merge with the neighbours, the earlier block absorbs the later one.
+    const uint32_t next = blocks[block].NextPhysical;
+    if (next != ARENA_NONE && blocks[next].Free)
+    {
+        removeFree(next);
+        blocks[block].Size += blocks[next].Size;
+        unlink(next);
+    }
+
+    const uint32_t previous = blocks[block].PreviousPhysical;
+    if (previous != ARENA_NONE && blocks[previous].Free)
+    {
+        removeFree(previous);
+        blocks[previous].Size += blocks[block].Size;
+        unlink(block);
+        block = previous;
+    }
+
+    insertFree(block);
+}
+
+void RangeAllocator::Grow(const uint32_t newCapacity)
+{
+    if (newCapacity <= capacity)
+    {
+        return;
+    }
+
+    const uint32_t added = newCapacity - capacity;
+    if (lastPhysical != ARENA_NONE && blocks[lastPhysical].Free)
+    {
+        removeFree(lastPhysical);
+        blocks[lastPhysical].Size += added;
+        insertFree(lastPhysical);
+    }
+    else
+    {
+        const uint32_t block = newBlock(capacity, added);
+        linkAfter(lastPhysical, block);
+        insertFree(block);
+    }
+    capacity = newCapacity;
+}
+
+void RangeAllocator::Defragment(std::vector<ArenaMove>& moves)
+{
+    // Walk the blocks in offset order, sliding every allocation down over the free space before it.
+    uint32_t offset = 0;
+    uint32_t previous = ARENA_NONE;
+    uint32_t block = firstPhysical;
+    while (block != ARENA_NONE)
+    {
+        const uint32_t next = blocks[block].NextPhysical;
+        if (blocks[block].Free)
+        {
+            removeFree(block);
+            deleteBlock(block);
+        }
+        else
+        {
+            auto& b = blocks[block];
+            if (b.Offset != offset)
+            {
+                moves.push_back(ArenaMove{b.Offset, offset, b.Size});
+                b.Offset = offset;
+            }
+            b.PreviousPhysical = previous;
+            (previous != ARENA_NONE ? blocks[previous].NextPhysical : firstPhysical) = block;
+            previous = block;
+            offset += b.Size;
+        }
+        block = next;
+    }
+
+    if (previous == ARENA_NONE)
+    {
+        firstPhysical = ARENA_NONE;
+    }
+    else
+    {
+        blocks[previous].NextPhysical = ARENA_NONE;
+    }
+    lastPhysical = previous;
+
+    if (offset < capacity)
+    {
+        const uint32_t rest = newBlock(offset, capacity - offset);
+        linkAfter(lastPhysical, rest);
+        insertFree(rest);
+    }
+}
+
+ArenaStats RangeAllocator::GetStats() const
+{
+    ArenaStats stats{capacity, used, allocations, 0, 0};
+    for (uint32_t fl = 0; fl < ARENA_FL_COUNT; fl++)
+    {
+        for (uint32_t sl = 0; sl < ARENA_SL_COUNT; sl++)
+        {
+            for (uint32_t block = heads[fl][sl]; block != ARENA_NONE; block = blocks[block].NextFree)
+            {
+                stats.FreeBlocks++;
+                stats.LargestFree = std::max<size_t>(stats.LargestFree, blocks[block].Size);
+            }
+        }
+    }
+    return stats;
+}
+
+uint32_t RangeAllocator::newBlock(const uint32_t offset, const uint32_t size)
+{
+    uint32_t block = unusedSlots;
+    if (block != ARENA_NONE)
+    {
+        unusedSlots = blocks[block].NextFree;
+    }
+    else
+    {
+        block = static_cast<uint32_t>(blocks.size());
+        blocks.emplace_back();
+    }
+    blocks[block] = Block{offset, size, ARENA_NONE, ARENA_NONE, ARENA_NONE, ARENA_NONE, true};
+    return block;
+}
+
+void RangeAllocator::deleteBlock(const uint32_t block)
+{
+    blocks[block].NextFree = unusedSlots;
+    unusedSlots = block;
+}
+
+void RangeAllocator::linkAfter(const uint32_t previous, const uint32_t block)
+{
+    auto& next = previous != ARENA_NONE ? blocks[previous].NextPhysical : firstPhysical;
+    blocks[block].PreviousPhysical = previous;
+    blocks[block].NextPhysical = next;
+    (next != ARENA_NONE ? blocks[next].PreviousPhysical : lastPhysical) = block;
+    next = block;
+}
+
+void RangeAllocator::unlink(const uint32_t block)
+{
+    const uint32_t previous = blocks[block].PreviousPhysical;
+    const uint32_t next = blocks[block].NextPhysical;
+    (previous != ARENA_NONE ? blocks[previous].NextPhysical : firstPhysical) = next;
+    (next != ARENA_NONE ? blocks[next].PreviousPhysical : lastPhysical) = previous;
+    deleteBlock(block);
+}
+
+void RangeAllocator::insertFree(const uint32_t block)
+{
+    auto& b = blocks[block];
+    b.Free = true;
+
+    uint32_t fl, sl;
+    sizeClass(b.Size, fl, sl);
+    b.PreviousFree = ARENA_NONE;
+    b.NextFree = heads[fl][sl];
+    if (b.NextFree != ARENA_NONE)
+    {
+        blocks[b.NextFree].PreviousFree = block;
+    }
+    heads[fl][sl] = block;
+
+    firstLevelMap |= 1u << fl;
+    secondLevelMaps[fl] |= 1u << sl;
+}
+
+void RangeAllocator::removeFree(const uint32_t block)
+{
+    const auto& b = blocks[block];
+
+    uint32_t fl, sl;
+    sizeClass(b.Size, fl, sl);
+    if (b.PreviousFree != ARENA_NONE)
+    {
+        blocks[b.PreviousFree].NextFree = b.NextFree;
+    }
+    else
+    {
+        heads[fl][sl] = b.NextFree;
+    }
+    if (b.NextFree != ARENA_NONE)
+    {
+        blocks[b.NextFree].PreviousFree = b.PreviousFree;
+    }
+
+    if (heads[fl][sl] == ARENA_NONE)
+    {
+        secondLevelMaps[fl] &= ~(1u << sl);
+        if (secondLevelMaps[fl] == 0)
+        {
+            firstLevelMap &= ~(1u << fl);
+        }
+    }
+}
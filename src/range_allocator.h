@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/////////////////////////// Range allocator /////////////////////
+// Two-level segregated fit (TLSF) allocator over an abstract range of units, e.g. the vertices or indices of a GPU
+// buffer. Free blocks are kept in lists by size class: the first level is the power of two, the second splits it
+// into ARENA_SL_COUNT steps, and two bitmaps find the smallest non-empty list that fits in constant time. Freed
+// blocks merge with free neighbours right away.
+//
+// Only the bookkeeping lives here, the memory itself belongs to the caller (see GpuArena). Allocations are
+// referred to by handle, which stays the same when Defragment() moves them.
+using ArenaHandle = uint32_t;
+constexpr ArenaHandle ARENA_NONE = ~0u;
+
+constexpr uint32_t ARENA_SL_BITS = 4;
+constexpr uint32_t ARENA_SL_COUNT = 1 << ARENA_SL_BITS;
+constexpr uint32_t ARENA_FL_COUNT = 32;
+
+// A range Defragment() moved, in units.
+struct ArenaMove
+{
+    uint32_t From;
+    uint32_t To;
+    uint32_t Size;
+};
+
+struct ArenaStats
+{
+    size_t Capacity;
+    size_t Used;
+    size_t Allocations;
+    size_t FreeBlocks;
+    size_t LargestFree;  // largest free block, see arenaFitSize()
+};
+
+// Smallest free block Allocate(size) is sure to take. Requests are rounded up to their size class before the
+// search, up to 1/16 more, so a block of exactly size may be passed over.
+uint32_t arenaFitSize(const uint32_t size);
+
+// Capacity to Grow() to when Allocate(size) failed: at least double, at least minimum, and enough added space
+// alone to take the request since the last block may be in use.
+uint32_t arenaGrowCapacity(const uint32_t capacity, const uint32_t size, const uint32_t minimum);
+
+class RangeAllocator
+{
+   public:
+    explicit RangeAllocator(const uint32_t capacity = 0);
+
+    // ARENA_NONE when no free block is large enough. Zero sized allocations take one unit.
+    ArenaHandle Allocate(uint32_t size);
+    void Free(const ArenaHandle handle);
+
+    uint32_t GetOffset(const ArenaHandle handle) const
+    {
+        assert(handle < blocks.size() && "Invalid arena handle");
+        return blocks[handle].Offset;
+    }
+    uint32_t GetSize(const ArenaHandle handle) const
+    {
+        assert(handle < blocks.size() && "Invalid arena handle");
+        return blocks[handle].Size;
+    }
+
+    // Adds capacity at the end, merged with the last block if that is free.
+    void Grow(const uint32_t capacity);
+
+    // Packs the allocations to the front in offset order, leaving one free block at the end. Appends every move to
+    // moves, in increasing offsets; handles stay valid.
+    void Defragment(std::vector<ArenaMove>& moves);
+
+    uint32_t GetCapacity() const { return capacity; }
+    ArenaStats GetStats() const;
+
+   private:
+    struct Block
+    {
+        uint32_t Offset;
+        uint32_t Size;
+        uint32_t PreviousPhysical, NextPhysical;
+        uint32_t PreviousFree, NextFree;
+        bool Free;
+    };
+
+    // Blocks by index; handles are indices, unused slots are chained through NextFree.
+    std::vector<Block> blocks;
+    uint32_t unusedSlots = ARENA_NONE;
+    uint32_t firstPhysical = ARENA_NONE;
+    uint32_t lastPhysical = ARENA_NONE;
+
+    uint32_t firstLevelMap = 0;
+    uint32_t secondLevelMaps[ARENA_FL_COUNT] = {};
+    uint32_t heads[ARENA_FL_COUNT][ARENA_SL_COUNT];
+
+    uint32_t capacity = 0;
+    uint32_t used = 0;
+    uint32_t allocations = 0;
+
+    uint32_t newBlock(const uint32_t offset, const uint32_t size);
+    void deleteBlock(const uint32_t block);
+    // Physical order: inserts block after previous (at the front for ARENA_NONE), or takes it out and deletes it.
+    void linkAfter(const uint32_t previous, const uint32_t block);
+    void unlink(const uint32_t block);
+    void insertFree(const uint32_t block);
+    void removeFree(const uint32_t block);
+};
+////////////////////////////////////////////////////////////////
@@ -1,40 +1,188 @@
 #include "shape.h"
 
-Shape::Shape(const ShapeType shapeType) { setup(shapeType); }
+#include <algorithm>
+#include <cassert>
+#include <utility>
 
-void Shape::Draw(const Shader& shader)
+#include "batch.h"
+#include "normals.h"
+#include "optimizer.h"
+
+Shape::Shape(GeometryBuffer& geometry, const ShapeType shapeType) : geometry(&geometry) { setup(shapeType); }
+
+Shape::Shape(GeometryBuffer& geometry, const LodChain& lods) : geometry(&geometry), levelCount(lods.GetLevelCount())
 {
-    glBindVertexArray(VAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
+    bounds = computeBounds(lods.GetVertices(0), lods.GetLevel(0).VertexCount);
+
+    for (int l = 0; l < levelCount; l++)
+    {
+        const auto& level = lods.GetLevel(l);
+        meshes[l] = geometry.Add(lods.GetVertices(l), level.VertexCount, lods.GetIndices(l), level.IndexCount);
+        clusterLevel(l, lods.GetVertices(l), level.VertexCount, lods.GetIndices(l), level.IndexCount);
+    }
 }
 
-void Shape::setup(const ShapeType shapeType)
+Shape::Shape(GeometryBuffer& geometry, const MeshFile& file)
+    : geometry(&geometry), levelCount(file.GetLevelCount()), bounds(file.GetBounds())
+{
+    for (int l = 0; l < levelCount; l++)
+    {
+        const auto level = file.GetLevel(l);
+        meshes[l] = geometry.AddExternal(file.GetVertices(l), level.VertexCount, file.GetIndices(l), level.IndexCount);
+        clusterLevel(l, file.GetVertices(l), level.VertexCount, file.GetIndices(l), level.IndexCount);
+    }
+}
+
+Shape::Shape(GeometryBuffer& geometry, const Mesh* levels, const int count) : geometry(&geometry), levelCount(count)
+{
+    assert(count > 0 && count <= MAX_LOD_LEVELS && "Invalid LOD level count");
+
+    bounds = computeBounds(levels[0].Vertices.data(), levels[0].Vertices.size());
+
+    for (int l = 0; l < levelCount; l++)
+    {
+        meshes[l] = geometry.Add(levels[l]);
+        clusterLevel(l, levels[l].Vertices.data(), levels[l].Vertices.size(), levels[l].Indices.data(),
+                     levels[l].Indices.size());
+    }
+}
+
+Shape::~Shape() { release(); }
+
+Shape::Shape(Shape&& other) noexcept
+    : geometry(std::exchange(other.geometry, nullptr)),
+      levelCount(other.levelCount),
+      bounds(other.bounds),
+      visibleRanges(std::move(other.visibleRanges))
+{
+    std::copy(other.meshes, other.meshes + levelCount, meshes);
+    std::move(other.meshlets, other.meshlets + levelCount, meshlets);
+}
+
+Shape& Shape::operator=(Shape&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        geometry = std::exchange(other.geometry, nullptr);
+        levelCount = other.levelCount;
+        bounds = other.bounds;
+        visibleRanges = std::move(other.visibleRanges);
+        std::copy(other.meshes, other.meshes + levelCount, meshes);
+        std::move(other.meshlets, other.meshlets + levelCount, meshlets);
+    }
+    return *this;
+}
+
+void Shape::Draw(const Shader& shader, const int level)
+{
+    setDecode(shader, level);
+    geometry->Draw(GetDrawRange(level));
+}
+
+size_t Shape::DrawCulled(const Shader& shader, const mat4& modelViewProjection, const vec3& eye, const int level)
+{
+    const auto& clusters = meshlets[level];
+    if (clusters.empty())
+    {
+        Draw(shader, level);
+        return GetTriangleCount(level);
+    }
+
+    visibleRanges.clear();
+    const auto triangles = cullMeshlets(clusters.data(), clusters.size(), GetDrawRange(level),
+                                        Frustum::fromMatrix(modelViewProjection), eye, visibleRanges);
+    if (!visibleRanges.empty())
+    {
+        setDecode(shader, level);
+        geometry->DrawMulti(visibleRanges.data(), visibleRanges.size());
+    }
+    return triangles;
+}
+
+void Shape::DrawInstanced(const Shader& shader, const mat4* models, const mat3* normals, const size_t n,
+                          const int level)
 {
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
+    setDecode(shader, level);
+    geometry->DrawInstanced(GetDrawRange(level), models, normals, n);
+}
+
+AABB Shape::GetBounds() const { return bounds; }
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+int Shape::GetLevelCount() const { return levelCount; }
+
+DrawRange Shape::GetDrawRange(const int level) const { return geometry->GetDrawRange(meshes[level]); }
+
+void Shape::setup(const ShapeType shapeType)
+{
+    const float* vertices = nullptr;
+    size_t size = 0;
 
     switch (shapeType)
     {
     case ShapeType::CUBE:
-        glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
+        vertices = cubeVertices;
+        size = sizeof(cubeVertices);
         break;
     case ShapeType::PYRAMID:
-        glBufferData(GL_ARRAY_BUFFER, sizeof(pyramidVertices), pyramidVertices, GL_STATIC_DRAW);
+        vertices = pyramidVertices;
+        size = sizeof(pyramidVertices);
         break;
     case ShapeType::CUBOID:
-        glBufferData(GL_ARRAY_BUFFER, sizeof(cuboidVertices), cuboidVertices, GL_STATIC_DRAW);
+        vertices = cuboidVertices;
+        size = sizeof(cuboidVertices);
         break;
     }
 
-    // vertex position
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-    glEnableVertexAttribArray(0);
-    // vertex normals
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-    glEnableVertexAttribArray(1);
+    // The vertex arrays are triangle soups, faces share positions but not normals, so the cube welds 36 vertices
+    // down to 24.
+    auto mesh = weldVertices(reinterpret_cast<const Vertex*>(vertices), size / sizeof(Vertex));
+    if (shapeType == ShapeType::PYRAMID)
+    {
+        mesh = generateNormals(mesh, NormalMode::FLAT);
+    }
+    optimizeMesh(mesh);
+    bounds = computeBounds(mesh.Vertices.data(), mesh.Vertices.size());
+    meshes[0] = geometry->Add(mesh);
+}
+
+void Shape::clusterLevel(const int level, const Vertex* vertices, const size_t vertexCount,
+                         const unsigned int* indices, const size_t indexCount)
+{
+    if (indexCount / 3 >= MESHLET_MIN_TRIANGLES)
+    {
+        meshlets[level] = buildMeshlets(vertices, vertexCount, indices, indexCount);
+    }
+}
+
+void Shape::setDecode(const Shader& shader, const int level) const
+{
+    const auto decode = GetDrawRange(level).Decode;
+    shader.setVec3("positionScale", decode.Scale);
+    shader.setVec3("positionOffset", decode.Offset);
+    shader.setBool("octahedralNormals", geometry->GetFormat() != VertexFormat::FLOAT);
+}
+
+void Shape::release()
+{
+    if (geometry == nullptr)
+    {
+        return;
+    }
+    for (int l = 0; l < levelCount; l++)
+    {
+        geometry->Remove(meshes[l]);
+    }
+    geometry = nullptr;
+}
+
+void transformVertices(const mat4& model, const Vertex* in, Vertex* out, const size_t n)
+{
+    if (n == 0)
+    {
+        return;
+    }
 
-    glBindVertexArray(VAO);
+    transformPoints(model, &in->Position, &out->Position, sizeof(Vertex), n);
+    transformNormals(normalMatrix(model), &in->Normal, &out->Normal, sizeof(Vertex), n);
 }
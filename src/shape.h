@@ -1,6 +1,11 @@
 #pragma once
 
+#include "generators.h"
+#include "geometry.h"
 #include "math.h"
+#include "mesh.h"
+#include "mesh_file.h"
+#include "meshlet.h"
 #include "shader.h"
 
 enum class ShapeType
@@ -10,80 +15,133 @@ enum class ShapeType
     CUBOID
 };
 
-struct Vertex
-{
-    vec3 Position;
-    vec3 Normal;
-};
+// Transforms interleaved vertices by a model matrix; normals go through its normal matrix. in and out may alias.
+void transformVertices(const mat4& model, const Vertex* in, Vertex* out, const size_t n);
 
+// Shapes keep their meshes in a GeometryBuffer shared with other shapes and remove them from it when they go, so
+// short-lived shapes recycle the buffer's space instead of allocating GL buffers of their own. Shapes are move-only,
+// so exactly one of them owns a mesh.
 class Shape
 {
    public:
-    Shape(const ShapeType shapeType);
+    // Adds the shape's mesh to geometry, which must outlive the shape and be uploaded before drawing.
+    Shape(GeometryBuffer& geometry, const ShapeType shapeType);
+
+    // Every level of the chain becomes a detail level of the shape.
+    Shape(GeometryBuffer& geometry, const LodChain& lods);
+
+    // Every level of the file, uploaded straight from the mapping: the file must stay open until geometry's
+    // Upload().
+    Shape(GeometryBuffer& geometry, const MeshFile& file);
+
+    // Detail levels supplied as meshes, finest first.
+    Shape(GeometryBuffer& geometry, const Mesh* levels, const int count);
+
+    ~Shape();
+
+    Shape(Shape&& other) noexcept;
+    Shape& operator=(Shape&& other) noexcept;
+    Shape(const Shape&) = delete;
+    Shape& operator=(const Shape&) = delete;
+
+    // The shader must be in use; Draw() sets its vertex decoding uniforms, see VertexFormat.
+    void Draw(const Shader& shader, const int level = 0);
+
+    // Draws the meshlets of level that pass cullMeshlets() in one multi-draw call; levels too small for meshlets are
+    // drawn whole. modelViewProjection is the clip matrix of the shape and eye the camera position in object space.
+    // Back faces count as hidden, as with GL_CULL_FACE. Returns the number of triangles submitted.
+    size_t DrawCulled(const Shader& shader, const mat4& modelViewProjection, const vec3& eye, const int level = 0);
 
-    void Draw(const Shader& shader);
+    // Draws n copies of the shape in one call, see GeometryBuffer::DrawInstanced(). normals may be null.
+    void DrawInstanced(const Shader& shader, const mat4* models, const mat3* normals, const size_t n,
+                       const int level = 0);
+
+    // Object space bounds of the finest level.
+    AABB GetBounds() const;
+
+    int GetLevelCount() const;
+    DrawRange GetDrawRange(const int level = 0) const;
+    size_t GetTriangleCount(const int level = 0) const { return GetDrawRange(level).IndexCount / 3; }
 
    private:
-    unsigned int VAO, VBO;
+    GeometryBuffer* geometry;  // null once moved from
+    MeshId meshes[MAX_LOD_LEVELS];
+    int levelCount = 1;
+    AABB bounds;
+
+    std::vector<Meshlet> meshlets[MAX_LOD_LEVELS];  // empty for levels below MESHLET_MIN_TRIANGLES
+    std::vector<DrawRange> visibleRanges;
 
     void setup(const ShapeType shapeType);
+    void clusterLevel(const int level, const Vertex* vertices, const size_t vertexCount, const unsigned int* indices,
+                      const size_t indexCount);
+    void setDecode(const Shader& shader, const int level) const;
+    void release();
 };
 
-const float cubeVertices[] = {-0.5f, -0.5f, -0.5f, 0.0f,  0.0f,  -1.0f, 0.5f,  -0.5f, -0.5f, 0.0f,  0.0f,  -1.0f,
-                        0.5f,  0.5f,  -0.5f, 0.0f,  0.0f,  -1.0f, 0.5f,  0.5f,  -0.5f, 0.0f,  0.0f,  -1.0f,
-                        -0.5f, 0.5f,  -0.5f, 0.0f,  0.0f,  -1.0f, -0.5f, -0.5f, -0.5f, 0.0f,  0.0f,  -1.0f,
+constexpr float cubeVertices[] = {
+    // Front face
+    -0.5f, -0.5f, -0.5f, 0.0f,  0.0f,  -1.0f, 0.5f,  -0.5f, -0.5f, 0.0f,  0.0f,  -1.0f,
+    0.5f,  0.5f,  -0.5f, 0.0f,  0.0f,  -1.0f, 0.5f,  0.5f,  -0.5f, 0.0f,  0.0f,  -1.0f,
+    -0.5f, 0.5f,  -0.5f, 0.0f,  0.0f,  -1.0f, -0.5f, -0.5f, -0.5f, 0.0f,  0.0f,  -1.0f,
 
-                        -0.5f, -0.5f, 0.5f,  0.0f,  0.0f,  1.0f,  0.5f,  -0.5f, 0.5f,  0.0f,  0.0f,  1.0f,
-                        0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
-                        -0.5f, 0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  -0.5f, -0.5f, 0.5f,  0.0f,  0.0f,  1.0f,
+    // Back face
+    -0.5f, -0.5f, 0.5f,  0.0f,  0.0f,  1.0f,  0.5f,  -0.5f, 0.5f,  0.0f,  0.0f,  1.0f,
+    0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+    -0.5f, 0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  -0.5f, -0.5f, 0.5f,  0.0f,  0.0f,  1.0f,
 
-                        -0.5f, 0.5f,  0.5f,  -1.0f, 0.0f,  0.0f,  -0.5f, 0.5f,  -0.5f, -1.0f, 0.0f,  0.0f,
-                        -0.5f, -0.5f, -0.5f, -1.0f, 0.0f,  0.0f,  -0.5f, -0.5f, -0.5f, -1.0f, 0.0f,  0.0f,
-                        -0.5f, -0.5f, 0.5f,  -1.0f, 0.0f,  0.0f,  -0.5f, 0.5f,  0.5f,  -1.0f, 0.0f,  0.0f,
+    // Left face
+    -0.5f, 0.5f,  0.5f,  -1.0f, 0.0f,  0.0f,  -0.5f, 0.5f,  -0.5f, -1.0f, 0.0f,  0.0f,
+    -0.5f, -0.5f, -0.5f, -1.0f, 0.0f,  0.0f,  -0.5f, -0.5f, -0.5f, -1.0f, 0.0f,  0.0f,
+    -0.5f, -0.5f, 0.5f,  -1.0f, 0.0f,  0.0f,  -0.5f, 0.5f,  0.5f,  -1.0f, 0.0f,  0.0f,
 
-                        0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.5f,  0.5f,  -0.5f, 1.0f,  0.0f,  0.0f,
-                        0.5f,  -0.5f, -0.5f, 1.0f,  0.0f,  0.0f,  0.5f,  -0.5f, -0.5f, 1.0f,  0.0f,  0.0f,
-                        0.5f,  -0.5f, 0.5f,  1.0f,  0.0f,  0.0f,  0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
+    // Right face
+    0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.5f,  0.5f,  -0.5f, 1.0f,  0.0f,  0.0f,
+    0.5f,  -0.5f, -0.5f, 1.0f,  0.0f,  0.0f,  0.5f,  -0.5f, -0.5f, 1.0f,  0.0f,  0.0f,
+    0.5f,  -0.5f, 0.5f,  1.0f,  0.0f,  0.0f,  0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
 
-                        -0.5f, -0.5f, -0.5f, 0.0f,  -1.0f, 0.0f,  0.5f,  -0.5f, -0.5f, 0.0f,  -1.0f, 0.0f,
-                        0.5f,  -0.5f, 0.5f,  0.0f,  -1.0f, 0.0f,  0.5f,  -0.5f, 0.5f,  0.0f,  -1.0f, 0.0f,
-                        -0.5f, -0.5f, 0.5f,  0.0f,  -1.0f, 0.0f,  -0.5f, -0.5f, -0.5f, 0.0f,  -1.0f, 0.0f,
+    // Bottom face
+    -0.5f, -0.5f, -0.5f, 0.0f,  -1.0f, 0.0f,  0.5f,  -0.5f, -0.5f, 0.0f,  -1.0f, 0.0f,
+    0.5f,  -0.5f, 0.5f,  0.0f,  -1.0f, 0.0f,  0.5f,  -0.5f, 0.5f,  0.0f,  -1.0f, 0.0f,
+    -0.5f, -0.5f, 0.5f,  0.0f,  -1.0f, 0.0f,  -0.5f, -0.5f, -0.5f, 0.0f,  -1.0f, 0.0f,
 
-                        -0.5f, 0.5f,  -0.5f, 0.0f,  1.0f,  0.0f,  0.5f,  0.5f,  -0.5f, 0.0f,  1.0f,  0.0f,
-                        0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
-                        -0.5f, 0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  -0.5f, 0.5f,  -0.5f, 0.0f,  1.0f,  0.0f};
+    // Top face
+    -0.5f, 0.5f,  -0.5f, 0.0f,  1.0f,  0.0f,  0.5f,  0.5f,  -0.5f, 0.0f,  1.0f,  0.0f,
+    0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
+    -0.5f, 0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  -0.5f, 0.5f,  -0.5f, 0.0f,  1.0f,  0.0f};
 
-const float pyramidVertices[] = {
+// Positions only, the normals are generated flat by Shape's constructor. The base faces down, away from the apex.
+constexpr float pyramidVertices[] = {
     // Base
-    -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 0.0f,  // Bottom-left
-    0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 0.0f,   // Bottom-right
-    0.5f, 0.5f, 0.0f, 0.0f, -1.0f, 0.0f,    // Top-right
-    0.5f, 0.5f, 0.0f, 0.0f, -1.0f, 0.0f,    // Top-right
-    -0.5f, 0.5f, 0.0f, 0.0f, -1.0f, 0.0f,   // Top-left
-    -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 0.0f,  // Bottom-left
+    -0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 0.0f,  // Bottom-left
+    0.5f, 0.5f, 0.0f, 0.0f, 0.0f, 0.0f,    // Top-right
+    0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 0.0f,   // Bottom-right
+    0.5f, 0.5f, 0.0f, 0.0f, 0.0f, 0.0f,    // Top-right
+    -0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 0.0f,  // Bottom-left
+    -0.5f, 0.5f, 0.0f, 0.0f, 0.0f, 0.0f,   // Top-left
 
     // Side 1
-    -0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 1.0f,  // Bottom-left
-    0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 1.0f,   // Bottom-right
-    0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f,    // Apex
+    -0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 0.0f,  // Bottom-left
+    0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 0.0f,   // Bottom-right
+    0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f,    // Apex
 
     // Side 2
-    0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f,  // Bottom-right
-    0.5f, 0.5f, 0.0f, 1.0f, 0.0f, 0.0f,   // Top-right
-    0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f,   // Apex
+    0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 0.0f,  // Bottom-right
+    0.5f, 0.5f, 0.0f, 0.0f, 0.0f, 0.0f,   // Top-right
+    0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f,   // Apex
 
     // Side 3
-    0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 0.0f,   // Top-right
-    -0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 0.0f,  // Top-left
-    0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f,   // Apex
+    0.5f, 0.5f, 0.0f, 0.0f, 0.0f, 0.0f,   // Top-right
+    -0.5f, 0.5f, 0.0f, 0.0f, 0.0f, 0.0f,  // Top-left
+    0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f,   // Apex
 
     // Side 4
-    -0.5f, 0.5f, 0.0f, -1.0f, 0.0f, 0.0f,   // Top-left
-    -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f,  // Bottom-left
-    0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f     // Apex
+    -0.5f, 0.5f, 0.0f, 0.0f, 0.0f, 0.0f,   // Top-left
+    -0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 0.0f,  // Bottom-left
+    0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f     // Apex
 };
 
-const float cuboidVertices[] = {
+constexpr float cuboidVertices[] = {
     // Front face
     -1.0f / 2, -2.0f / 2, -3.0f / 2, 0.0f, 0.0f, -1.0f, 1.0f / 2, -2.0f / 2, -3.0f / 2, 0.0f, 0.0f, -1.0f, 1.0f / 2,
     2.0f / 2, -3.0f / 2, 0.0f, 0.0f, -1.0f, 1.0f / 2, 2.0f / 2, -3.0f / 2, 0.0f, 0.0f, -1.0f, -1.0f / 2, 2.0f / 2,
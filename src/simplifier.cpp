@@ -0,0 +1,795 @@
+#include "simplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <queue>
+#include <vector>
+
+constexpr unsigned int NONE = ~0u;
+
+// Border edges get a plane perpendicular to their triangle, weighted above the surface planes so borders keep their
+// shape rather than shrinking.
+constexpr double BORDER_WEIGHT = 4.0;
+
+// What a position may collapse along.
+enum class VertexKind : uint8_t
+{
+    MANIFOLD,  // one vertex, interior: any edge
+    BORDER,    // one vertex on an open border: border edges
+    SEAM,      // several vertices meeting along one line of seam edges: seam edges, all vertices move together
+    LOCKED     // anything else, e.g. seam corners or non-manifold fans: never collapses
+};
+
+// Sum of squared distances to planes, p^T A p + 2 B.p + C, plus for every normal component k the attribute error
+// W n_k^2 - 2 n_k (G_k.p + D_k); the (G_k.p + D_k)^2 part of that is already folded into A, B and C.
+struct Quadric
+{
+    double A[6] = {};  // xx, yy, zz, xy, xz, yz
+    double B[3] = {};
+    double C = 0.0;
+    double Weight = 0.0;  // area of the planes, turns the sum into a mean squared distance
+
+    double G[3][3] = {};
+    double D[3] = {};
+    double W = 0.0;
+
+    void AddPlane(const double* n, const double d, const double weight)
+    {
+        addOuter(n, d, weight);
+        Weight += weight;
+    }
+
+    // Attribute k is value = g.p + d over a triangle of the given area.
+    void AddGradient(const int k, const double* g, const double d, const double weight)
+    {
+        addOuter(g, d, weight);
+        for (int i = 0; i < 3; i++)
+        {
+            G[k][i] += g[i] * weight;
+        }
+        D[k] += d * weight;
+    }
+
+    void operator+=(const Quadric& q)
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            A[i] += q.A[i];
+        }
+        for (int i = 0; i < 3; i++)
+        {
+            B[i] += q.B[i];
+            D[i] += q.D[i];
+            for (int j = 0; j < 3; j++)
+            {
+                G[i][j] += q.G[i][j];
+            }
+        }
+        C += q.C;
+        Weight += q.Weight;
+        W += q.W;
+    }
+
+    // Weighted sum of squares at position p with normal n, divide by Weight for the mean.
+    double Error(const double* p, const double* n) const
+    {
+        double e = A[0] * p[0] * p[0] + A[1] * p[1] * p[1] + A[2] * p[2] * p[2] +
+                   2.0 * (A[3] * p[0] * p[1] + A[4] * p[0] * p[2] + A[5] * p[1] * p[2]) +
+                   2.0 * (B[0] * p[0] + B[1] * p[1] + B[2] * p[2]) + C;
+        for (int k = 0; k < 3; k++)
+        {
+            e += W * n[k] * n[k] - 2.0 * n[k] * (G[k][0] * p[0] + G[k][1] * p[1] + G[k][2] * p[2] + D[k]);
+        }
+        return std::max(e, 0.0);
+    }
+
+   private:
+    // Adds (v.p + d)^2 * weight.
+    void addOuter(const double* v, const double d, const double weight)
+    {
+        A[0] += v[0] * v[0] * weight;
+        A[1] += v[1] * v[1] * weight;
+        A[2] += v[2] * v[2] * weight;
+        A[3] += v[0] * v[1] * weight;
+        A[4] += v[0] * v[2] * weight;
+        A[5] += v[1] * v[2] * weight;
+        for (int i = 0; i < 3; i++)
+        {
+            B[i] += v[i] * d * weight;
+        }
+        C += d * d * weight;
+    }
+};
+
+static void sub(const double* a, const double* b, double* out)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        out[i] = a[i] - b[i];
+    }
+}
+
+static double dot(const double* a, const double* b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+static void cross(const double* a, const double* b, double* out)
+{
+    out[0] = a[1] * b[2] - a[2] * b[1];
+    out[1] = a[2] * b[0] - a[0] * b[2];
+    out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+// Vertices are wedges of a position: every vertex with the same position and normal is welded into the first one,
+// and the remaining vertices at one position (the sides of a seam) form a circular list. Collapses move a whole
+// position into a neighboring one, every wedge of the source into the wedge of the target it shares an edge with.
+class Simplifier
+{
+   public:
+    Simplifier(const unsigned int* indices, const size_t indexCount, const Vertex* vertices, const size_t vertexCount,
+               const float normalWeight);
+
+    // Collapses until the triangle or error target is reached, returns the largest error as a distance.
+    double Run(const size_t targetTriangles, const double maxError);
+
+    size_t Write(unsigned int* destination) const;
+
+   private:
+    // Versions only grow, so the sum of both ends tells whether either changed since the entry was pushed. Ties,
+    // common on flat parts, go to the shorter edge; otherwise the queue keeps returning the edges of the last target
+    // and grows it into a star of slivers.
+    struct Collapse
+    {
+        float Cost;
+        float Length;  // squared
+        unsigned int From, To;  // positions
+        unsigned int Version;
+
+        bool operator>(const Collapse& other) const
+        {
+            return Cost != other.Cost ? Cost > other.Cost : Length > other.Length;
+        }
+    };
+
+    // A live triangle around a position seen from one of its other corners: the neighbor position, the wedge of the
+    // position the triangle is on and the wedge of the neighbor.
+    struct Corner
+    {
+        unsigned int Position;
+        unsigned int Wedge;
+        unsigned int Other;
+
+        bool operator<(const Corner& other) const
+        {
+            return Position != other.Position ? Position < other.Position : Wedge < other.Wedge;
+        }
+    };
+
+    // Neighbor position of a position, with the number of live triangles on the edge to it and whether those lie
+    // on different wedges. The triangles are corners[First, First + Triangles) until the next neighbors() call.
+    struct Edge
+    {
+        unsigned int Position;
+        unsigned int Triangles;
+        bool Seam;
+        unsigned int First;
+    };
+
+    size_t vertexCount;
+    std::vector<double> positions;  // xyz, scaled to the unit cube
+    std::vector<double> normals;    // xyz, times the normal weight
+
+    std::vector<unsigned int> canonical;  // first vertex with the same position and normal
+    std::vector<unsigned int> position;   // first vertex with the same position, names the position
+    std::vector<unsigned int> wedges;     // next canonical vertex at the same position
+
+    std::vector<unsigned int> triangles;  // canonical indices, rewritten by every collapse
+    std::vector<uint8_t> removed;
+    size_t triangleCount = 0;
+    std::vector<std::vector<unsigned int>> fans;  // live triangles around every canonical vertex
+
+    std::vector<Quadric> quadrics;  // per canonical vertex
+    std::vector<VertexKind> kinds;  // the rest per position
+    std::vector<unsigned int> versions;
+    std::vector<uint8_t> alive;
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+
+    // Scratch of neighbors() and isValid().
+    std::vector<Corner> corners;
+    std::vector<Edge> edges;
+    std::vector<Edge> targetEdges;
+
+    void weld(const Vertex* vertices);
+    void classify();
+    void buildQuadrics();
+
+    // Fills edges with the neighbors of position p, sorted by position.
+    void neighbors(const unsigned int p, std::vector<Edge>& edges);
+    // Wedge at position to that shares a triangle with the wedge v, NONE when there is none.
+    unsigned int target(const unsigned int v, const unsigned int to) const;
+
+    // Error of collapsing the position of edge's wedges into its neighbor, or the other way around when reverse is
+    // set; edge comes from the last neighbors() call. Infinite when a wedge has nowhere to go.
+    double cost(const Edge& edge, const bool reverse) const;
+    void push(const unsigned int p);
+    bool isValid(const unsigned int from, const unsigned int to);
+    void collapse(const unsigned int from, const unsigned int to);
+
+    bool onPosition(const unsigned int t, const unsigned int p) const
+    {
+        return position[triangles[t * 3]] == p || position[triangles[t * 3 + 1]] == p ||
+               position[triangles[t * 3 + 2]] == p;
+    }
+};
+
+Simplifier::Simplifier(const unsigned int* indices, const size_t indexCount, const Vertex* vertices,
+                       const size_t vertexCount, const float normalWeight)
+    : vertexCount(vertexCount), positions(vertexCount * 3), normals(vertexCount * 3)
+{
+    const auto bounds = computeBounds(vertices, vertexCount);
+    const auto size = bounds.max - bounds.min;
+    const float extent = std::max(size.x, std::max(size.y, size.z));
+    const double scale = extent > 0.0f ? 1.0 / extent : 1.0;
+
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            positions[v * 3 + k] = (vertices[v].Position[k] - bounds.min[k]) * scale;
+            normals[v * 3 + k] = static_cast<double>(vertices[v].Normal[k]) * normalWeight;
+        }
+    }
+
+    weld(vertices);
+
+    // Triangles that have no area in position space to begin with can't be kept consistent and are dropped.
+    triangles.reserve(indexCount);
+    for (size_t i = 0; i + 2 < indexCount; i += 3)
+    {
+        const unsigned int a = canonical[indices[i]], b = canonical[indices[i + 1]], c = canonical[indices[i + 2]];
+        if (position[a] != position[b] && position[b] != position[c] && position[a] != position[c])
+        {
+            triangles.insert(triangles.end(), {a, b, c});
+        }
+    }
+    triangleCount = triangles.size() / 3;
+    removed.assign(triangleCount, 0);
+
+    fans.resize(vertexCount);
+    for (size_t i = 0; i < triangles.size(); i++)
+    {
+        fans[triangles[i]].push_back(static_cast<unsigned int>(i / 3));
+    }
+
+    classify();
+    buildQuadrics();
+
+    versions.assign(vertexCount, 0);
+    alive.assign(vertexCount, 1);
+}
+
+void Simplifier::weld(const Vertex* vertices)
+{
+    std::vector<unsigned int> order(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        order[v] = static_cast<unsigned int>(v);
+    }
+
+    const auto positionLess = [&](const unsigned int a, const unsigned int b) {
+        const auto& pa = vertices[a].Position;
+        const auto& pb = vertices[b].Position;
+        return pa.x != pb.x ? pa.x < pb.x : pa.y != pb.y ? pa.y < pb.y : pa.z < pb.z;
+    };
+    const auto normalLess = [&](const unsigned int a, const unsigned int b) {
+        const auto& na = vertices[a].Normal;
+        const auto& nb = vertices[b].Normal;
+        return na.x != nb.x ? na.x < nb.x : na.y != nb.y ? na.y < nb.y : na.z < nb.z;
+    };
+    std::stable_sort(order.begin(), order.end(), [&](const unsigned int a, const unsigned int b) {
+        return positionLess(a, b) || (!positionLess(b, a) && normalLess(a, b));
+    });
+
+    // Runs of equal positions, and within them runs of equal normals. The stable sort keeps every run ascending, so
+    // the first vertex of a run is its lowest index.
+    canonical.resize(vertexCount);
+    position.resize(vertexCount);
+    wedges.resize(vertexCount);
+    for (size_t i = 0; i < vertexCount;)
+    {
+        size_t end = i + 1;
+        while (end < vertexCount && !positionLess(order[i], order[end]))
+        {
+            end++;
+        }
+
+        const auto first = *std::min_element(order.begin() + i, order.begin() + end);
+        unsigned int last = NONE, head = NONE;
+        for (size_t j = i; j < end; j++)
+        {
+            const auto v = order[j];
+            position[v] = first;
+            canonical[v] = j > i && !normalLess(order[j - 1], v) ? canonical[order[j - 1]] : v;
+            if (canonical[v] == v)
+            {
+                head = head == NONE ? v : head;
+                if (last != NONE)
+                {
+                    wedges[last] = v;
+                }
+                last = v;
+            }
+        }
+        wedges[last] = head;
+        i = end;
+    }
+}
+
+void Simplifier::neighbors(const unsigned int p, std::vector<Edge>& edges)
+{
+    corners.clear();
+    auto v = p;
+    do
+    {
+        for (const auto t : fans[v])
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                const auto u = triangles[t * 3 + k];
+                if (u != v)
+                {
+                    corners.push_back(Corner{position[u], v, u});
+                }
+            }
+        }
+        v = wedges[v];
+    } while (v != p);
+    std::sort(corners.begin(), corners.end());
+
+    edges.clear();
+    for (size_t i = 0; i < corners.size();)
+    {
+        size_t end = i + 1;
+        while (end < corners.size() && corners[end].Position == corners[i].Position)
+        {
+            end++;
+        }
+        edges.push_back(Edge{corners[i].Position, static_cast<unsigned int>(end - i),
+                             corners[i].Wedge != corners[end - 1].Wedge, static_cast<unsigned int>(i)});
+        i = end;
+    }
+}
+
+void Simplifier::classify()
+{
+    kinds.assign(vertexCount, VertexKind::MANIFOLD);
+
+    for (unsigned int p = 0; p < vertexCount; p++)
+    {
+        if (position[p] != p)
+        {
+            continue;
+        }
+
+        neighbors(p, edges);
+        size_t borderEdges = 0, seamEdges = 0, nonManifold = 0;
+        for (const auto& edge : edges)
+        {
+            borderEdges += edge.Triangles == 1;
+            seamEdges += edge.Triangles == 2 && edge.Seam;
+            nonManifold += edge.Triangles > 2;
+        }
+
+        auto& kind = kinds[p];
+        if (nonManifold > 0)
+        {
+            kind = VertexKind::LOCKED;
+        }
+        else if (wedges[p] == p)
+        {
+            kind = borderEdges > 0 ? VertexKind::BORDER : VertexKind::MANIFOLD;
+        }
+        else
+        {
+            kind = borderEdges == 0 && seamEdges == 2 ? VertexKind::SEAM : VertexKind::LOCKED;
+        }
+    }
+}
+
+void Simplifier::buildQuadrics()
+{
+    quadrics.assign(vertexCount, Quadric{});
+
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        const unsigned int* corners = &triangles[t * 3];
+        const double* p0 = &positions[corners[0] * 3];
+        const double* p1 = &positions[corners[1] * 3];
+        const double* p2 = &positions[corners[2] * 3];
+
+        double e1[3], e2[3], n[3];
+        sub(p1, p0, e1);
+        sub(p2, p0, e2);
+        cross(e1, e2, n);
+        const double length = std::sqrt(dot(n, n));
+        if (length == 0.0)
+        {
+            continue;
+        }
+        const double area = length * 0.5;
+        for (auto& c : n)
+        {
+            c /= length;
+        }
+
+        Quadric q;
+        q.AddPlane(n, -dot(n, p0), area);
+
+        // Gradient of every normal component over the triangle: g in the plane with g.e1 = a1 - a0, g.e2 = a2 - a0.
+        const double e11 = dot(e1, e1), e12 = dot(e1, e2), e22 = dot(e2, e2);
+        const double det = e11 * e22 - e12 * e12;
+        for (int k = 0; k < 3; k++)
+        {
+            const double a0 = normals[corners[0] * 3 + k];
+            const double da1 = normals[corners[1] * 3 + k] - a0;
+            const double da2 = normals[corners[2] * 3 + k] - a0;
+            const double x = (e22 * da1 - e12 * da2) / det;
+            const double y = (e11 * da2 - e12 * da1) / det;
+
+            double g[3];
+            for (int i = 0; i < 3; i++)
+            {
+                g[i] = e1[i] * x + e2[i] * y;
+            }
+            q.AddGradient(k, g, a0 - dot(g, p0), area);
+        }
+        q.W = area;
+
+        for (int k = 0; k < 3; k++)
+        {
+            quadrics[corners[k]] += q;
+        }
+
+        // Border edges, the ones no other triangle shares.
+        for (int k = 0; k < 3; k++)
+        {
+            const auto a = corners[k], b = corners[(k + 1) % 3];
+            bool shared = false;
+            auto v = a;
+            do
+            {
+                for (const auto other : fans[v])
+                {
+                    shared = shared || (other != t && onPosition(other, position[b]));
+                }
+                v = wedges[v];
+            } while (!shared && v != a);
+            if (shared)
+            {
+                continue;
+            }
+
+            double along[3], plane[3];
+            sub(&positions[b * 3], &positions[a * 3], along);
+            cross(along, n, plane);
+            const double planeLength = std::sqrt(dot(plane, plane));
+            if (planeLength == 0.0)
+            {
+                continue;
+            }
+            for (auto& c : plane)
+            {
+                c /= planeLength;
+            }
+
+            // Only pulls the border back, the error stays a mean over the surface area.
+            Quadric border;
+            border.AddPlane(plane, -dot(plane, &positions[a * 3]), dot(along, along) * BORDER_WEIGHT);
+            border.Weight = 0.0;
+            quadrics[a] += border;
+            quadrics[b] += border;
+        }
+    }
+}
+
+unsigned int Simplifier::target(const unsigned int v, const unsigned int to) const
+{
+    for (const auto t : fans[v])
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            if (position[triangles[t * 3 + k]] == to)
+            {
+                return triangles[t * 3 + k];
+            }
+        }
+    }
+    return NONE;
+}
+
+double Simplifier::cost(const Edge& edge, const bool reverse) const
+{
+    const auto* begin = &corners[edge.First];
+    const auto* end = begin + edge.Triangles;
+    const auto from = reverse ? edge.Position : position[begin->Wedge];
+    const auto to = reverse ? position[begin->Wedge] : edge.Position;
+
+    // Every wedge of the source goes to the target wedge of a triangle on the edge, the only ones they share.
+    double error = 0.0, weight = 0.0;
+    const double* p = &positions[to * 3];
+    auto v = from;
+    do
+    {
+        unsigned int w = NONE;
+        for (const auto* c = begin; c != end && w == NONE; ++c)
+        {
+            w = (reverse ? c->Other : c->Wedge) == v ? (reverse ? c->Wedge : c->Other) : NONE;
+        }
+        if (w == NONE)
+        {
+            return std::numeric_limits<double>::infinity();
+        }
+        error += quadrics[v].Error(p, &normals[w * 3]);
+        weight += quadrics[v].Weight;
+        v = wedges[v];
+    } while (v != from);
+
+    // What the target has accumulated so far counts too, so the error of a collapse is absolute.
+    auto w = to;
+    do
+    {
+        error += quadrics[w].Error(p, &normals[w * 3]);
+        weight += quadrics[w].Weight;
+        w = wedges[w];
+    } while (w != to);
+
+    return error / std::max(weight, 1e-12);
+}
+
+void Simplifier::push(const unsigned int p)
+{
+    neighbors(p, edges);
+    for (const auto& edge : edges)
+    {
+        const auto q = edge.Position;
+
+        // The cheaper of the directions the source may move in.
+        Collapse best{std::numeric_limits<float>::infinity(), 0.0f, NONE, NONE, 0};
+        for (const bool reverse : {false, true})
+        {
+            const auto from = reverse ? q : p, to = reverse ? p : q;
+            bool allowed = false;
+            switch (kinds[from])
+            {
+            case VertexKind::MANIFOLD:
+                allowed = true;
+                break;
+            case VertexKind::BORDER:
+                allowed = edge.Triangles == 1 && kinds[to] != VertexKind::MANIFOLD;
+                break;
+            case VertexKind::SEAM:
+                allowed = edge.Triangles == 2 && edge.Seam && kinds[to] != VertexKind::MANIFOLD &&
+                          kinds[to] != VertexKind::BORDER;
+                break;
+            case VertexKind::LOCKED:
+                break;
+            }
+            const auto c = allowed ? static_cast<float>(cost(edge, reverse)) : best.Cost;
+            if (c < best.Cost)
+            {
+                best = Collapse{c, 0.0f, from, to, versions[from] + versions[to]};
+            }
+        }
+        if (best.From != NONE)
+        {
+            double along[3];
+            sub(&positions[q * 3], &positions[p * 3], along);
+            best.Length = static_cast<float>(dot(along, along));
+            queue.push(best);
+        }
+    }
+}
+
+bool Simplifier::isValid(const unsigned int from, const unsigned int to)
+{
+    // Link condition: the ends share exactly the neighbors of the triangles on the edge, otherwise the collapse
+    // pinches the surface.
+    neighbors(to, targetEdges);
+    neighbors(from, edges);
+
+    size_t shared = 0, edgeTriangles = 0;
+    auto other = targetEdges.begin();
+    for (const auto& edge : edges)
+    {
+        if (edge.Position == to)
+        {
+            edgeTriangles = edge.Triangles;
+            continue;
+        }
+        while (other != targetEdges.end() && other->Position < edge.Position)
+        {
+            ++other;
+        }
+        shared += other != targetEdges.end() && other->Position == edge.Position;
+    }
+    if (edgeTriangles == 0 || shared != edgeTriangles)
+    {
+        return false;
+    }
+
+    // No triangle that stays may turn over or turn by more than about 75 degrees, which also rules out making it
+    // collinear; the test against zero alone lets triangles collapse to slivers along flat faces.
+    const double* destination = &positions[to * 3];
+    auto v = from;
+    do
+    {
+        for (const auto t : fans[v])
+        {
+            if (onPosition(t, to))
+            {
+                continue;
+            }
+
+            const double* before[3];
+            const double* after[3];
+            for (int k = 0; k < 3; k++)
+            {
+                before[k] = &positions[triangles[t * 3 + k] * 3];
+                after[k] = triangles[t * 3 + k] == v ? destination : before[k];
+            }
+
+            double e1[3], e2[3], n0[3], n1[3];
+            sub(before[1], before[0], e1);
+            sub(before[2], before[0], e2);
+            cross(e1, e2, n0);
+            sub(after[1], after[0], e1);
+            sub(after[2], after[0], e2);
+            cross(e1, e2, n1);
+            if (dot(n0, n1) <= 0.25 * std::sqrt(dot(n0, n0) * dot(n1, n1)))
+            {
+                return false;
+            }
+        }
+        v = wedges[v];
+    } while (v != from);
+    return true;
+}
+
+void Simplifier::collapse(const unsigned int from, const unsigned int to)
+{
+    auto v = from;
+    do
+    {
+        const auto w = target(v, to);
+        for (const auto t : fans[v])
+        {
+            if (onPosition(t, to))
+            {
+                removed[t] = 1;
+                triangleCount--;
+                continue;
+            }
+            for (int k = 0; k < 3; k++)
+            {
+                triangles[t * 3 + k] = triangles[t * 3 + k] == v ? w : triangles[t * 3 + k];
+            }
+            fans[w].push_back(t);
+        }
+        quadrics[w] += quadrics[v];
+        fans[v] = std::vector<unsigned int>{};
+        v = wedges[v];
+    } while (v != from);
+
+    // The removed triangles also sit in the fans of the other positions around the source.
+    for (const auto& edge : edges)
+    {
+        auto u = edge.Position;
+        do
+        {
+            auto& fan = fans[u];
+            fan.erase(std::remove_if(fan.begin(), fan.end(), [this](const unsigned int t) { return removed[t]; }),
+                      fan.end());
+            u = wedges[u];
+        } while (u != edge.Position);
+    }
+
+    alive[from] = 0;
+    versions[to]++;
+}
+
+double Simplifier::Run(const size_t targetTriangles, const double maxError)
+{
+    for (unsigned int p = 0; p < vertexCount; p++)
+    {
+        if (position[p] == p && kinds[p] != VertexKind::LOCKED)
+        {
+            push(p);
+        }
+    }
+
+    double error = 0.0;
+    const double maxCost = maxError * maxError;
+    while (triangleCount > targetTriangles && !queue.empty())
+    {
+        const auto c = queue.top();
+        queue.pop();
+
+        if (!alive[c.From] || !alive[c.To] || versions[c.From] + versions[c.To] != c.Version)
+        {
+            continue;
+        }
+        if (c.Cost > maxCost)
+        {
+            break;
+        }
+        // isValid() leaves the neighbors of the source in edges for collapse().
+        if (!isValid(c.From, c.To))
+        {
+            continue;
+        }
+
+        collapse(c.From, c.To);
+        error = std::max(error, static_cast<double>(c.Cost));
+
+        // Every collapse around the target changes cost, its neighbors get new entries through their edge to it.
+        push(c.To);
+    }
+    return std::sqrt(error);
+}
+
+size_t Simplifier::Write(unsigned int* destination) const
+{
+    size_t n = 0;
+    for (size_t t = 0; t < removed.size(); t++)
+    {
+        if (!removed[t])
+        {
+            std::memcpy(destination + n, &triangles[t * 3], 3 * sizeof(unsigned int));
+            n += 3;
+        }
+    }
+    return n;
+}
+
+size_t simplifyMesh(const unsigned int* indices, const size_t indexCount, const Vertex* vertices,
+                    const size_t vertexCount, const size_t targetIndexCount, const float targetError,
+                    unsigned int* destination, float* resultError, const float normalWeight)
+{
+    if (vertexCount == 0 || indexCount < 3)
+    {
+        if (resultError != nullptr)
+        {
+            *resultError = 0.0f;
+        }
+        return 0;
+    }
+
+    Simplifier simplifier{indices, indexCount, vertices, vertexCount, normalWeight};
+    const double error = simplifier.Run(targetIndexCount / 3, targetError);
+    if (resultError != nullptr)
+    {
+        *resultError = static_cast<float>(error);
+    }
+    return simplifier.Write(destination);
+}
+
+Mesh simplifyMesh(const Mesh& mesh, const size_t targetIndexCount, const float targetError, float* resultError)
+{
+    Mesh result;
+    result.Indices.resize(mesh.Indices.size());
+    result.Indices.resize(simplifyMesh(mesh.Indices.data(), mesh.Indices.size(), mesh.Vertices.data(),
+                                       mesh.Vertices.size(), targetIndexCount, targetError, result.Indices.data(),
+                                       resultError));
+
+    std::vector<unsigned int> remap(mesh.Vertices.size(), NONE);
+    for (auto& index : result.Indices)
+    {
+        if (remap[index] == NONE)
+        {
+            remap[index] = static_cast<unsigned int>(result.Vertices.size());
+            result.Vertices.push_back(mesh.Vertices[index]);
+        }
+        index = remap[index];
+    }
+    return result;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "mesh.h"
+
+/////////////////////////// Mesh simplification /////////////////
+// Quadric error edge collapse (Garland and Heckbert), with the normals in the quadrics as linear attributes over
+// every triangle (Hoppe, "New quadric metric for simplifying meshes with appearance attributes"). Collapses are
+// taken cheapest first from a priority queue, each vertex collapses into one of its neighbors, so the result is a
+// new index list over the original vertices.
+//
+// Open borders only collapse along themselves and vertices on attribute seams (one position with several normals,
+// like the edges of a cube) are kept, so neither holes nor cracks open up. Collapses that would flip a triangle or
+// make the surface non-manifold are skipped.
+
+// Bump whenever simplifyMesh() output changes, it is part of the cache key of imported meshes.
+constexpr uint32_t SIMPLIFIER_VERSION = 2;
+
+// How much the normals count against the positions: the error of a normal off by a unit vector equals that of a
+// position off by this fraction of the mesh size.
+constexpr float SIMPLIFY_NORMAL_WEIGHT = 0.5f;
+
+// Writes at most indexCount indices to destination and returns how many. Stops at targetIndexCount or when the next
+// collapse would move the surface by more than targetError, relative to the largest extent of the mesh (0.01 is
+// 1%). resultError, when not null, receives the largest error in the same units.
+size_t simplifyMesh(const unsigned int* indices, const size_t indexCount, const Vertex* vertices,
+                    const size_t vertexCount, const size_t targetIndexCount, const float targetError,
+                    unsigned int* destination, float* resultError = nullptr,
+                    const float normalWeight = SIMPLIFY_NORMAL_WEIGHT);
+
+// Same as above with the vertices a simplified mesh no longer references removed.
+Mesh simplifyMesh(const Mesh& mesh, const size_t targetIndexCount, const float targetError,
+                  float* resultError = nullptr);
+////////////////////////////////////////////////////////////////
@@ -0,0 +1,147 @@
+#include "streaming_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+// GL 4.4, not in the 3.3 loader.
+constexpr GLbitfield MAP_PERSISTENT_BIT = 0x0040;
+constexpr GLbitfield MAP_COHERENT_BIT = 0x0080;
+
+typedef void(APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+static PFNGLBUFFERSTORAGEPROC bufferStorage = nullptr;
+
+bool loadStreamingFunctions(GLADloadproc load)
+{
+    bool supported = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 4);
+    if (!supported)
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count && !supported; i++)
+        {
+            supported = std::strcmp(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)),
+                                    "GL_ARB_buffer_storage") == 0;
+        }
+    }
+
+    bufferStorage = supported ? reinterpret_cast<PFNGLBUFFERSTORAGEPROC>(load("glBufferStorage")) : nullptr;
+    return bufferStorage != nullptr;
+}
+
+StreamingBuffer::StreamingBuffer(const size_t frameBytes) : frameBytes(frameBytes) { allocate(); }
+
+StreamingBuffer::~StreamingBuffer() { release(); }
+
+size_t StreamingBuffer::Write(const void* data, const size_t bytes, const size_t alignment)
+{
+    const auto align = [alignment](const size_t o) { return (o + alignment - 1) / alignment * alignment; };
+    if (bytes == 0)
+    {
+        return align(offset);
+    }
+    Reserve(align(offset) - offset + bytes);
+    const size_t start = align(offset);
+    offset = start + bytes;
+
+    if (mapping != nullptr)
+    {
+        std::memcpy(mapping + frame * frameBytes + start, data, bytes);
+        return frame * frameBytes + start;
+    }
+
+    // Nothing has read this space since the storage was last orphaned, so the write needs no synchronization.
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    void* target = glMapBufferRange(GL_COPY_WRITE_BUFFER, start, bytes,
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    std::memcpy(target, data, bytes);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    return start;
+}
+
+void StreamingBuffer::Reserve(const size_t bytes)
+{
+    // Without persistence the whole buffer is one ring.
+    const size_t space = mapping != nullptr ? frameBytes : frameBytes * STREAMING_FRAMES;
+    if (offset + bytes <= space)
+    {
+        return;
+    }
+
+    offset = 0;
+    if (mapping != nullptr)
+    {
+        // Draws earlier in the frame keep the old buffer alive until they are done with it.
+        frameBytes = std::max(frameBytes * 2, bytes);
+        release();
+        allocate();
+        return;
+    }
+
+    // Orphaning hands the old storage to the draws still reading it, the new one is all free.
+    if (bytes > space)
+    {
+        frameBytes = std::max(frameBytes * 2, bytes);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, frameBytes * STREAMING_FRAMES, nullptr, GL_STREAM_DRAW);
+}
+
+void StreamingBuffer::EndFrame()
+{
+    if (mapping == nullptr)
+    {
+        return;
+    }
+
+    fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frame = (frame + 1) % STREAMING_FRAMES;
+    offset = 0;
+
+    // The GPU is normally done with a part two frames later; waiting here means it is a whole ring behind.
+    if (fences[frame] != nullptr)
+    {
+        while (glClientWaitSync(fences[frame], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+        {
+        }
+        glDeleteSync(fences[frame]);
+        fences[frame] = nullptr;
+    }
+}
+
+void StreamingBuffer::allocate()
+{
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+
+    const size_t capacity = frameBytes * STREAMING_FRAMES;
+    if (bufferStorage != nullptr)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | MAP_PERSISTENT_BIT | MAP_COHERENT_BIT;
+        bufferStorage(GL_COPY_WRITE_BUFFER, capacity, nullptr, flags);
+        mapping = static_cast<char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, capacity, flags));
+    }
+    else
+    {
+        glBufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+    }
+}
+
+void StreamingBuffer::release()
+{
+    for (auto& fence : fences)
+    {
+        if (fence != nullptr)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (mapping != nullptr)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        mapping = nullptr;
+    }
+    glDeleteBuffers(1, &buffer);
+    buffer = 0;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+/////////////////////////// Streaming buffer ////////////////////
+// Ring buffer for data rewritten every frame: instance matrices, gizmos, debug lines. Write() copies into the
+// current frame's part of the ring and returns the byte offset to point attributes at; EndFrame() fences that part
+// and moves on to the next. Nothing is reallocated in the steady state.
+//
+// With GL 4.4 or ARB_buffer_storage (see loadStreamingFunctions()) the buffer is immutable storage mapped once,
+// persistently and coherently, and split into STREAMING_FRAMES parts: the CPU writes one while the GPU reads the
+// others, and only waits on a fence if it gets a whole ring ahead. Without it, writes go through
+// glMapBufferRange() with GL_MAP_UNSYNCHRONIZED_BIT into space no draw has used yet, and the storage is orphaned
+// when the ring wraps.
+//
+// A frame that needs more than its part grows the ring, which is the only reallocation. The names aren't pooled:
+// immutable storage can't be given to another owner.
+constexpr int STREAMING_FRAMES = 3;
+
+// Looks up glBufferStorage() if the context has it, after gladLoadGLLoader(). Returns true when streaming buffers
+// can use persistent mapping.
+bool loadStreamingFunctions(GLADloadproc load);
+
+class StreamingBuffer
+{
+   public:
+    // frameBytes is the space one frame is expected to use.
+    explicit StreamingBuffer(const size_t frameBytes);
+    ~StreamingBuffer();
+
+    // The mapping and the attribute pointers set up from Get() stay with the object.
+    StreamingBuffer(const StreamingBuffer&) = delete;
+    StreamingBuffer& operator=(const StreamingBuffer&) = delete;
+
+    // Offset of the copy in the buffer, a multiple of alignment. The buffer may change when a frame outgrows its
+    // part, so bind Get() after writing.
+    size_t Write(const void* data, const size_t bytes, const size_t alignment = 16);
+
+    // Makes room for bytes, alignment padding included, so the writes that follow stay in one buffer; Write()
+    // alone may replace it between two writes that one draw reads.
+    void Reserve(const size_t bytes);
+
+    // After the frame's last draw reading the buffer.
+    void EndFrame();
+
+    unsigned int Get() const { return buffer; }
+    bool IsPersistent() const { return mapping != nullptr; }
+    size_t GetFrameBytes() const { return frameBytes; }
+
+   private:
+    GLuint buffer = 0;
+    size_t frameBytes;
+    char* mapping = nullptr;  // persistent mode only
+
+    int frame = 0;
+    size_t offset = 0;  // next free byte of the current frame's part, or of the whole buffer without persistence
+    GLsync fences[STREAMING_FRAMES] = {};
+
+    void allocate();
+    void release();
+};
+////////////////////////////////////////////////////////////////
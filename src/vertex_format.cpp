@@ -0,0 +1,116 @@
+#include "vertex_format.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "parallel.h"
+
+// Vertices per thread, encoding is cheap so ranges have to be large to pay for the thread.
+constexpr size_t ENCODE_RANGE = 1 << 16;
+
+static float signNotZero(const float v) { return v >= 0.0f ? 1.0f : -1.0f; }
+
+// Rounds v in [-1, 1] to the nearest of -max..max. Rounding half away from zero by hand, std::lround() is a library
+// call that dominates the encoding loops.
+template <typename T>
+static T quantize(const float v, const float max)
+{
+    const float scaled = std::min(std::max(v, -1.0f), 1.0f) * max;
+    return static_cast<T>(scaled + (scaled >= 0.0f ? 0.5f : -0.5f));
+}
+
+size_t vertexSize(const VertexFormat format)
+{
+    switch (format)
+    {
+    case VertexFormat::FLOAT:
+        return sizeof(Vertex);
+    case VertexFormat::QUANTIZED:
+        return sizeof(QuantizedVertex);
+    case VertexFormat::COMPACT:
+        return sizeof(CompactVertex);
+    }
+    return sizeof(Vertex);
+}
+
+PositionDecode positionDecode(const AABB& bounds)
+{
+    return PositionDecode{bounds.extents() / 32767.0f, bounds.center()};
+}
+
+vec2 encodeOctahedral(const vec3& n)
+{
+    const float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    if (l1 == 0.0f)
+    {
+        return vec2{0.0f, 0.0f};
+    }
+
+    const vec2 p{n.x / l1, n.y / l1};
+    if (n.z >= 0.0f)
+    {
+        return p;
+    }
+    return vec2{(1.0f - std::abs(p.y)) * signNotZero(p.x), (1.0f - std::abs(p.x)) * signNotZero(p.y)};
+}
+
+vec3 decodeOctahedral(const vec2& e)
+{
+    vec3 n{e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y)};
+    const float t = std::max(-n.z, 0.0f);
+    n.x -= t * signNotZero(n.x);
+    n.y -= t * signNotZero(n.y);
+    return n.normalize();
+}
+
+void encodeVertices(const VertexFormat format, const PositionDecode& decode, const Vertex* in, const size_t n,
+                    void* out)
+{
+    if (format == VertexFormat::FLOAT)
+    {
+        std::copy(in, in + n, static_cast<Vertex*>(out));
+        return;
+    }
+
+    // Flat axes have no extent, every position on them maps to 0.
+    vec3 inverseScale{0.0f};
+    for (int k = 0; k < 3; k++)
+    {
+        inverseScale[k] = decode.Scale[k] > 0.0f ? 1.0f / (decode.Scale[k] * 32767.0f) : 0.0f;
+    }
+
+    const auto encodePosition = [&](const vec3& p, int16_t* position) {
+        for (int k = 0; k < 3; k++)
+        {
+            position[k] = quantize<int16_t>((p[k] - decode.Offset[k]) * inverseScale[k], 32767.0f);
+        }
+    };
+
+    parallelFor(n, ENCODE_RANGE, [&](const size_t begin, const size_t end) {
+        if (format == VertexFormat::QUANTIZED)
+        {
+            auto* vertices = static_cast<QuantizedVertex*>(out);
+            for (size_t i = begin; i < end; i++)
+            {
+                encodePosition(in[i].Position, vertices[i].Position);
+                vertices[i].Position[3] = 0;
+
+                const auto e = encodeOctahedral(in[i].Normal);
+                vertices[i].Normal[0] = quantize<int16_t>(e.x, 32767.0f);
+                vertices[i].Normal[1] = quantize<int16_t>(e.y, 32767.0f);
+            }
+        }
+        else
+        {
+            auto* vertices = static_cast<CompactVertex*>(out);
+            for (size_t i = begin; i < end; i++)
+            {
+                encodePosition(in[i].Position, vertices[i].Position);
+
+                const auto e = encodeOctahedral(in[i].Normal);
+                vertices[i].Normal[0] = quantize<int8_t>(e.x, 127.0f);
+                vertices[i].Normal[1] = quantize<int8_t>(e.y, 127.0f);
+            }
+        }
+    });
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "math.h"
+#include "mesh.h"
+
+/////////////////////////// Vertex formats //////////////////////
+// GPU layouts of a Vertex. Meshes are built, cached and optimized as float Vertex data and encoded into the layout
+// of their GeometryBuffer on upload:
+//
+//   FLOAT      24 bytes, the Vertex struct as is.
+//   QUANTIZED  12 bytes, QuantizedVertex: 16-bit positions within the mesh bounds, octahedral normal in 2 x 16 bits.
+//   COMPACT     8 bytes, CompactVertex: 16-bit positions, octahedral normal in 2 x 8 bits (about 1 degree error).
+//
+// Quantized positions are fed to the vertex shader as plain integers and restored with position * positionScale +
+// positionOffset, see PositionDecode. Octahedral normals are fed as normalized values in [-1, 1] and unfolded by the
+// shader's decodeNormal() when octahedralNormals is set.
+enum class VertexFormat
+{
+    FLOAT,
+    QUANTIZED,
+    COMPACT
+};
+
+struct QuantizedVertex
+{
+    int16_t Position[4];  // w is padding, keeps the normal 4-byte aligned
+    int16_t Normal[2];
+};
+
+struct CompactVertex
+{
+    int16_t Position[3];
+    int8_t Normal[2];
+};
+
+// Bytes per vertex in the format.
+size_t vertexSize(const VertexFormat format);
+
+// Maps stored positions back to object space. The identity for FLOAT.
+struct PositionDecode
+{
+    vec3 Scale{1.0f};
+    vec3 Offset{0.0f};
+};
+
+// Decode for 16-bit positions spanning bounds, the center maps to 0 and the faces to +-32767.
+PositionDecode positionDecode(const AABB& bounds);
+
+// Writes n vertices in format to out, vertexSize(format) bytes each; positions are quantized for decode, which is
+// ignored for FLOAT. Large inputs are split across threads.
+void encodeVertices(const VertexFormat format, const PositionDecode& decode, const Vertex* in, const size_t n,
+                    void* out);
+
+// Unit vector to a point of the [-1, 1] square: the octahedron |x| + |y| + |z| = 1 is projected onto the xy plane and
+// its lower half folded over the diagonals.
+vec2 encodeOctahedral(const vec3& n);
+// Inverse of encodeOctahedral(), the result is normalized.
+vec3 decodeOctahedral(const vec2& e);
+////////////////////////////////////////////////////////////////